@@ -0,0 +1,94 @@
+#pragma once
+
+#include "FastTrig.h"
+
+#include <glm/glm.hpp>
+
+/* 2D affine transform in 6 floats, the 2x3 [x y t] of a mat3x2: p' = x p.x +
+   y p.y + t. The pieces only ever move in the plane, so this carries all of
+   a piece's mat4 in less arithmetic: a product is 12 multiplies against 64,
+   though --bench affine measures composing R2 * T * R * S at about 3x the
+   speed of mat4, and building a piece with trs() at 1.5-2x. A drawn
+   instance (AffineInstance: linear part, offset with depth, RGBA8 color) is
+   32 bytes against the 80 of a mat4 and a vec4 color. */
+struct Affine2D {
+	glm::vec2 x = glm::vec2(1.0f, 0.0f);	// image of the unit x axis
+	glm::vec2 y = glm::vec2(0.0f, 1.0f);	// image of the unit y axis
+	glm::vec2 t = glm::vec2(0.0f, 0.0f);	// translation
+
+	static Affine2D translation(glm::vec2 offset) {
+		Affine2D a;
+		a.t = offset;
+		return a;
+	}
+	/* Rotation by the angle with these sine and cosine. */
+	static Affine2D rotation(float s, float c) {
+		Affine2D a;
+		a.x = glm::vec2(c, s);
+		a.y = glm::vec2(-s, c);
+		return a;
+	}
+	static Affine2D scaling(glm::vec2 scale) {
+		Affine2D a;
+		a.x = glm::vec2(scale.x, 0.0f);
+		a.y = glm::vec2(0.0f, scale.y);
+		return a;
+	}
+	/* T * R * S in closed form: one sincos, four multiplies. */
+	template <typename Trig = Transform_trig>
+	static Affine2D trs(glm::vec2 scale, float rads, glm::vec2 offset) {
+		float s, c;
+		Trig::sincos(rads, s, c);
+		Affine2D a;
+		a.x = glm::vec2(c * scale.x, s * scale.x);
+		a.y = glm::vec2(-s * scale.y, c * scale.y);
+		a.t = offset;
+		return a;
+	}
+
+	/* this after b: (this * b).apply(p) == apply(b.apply(p)). */
+	Affine2D operator*(const Affine2D& b) const {
+		Affine2D a;
+		a.x = x * b.x.x + y * b.x.y;
+		a.y = x * b.y.x + y * b.y.y;
+		a.t = x * b.t.x + y * b.t.y + t;
+		return a;
+	}
+
+	glm::vec2 apply(glm::vec2 p) const { return x * p.x + y * p.y + t; }
+	glm::vec2 applyVector(glm::vec2 v) const { return x * v.x + y * v.y; }
+	float determinant() const { return x.x * y.y - y.x * x.y; }
+
+	/* Like glm::inverse, not defined for a singular transform (zero scale). */
+	Affine2D inverse() const {
+		const float inv = 1.0f / determinant();
+		Affine2D a;
+		a.x = glm::vec2(y.y, -x.y) * inv;
+		a.y = glm::vec2(-y.x, x.x) * inv;
+		a.t = -(a.x * t.x + a.y * t.y);
+		return a;
+	}
+
+	/* The same transform as a clip-space mat4 at depth z. */
+	glm::mat4 toMat4(float z = 0.0f) const {
+		return glm::mat4(
+			glm::vec4(x, 0.0f, 0.0f),
+			glm::vec4(y, 0.0f, 0.0f),
+			glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+			glm::vec4(t, z, 1.0f));
+	}
+};
+
+/* The fixed tilt of the whole figure (R2 in ShapeRenderer::applyTransform). */
+constexpr float TiltDegrees = 15.0f;
+constexpr float TiltCos = 0.965925826289068287f;	// cos(15 degrees)
+constexpr float TiltSin = 0.258819045102520762f;	// sin(15 degrees)
+
+/* A piece's R2 * T * R * S. The tilt is a rotation about z like R, so this
+   is T' * R'' * S with R'' the rotation by rotation + 15 degrees and T' the
+   translation by R2 t: one sincos per piece. */
+template <typename Trig = Transform_trig>
+inline Affine2D pieceAffine(glm::vec2 scale, float rotation, glm::vec2 translate) {
+	const glm::vec2 tilted(TiltCos * translate.x - TiltSin * translate.y, TiltSin * translate.x + TiltCos * translate.y);
+	return Affine2D::trs<Trig>(scale, rotation + glm::radians(TiltDegrees), tilted);
+}
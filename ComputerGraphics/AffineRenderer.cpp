@@ -0,0 +1,118 @@
+#include "AffineRenderer.h"
+#include "Color.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cstddef>
+
+const char* transformPathName(TransformPath path) {
+	switch (path) {
+	case TransformPath::Matrix:
+		return "matrix";
+	case TransformPath::Affine:
+		return "affine";
+	case TransformPath::Parameters:
+		return "parameters";
+	default:
+		return "unknown";
+	}
+}
+
+/* Must match the Indices uploaded in main.cpp and the shape renderers. */
+struct ShapeDraw {
+	GLenum mode;
+	GLsizei count;
+	size_t offset;
+};
+
+static const ShapeDraw ShapeDraws[] = {
+	{ GL_TRIANGLES, 3, 0 },			// Triangle
+	{ GL_TRIANGLE_STRIP, 4, 3 },	// Square
+	{ GL_TRIANGLE_STRIP, 4, 7 },	// Parallelogram
+};
+
+static const GLuint LINEAR = 2, OFFSET = 3, INSTANCE_COLOR = 4;
+
+void AffineRenderer::create(GLuint vao) {
+	Shaders = std::make_unique<mgl::ShaderProgram>();
+	Shaders->addShader(GL_VERTEX_SHADER, "clip-affine-vs.glsl");
+	Shaders->addShader(GL_FRAGMENT_SHADER, "clip-fs.glsl");
+	Shaders->addAttribute(mgl::POSITION_ATTRIBUTE, 0);
+	Shaders->addAttribute("inLinear", LINEAR);
+	Shaders->addAttribute("inOffset", OFFSET);
+	Shaders->addAttribute("inInstanceColor", INSTANCE_COLOR);
+	Shaders->create();
+
+	Instances.create(4096 * sizeof(AffineInstance));
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, Instances.getBuffer());
+	glEnableVertexAttribArray(LINEAR);
+	glVertexAttribPointer(LINEAR, 4, GL_FLOAT, GL_FALSE, sizeof(AffineInstance),
+		reinterpret_cast<GLvoid*>(offsetof(AffineInstance, Linear)));
+	glVertexAttribDivisor(LINEAR, 1);
+	glEnableVertexAttribArray(OFFSET);
+	glVertexAttribPointer(OFFSET, 3, GL_FLOAT, GL_FALSE, sizeof(AffineInstance),
+		reinterpret_cast<GLvoid*>(offsetof(AffineInstance, Offset)));
+	glVertexAttribDivisor(OFFSET, 1);
+	glEnableVertexAttribArray(INSTANCE_COLOR);
+	glVertexAttribPointer(INSTANCE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(AffineInstance),
+		reinterpret_cast<GLvoid*>(offsetof(AffineInstance, Color)));
+	glVertexAttribDivisor(INSTANCE_COLOR, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void packColor(glm::vec4 color, GLubyte out[4]) {
+	for (int c = 0; c < 4; c++) out[c] = static_cast<GLubyte>(std::clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+void fillAffineInstances(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+	size_t count, int32_t selected, AffineInstance* out) {
+	parallelFor(0, count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const uint32_t index = first[i];
+			const ShapeInstance& shape = shapes[index];
+			const Affine2D m = pieceAffine(shape.scale, shape.rotation, glm::vec2(shape.translate));
+			AffineInstance& instance = out[i];
+			instance.Linear[0] = m.x.x; instance.Linear[1] = m.x.y;
+			instance.Linear[2] = m.y.x; instance.Linear[3] = m.y.y;
+			instance.Offset[0] = m.t.x; instance.Offset[1] = m.t.y; instance.Offset[2] = shape.translate.z;
+			packColor(static_cast<int32_t>(index) == selected ? Color::White : shape.color, instance.Color);
+		}
+	}, 16384);
+}
+
+void drawShapeInstances(ShapeType type, GLsizei instances, GLuint baseInstance) {
+	const ShapeDraw& shape = ShapeDraws[static_cast<int>(type)];
+	glDrawElementsInstancedBaseInstance(shape.mode, shape.count, GL_UNSIGNED_BYTE,
+		reinterpret_cast<GLvoid*>(shape.offset), instances, baseInstance);
+}
+
+void drawShapeRuns(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first, size_t count,
+	int copies) {
+	for (size_t run = 0; run < count;) {
+		const ShapeType type = shapes[first[run]].type;
+		size_t end = run + 1;
+		while (end < count && shapes[first[end]].type == type) end++;
+		drawShapeInstances(type, static_cast<GLsizei>((end - run) * copies), static_cast<GLuint>(run));
+		run = end;
+	}
+}
+
+void AffineRenderer::draw(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+	std::vector<uint32_t>::const_iterator last, int32_t selected) {
+	const size_t count = static_cast<size_t>(last - first);
+	if (count == 0) return;
+	/* Straight into this frame's region of the mapped stream; the engine's
+	   frame fences keep the GPU off it. */
+	GLintptr offset;
+	AffineInstance* instances = static_cast<AffineInstance*>(Instances.allocate(count * sizeof(AffineInstance), offset));
+	fillAffineInstances(shapes, first, count, selected, instances);
+	glBindVertexBuffer(LINEAR, Instances.getBuffer(), offset + offsetof(AffineInstance, Linear), sizeof(AffineInstance));
+	glBindVertexBuffer(OFFSET, Instances.getBuffer(), offset + offsetof(AffineInstance, Offset), sizeof(AffineInstance));
+	glBindVertexBuffer(INSTANCE_COLOR, Instances.getBuffer(), offset + offsetof(AffineInstance, Color), sizeof(AffineInstance));
+
+	Shaders->bind();
+	drawShapeRuns(shapes, first, count);
+	Shaders->unbind();
+}
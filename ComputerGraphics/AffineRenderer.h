@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <mgl.hpp>
+
+#include "Affine2D.h"
+#include "Scene.h"
+
+/* How piece transforms reach the vertex shader. */
+enum class TransformPath {
+	Matrix,		// mat4 and color uniforms per draw (clip-vs.glsl)
+	Affine,		// Affine2D instance attributes, one draw per run of equal shapes (clip-affine-vs.glsl)
+	Parameters,	// raw scale, rotation and translate per instance; the GPU builds the transform (clip-params-vs.glsl)
+	Count
+};
+
+const char* transformPathName(TransformPath path);
+
+/* One instance of the affine path: 32 bytes, against the 80 of the mat4 and
+   vec4 uniforms of the matrix path. */
+struct AffineInstance {
+	GLfloat Linear[4];	// x and y columns
+	GLfloat Offset[3];	// translation and depth
+	GLubyte Color[4];	// RGBA8
+};
+
+/* Writes the instances of shapes[*first] .. shapes[*(first + count - 1)]. */
+void fillAffineInstances(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+	size_t count, int32_t selected, AffineInstance* out);
+
+/* Color as RGBA8, for normalized unsigned byte attributes. */
+void packColor(glm::vec4 color, GLubyte out[4]);
+
+/* One instanced draw of a shape type, instances from baseInstance on. */
+void drawShapeInstances(ShapeType type, GLsizei instances, GLuint baseInstance);
+
+/* Issues shapes[*first] .. in submission order as instanced draws, one per
+   run of the same shape type, instance i of the run at base instance i.
+   With copies > 1 every piece is drawn that many times; the attribute
+   divisor must then equal copies. */
+void drawShapeRuns(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first, size_t count,
+	int copies = 1);
+
+/* Draws pieces with their transforms as instance attributes. Instances are
+   written in submission order and drawn in runs of the same shape type, so
+   blending and depth order are the same as the per-piece path. */
+class AffineRenderer {
+public:
+	AffineRenderer() = default;
+	~AffineRenderer() = default;
+
+	/* Adds the instance attributes (locations 2 to 4, divisor 1) to vao. */
+	void create(GLuint vao);
+
+	/* Draws shapes[*first] .. shapes[*(last - 1)], the selected one in white.
+	   The vao given to create must be bound. */
+	void draw(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+		std::vector<uint32_t>::const_iterator last, int32_t selected);
+
+private:
+	std::unique_ptr<mgl::ShaderProgram> Shaders;
+	mgl::StreamBuffer Instances;
+};
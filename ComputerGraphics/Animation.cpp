@@ -0,0 +1,132 @@
+#include "Animation.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+float ease(Easing easing, float t) {
+	t = std::clamp(t, 0.0f, 1.0f);
+	switch (easing) {
+	case Easing::EaseIn:
+		return t * t;
+	case Easing::EaseOut:
+		return t * (2.0f - t);
+	case Easing::EaseInOut:
+		return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * (1.0f - t) * (1.0f - t) * (1.0f - t);
+	case Easing::SmoothStep:
+		return t * t * (3.0f - 2.0f * t);
+	default:
+		return t;
+	}
+}
+
+void PoseAnimation::clear() {
+	Pieces = 0;
+	Times.clear();
+	Easings.clear();
+	Values.clear();
+	Deltas.clear();
+}
+
+void PoseAnimation::addPose(float time, const std::vector<ShapeInstance>& pose, Easing easing) {
+	if (Times.empty()) {
+		Pieces = pose.size();
+	} else if (pose.size() != Pieces || time <= Times.back()) {
+		throw std::runtime_error("Poses must have the same pieces and increasing times.");
+	}
+
+	Channels key;
+	key.tx.resize(Pieces);
+	key.ty.resize(Pieces);
+	key.rotation.resize(Pieces);
+	key.sx.resize(Pieces);
+	key.sy.resize(Pieces);
+	for (size_t i = 0; i < Pieces; i++) {
+		key.tx[i] = pose[i].translate.x;
+		key.ty[i] = pose[i].translate.y;
+		key.rotation[i] = pose[i].rotation;
+		key.sx[i] = pose[i].scale.x;
+		key.sy[i] = pose[i].scale.y;
+	}
+
+	if (!Values.empty()) {
+		const Channels& from = Values.back();
+		Channels delta;
+		delta.tx.resize(Pieces);
+		delta.ty.resize(Pieces);
+		delta.rotation.resize(Pieces);
+		delta.sx.resize(Pieces);
+		delta.sy.resize(Pieces);
+		for (size_t i = 0; i < Pieces; i++) {
+			delta.tx[i] = key.tx[i] - from.tx[i];
+			delta.ty[i] = key.ty[i] - from.ty[i];
+			delta.sx[i] = key.sx[i] - from.sx[i];
+			delta.sy[i] = key.sy[i] - from.sy[i];
+			/* Shortest arc: wrap the difference into [-pi, pi). */
+			const float d = key.rotation[i] - from.rotation[i];
+			delta.rotation[i] = d - glm::two_pi<float>() * std::floor((d + glm::pi<float>()) / glm::two_pi<float>());
+		}
+		Deltas.push_back(std::move(delta));
+	}
+
+	Times.push_back(time);
+	Easings.push_back(easing);
+	Values.push_back(std::move(key));
+}
+
+bool PoseAnimation::moves(size_t piece) const {
+	for (const Channels& d : Deltas) {
+		if (d.tx[piece] != 0.0f || d.ty[piece] != 0.0f || d.rotation[piece] != 0.0f ||
+			d.sx[piece] != 0.0f || d.sy[piece] != 0.0f) return true;
+	}
+	return false;
+}
+
+void PoseAnimation::evaluate(float time, std::vector<ShapeInstance>& shapes) const {
+	if (Times.empty() || shapes.size() != Pieces) return;
+
+	size_t segment = 0;
+	float u = 0.0f;
+	if (Times.size() > 1) {
+		const float span = duration() - Times.front();
+		if (Loop && span > 0.0f) time = Times.front() + std::fmod(std::max(time - Times.front(), 0.0f), span);
+		time = std::clamp(time, Times.front(), Times.back());
+		segment = static_cast<size_t>(std::upper_bound(Times.begin(), Times.end(), time) - Times.begin());
+		segment = std::clamp<size_t>(segment, 1, Times.size() - 1) - 1;
+		u = ease(Easings[segment], (time - Times[segment]) / (Times[segment + 1] - Times[segment]));
+	}
+
+	const Channels& a = Values[segment];
+	const Channels* d = segment < Deltas.size() ? &Deltas[segment] : nullptr;
+	if (!d) u = 0.0f;
+
+	parallelFor(0, Pieces, [&](size_t begin, size_t end) {
+		/* Interpolate a block in SoA form (vectorizable), then scatter it. */
+		const size_t Block = 256;
+		float tx[Block], ty[Block], rotation[Block], sx[Block], sy[Block];
+		for (size_t base = begin; base < end; base += Block) {
+			const size_t n = std::min(Block, end - base);
+			if (d) {
+				for (size_t j = 0; j < n; j++) tx[j] = a.tx[base + j] + d->tx[base + j] * u;
+				for (size_t j = 0; j < n; j++) ty[j] = a.ty[base + j] + d->ty[base + j] * u;
+				for (size_t j = 0; j < n; j++) rotation[j] = a.rotation[base + j] + d->rotation[base + j] * u;
+				for (size_t j = 0; j < n; j++) sx[j] = a.sx[base + j] + d->sx[base + j] * u;
+				for (size_t j = 0; j < n; j++) sy[j] = a.sy[base + j] + d->sy[base + j] * u;
+			} else {
+				std::copy_n(&a.tx[base], n, tx);
+				std::copy_n(&a.ty[base], n, ty);
+				std::copy_n(&a.rotation[base], n, rotation);
+				std::copy_n(&a.sx[base], n, sx);
+				std::copy_n(&a.sy[base], n, sy);
+			}
+			for (size_t j = 0; j < n; j++) {
+				ShapeInstance& shape = shapes[base + j];
+				shape.translate.x = tx[j];
+				shape.translate.y = ty[j];
+				shape.rotation = rotation[j];
+				shape.scale = glm::vec2(sx[j], sy[j]);
+			}
+		}
+	}, 16384);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Scene.h"
+
+enum class Easing : uint8_t {
+	Linear,
+	EaseIn,
+	EaseOut,
+	EaseInOut,
+	SmoothStep
+};
+
+float ease(Easing easing, float t);
+
+/* Keyframed morph between whole tangram poses. Every piece has its own
+   track, but the tracks share key times, so each channel of a key is one
+   contiguous array over all pieces and a frame is a handful of streaming
+   lerps. Rotation deltas take the shortest arc and are baked when a key is
+   added, so evaluation never wraps angles. */
+class PoseAnimation {
+public:
+	/* pose must hold one instance per piece, in the same order as the scene. */
+	void addPose(float time, const std::vector<ShapeInstance>& pose, Easing easing = Easing::EaseInOut);
+	void clear();
+
+	size_t pieces() const { return Pieces; }
+	size_t keys() const { return Times.size(); }
+	float duration() const { return Times.empty() ? 0.0f : Times.back(); }
+	/* True when some key changes the piece, i.e. it does not hold still. */
+	bool moves(size_t piece) const;
+
+	/* Writes scale, rotation and translate.xy of every piece; colors, layers
+	   and depth are left alone. Pieces are split across worker threads. */
+	void evaluate(float time, std::vector<ShapeInstance>& shapes) const;
+
+	bool Loop = true;
+
+private:
+	struct Channels {
+		std::vector<float> tx, ty, rotation, sx, sy;
+	};
+
+	size_t Pieces = 0;
+	std::vector<float> Times;
+	std::vector<Easing> Easings;	// easing of the segment starting at each key
+	std::vector<Channels> Values;	// pose at each key
+	std::vector<Channels> Deltas;	// change from each key to the next
+};
@@ -0,0 +1,389 @@
+#include "Benchmarks.h"
+#include "Affine2D.h"
+#include "AffineRenderer.h"
+#include "ParameterRenderer.h"
+#include "Scene.h"
+#include "Culling.h"
+#include "SpatialIndex.h"
+#include "Picking.h"
+#include "SceneFile.h"
+#include "Animation.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double millisecondsSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static size_t argCount(int argc, char* argv[], int index, size_t fallback) {
+	return argc > index ? static_cast<size_t>(std::strtoull(argv[index], nullptr, 10)) : fallback;
+}
+
+/* Side length of the square that holds count pieces at a density of roughly one per unit. */
+static float sceneExtent(size_t count) {
+	return 0.25f * std::sqrt(static_cast<float>(count));
+}
+
+//////////////////////////////////////////////////////////////// SPATIAL INDEX
+
+static int benchSpatial(int argc, char* argv[]) {
+	const size_t count = argCount(argc, argv, 3, 200000);
+	const float extent = sceneExtent(count);
+	const size_t queries = 10000;
+
+	std::vector<ShapeInstance> shapes = randomTangram(count, extent, 1234u);
+	BoundsSoA bounds;
+	computeBounds(shapes, bounds);
+
+	std::mt19937 rng(99u);
+	std::uniform_real_distribution<float> position(-extent, extent);
+	std::vector<glm::vec2> points(queries);
+	for (glm::vec2& p : points) p = glm::vec2(position(rng), position(rng));
+
+	/* Move 1% of the pieces by a small amount to exercise the incremental path. */
+	std::vector<uint32_t> moved;
+	for (uint32_t i = 0; i < count; i += 100) moved.push_back(i);
+	BoundsSoA movedBounds = bounds;
+	for (uint32_t i : moved) {
+		movedBounds.MinX[i] += 0.05f;
+		movedBounds.MaxX[i] += 0.05f;
+	}
+
+	std::cout << "Spatial index benchmark: " << count << " pieces, " << queries << " queries each\n"
+		<< std::left << std::setw(10) << "index"
+		<< std::right << std::setw(12) << "build ms"
+		<< std::setw(12) << "update ms"
+		<< std::setw(12) << "range us"
+		<< std::setw(12) << "point us"
+		<< std::setw(12) << "knn8 us"
+		<< std::setw(14) << "range hits" << std::endl;
+
+	/* Linear scan baseline for range queries, over the same moved bounds and
+	   every query the indices answer, so its hit count must equal theirs. */
+	{
+		size_t hits = 0;
+		auto start = Clock::now();
+		for (const glm::vec2& p : points) {
+			const Aabb2 range = { p - 1.0f, p + 1.0f };
+			for (size_t i = 0; i < count; i++) hits += Aabb2::of(movedBounds, i).overlaps(range);
+		}
+		std::cout << std::left << std::setw(10) << "linear"
+			<< std::right << std::setw(12) << "-" << std::setw(12) << "-"
+			<< std::setw(12) << std::fixed << std::setprecision(2) << millisecondsSince(start) * 1000.0 / queries
+			<< std::setw(12) << "-" << std::setw(12) << "-"
+			<< std::setw(14) << hits << std::endl;
+	}
+
+	std::unique_ptr<SpatialIndex> indices[] = {
+		std::make_unique<Quadtree>(), std::make_unique<Bvh>(), std::make_unique<UniformGrid>()
+	};
+	std::vector<uint32_t> out;
+	for (std::unique_ptr<SpatialIndex>& index : indices) {
+		auto start = Clock::now();
+		index->build(bounds);
+		const double build = millisecondsSince(start);
+
+		start = Clock::now();
+		index->update(movedBounds, moved);
+		const double update = millisecondsSince(start);
+
+		size_t hits = 0;
+		start = Clock::now();
+		for (const glm::vec2& p : points) {
+			index->queryRange({ p - 1.0f, p + 1.0f }, out);
+			hits += out.size();
+		}
+		const double range = millisecondsSince(start) * 1000.0 / queries;
+
+		start = Clock::now();
+		for (const glm::vec2& p : points) index->queryPoint(p, out);
+		const double point = millisecondsSince(start) * 1000.0 / queries;
+
+		start = Clock::now();
+		for (const glm::vec2& p : points) index->queryNearest(p, 8, out);
+		const double nearest = millisecondsSince(start) * 1000.0 / queries;
+
+		std::cout << std::left << std::setw(10) << index->name()
+			<< std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << build << std::setw(12) << update
+			<< std::setw(12) << range << std::setw(12) << point
+			<< std::setw(12) << nearest << std::setw(14) << hits << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////// PICKING
+
+static int benchPicking(int argc, char* argv[]) {
+	const size_t count = argCount(argc, argv, 3, 1000000);
+	const size_t picks = 10000;
+	std::vector<ShapeInstance> shapes = randomTangram(count, 2.0f, 2526u);
+	BoundsSoA bounds;
+	computeBounds(shapes, bounds);
+
+	auto start = Clock::now();
+	Bvh index;
+	index.build(bounds);
+	const double build = millisecondsSince(start);
+
+	std::mt19937 rng(7u);
+	std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+	std::vector<double> latencies(picks);
+	size_t hits = 0;
+	for (double& latency : latencies) {
+		const glm::vec2 clip(position(rng), position(rng));
+		start = Clock::now();
+		hits += pickCpu(index, shapes, clip) >= 0;
+		latency = millisecondsSince(start) * 1000.0;
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	std::cout << "CPU picking benchmark: " << count << " pieces (same scene as --pieces)\n"
+		<< std::fixed << std::setprecision(2)
+		<< "  bvh build      " << build << " ms\n"
+		<< "  latency p50    " << latencies[picks / 2] << " us\n"
+		<< "  latency p99    " << latencies[picks * 99 / 100] << " us\n"
+		<< "  latency max    " << latencies.back() << " us\n"
+		<< "  hits           " << hits << " / " << picks << "\n"
+		<< "GPU picking needs a context: run with --pieces " << count
+		<< ", press P and click; each pick prints its latency." << std::endl;
+	return EXIT_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////// SCENE LOADING
+
+static int benchSceneLoad(int argc, char* argv[]) {
+	const size_t count = argCount(argc, argv, 3, 10000000);
+	const std::string filename = "bench-scene.tgsc";
+	{
+		std::vector<ShapeInstance> shapes = randomTangram(count, sceneExtent(count), 42u);
+		auto start = Clock::now();
+		writeSceneBinary(filename, shapes);
+		std::cout << "Scene load benchmark: " << count << " instances\n"
+			<< std::fixed << std::setprecision(3)
+			<< "  write binary       " << millisecondsSince(start) << " ms" << std::endl;
+	}
+
+	auto start = Clock::now();
+	SceneFile file(filename);
+	const double map = millisecondsSince(start);
+
+	/* Reading every translate faults the pages in, as an upload would. */
+	start = Clock::now();
+	const SceneView& view = file.view();
+	double checksum = 0.0;
+	for (size_t i = 0; i < view.count; i++) checksum += view.translates[i].x;
+	const double touch = millisecondsSince(start);
+
+	start = Clock::now();
+	std::vector<ShapeInstance> shapes = file.instances();
+	const double copy = millisecondsSince(start);
+
+	std::cout << "  map and validate   " << map << " ms\n"
+		<< "  touch translates   " << touch << " ms (checksum " << checksum << ")\n"
+		<< "  copy to instances  " << copy << " ms" << std::endl;
+
+	if (count <= 1000000) {
+		writeSceneText("bench-scene.txt", shapes);
+		start = Clock::now();
+		const size_t parsed = readSceneText("bench-scene.txt").size();
+		std::cout << "  parse text         " << millisecondsSince(start) << " ms (" << parsed << " instances)" << std::endl;
+		std::remove("bench-scene.txt");
+	}
+	std::remove(filename.c_str());
+	return EXIT_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////// ANIMATION
+
+static int benchAnimation(int argc, char* argv[]) {
+	const size_t count = argCount(argc, argv, 3, 1000000);
+	const int frames = 200;
+	std::vector<ShapeInstance> shapes = randomTangram(count, 2.0f, 2526u);
+
+	PoseAnimation morph;
+	morph.addPose(0.0f, shapes);
+	morph.addPose(2.0f, randomTangram(count, 2.0f, 2527u), Easing::EaseInOut);
+	morph.addPose(4.0f, shapes, Easing::SmoothStep);
+
+	morph.evaluate(0.5f, shapes); // warm up pages and threads
+	auto start = Clock::now();
+	for (int f = 0; f < frames; f++) morph.evaluate(f / 60.0f, shapes);
+	const double evaluate = millisecondsSince(start) / frames;
+
+	BoundsSoA bounds;
+	computeBounds(shapes, bounds);
+	start = Clock::now();
+	for (int f = 0; f < 20; f++) computeBounds(shapes, bounds);
+	const double refresh = millisecondsSince(start) / 20;
+
+	std::cout << "Animation benchmark: " << count << " pieces, " << workerCount() << " threads\n"
+		<< std::fixed << std::setprecision(3)
+		<< "  evaluate         " << evaluate << " ms/frame\n"
+		<< "  bounds refresh   " << refresh << " ms/frame\n"
+		<< "  frame budget     16.667 ms (60 Hz)" << std::endl;
+	return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////// AFFINE
+
+/* mat4 against Affine2D for the piece transforms: composing the R2 * T * R * S
+   chain from prebuilt factors, building a piece transform from its
+   parameters, transforming points, inverting, and bytes per instance. */
+static int benchAffine(int argc, char* argv[]) {
+	const size_t count = argCount(argc, argv, 3, 1000000);
+	const std::vector<ShapeInstance> shapes = randomTangram(count, 2.0f, 2526u);
+	const glm::mat4 I(1.0f);
+	const glm::mat4 tilt4 = glm::rotate(I, glm::radians(TiltDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
+	const Affine2D tilt2 = Affine2D::rotation(TiltSin, TiltCos);
+
+	std::vector<glm::mat4> t4(count), r4(count), s4(count), m4(count);
+	std::vector<Affine2D> t2(count), r2(count), s2(count), m2(count);
+	for (size_t i = 0; i < count; i++) {
+		const ShapeInstance& shape = shapes[i];
+		t4[i] = glm::translate(I, shape.translate);
+		r4[i] = glm::rotate(I, shape.rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+		s4[i] = glm::scale(I, glm::vec3(shape.scale, 1.0f));
+		t2[i] = Affine2D::translation(glm::vec2(shape.translate));
+		r2[i] = Affine2D::rotation(std::sin(shape.rotation), std::cos(shape.rotation));
+		s2[i] = Affine2D::scaling(shape.scale);
+	}
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < count; i++) m4[i] = tilt4 * t4[i] * r4[i] * s4[i];
+	const double compose4 = millisecondsSince(start);
+	start = Clock::now();
+	for (size_t i = 0; i < count; i++) m2[i] = tilt2 * t2[i] * r2[i] * s2[i];
+	const double compose2 = millisecondsSince(start);
+	double error = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		const glm::mat4 d = m2[i].toMat4(shapes[i].translate.z) - m4[i];
+		for (int c = 0; c < 4; c++) error = std::max(error, double(glm::length(d[c])));
+	}
+
+	start = Clock::now();
+	for (size_t i = 0; i < count; i++) {
+		const ShapeInstance& shape = shapes[i];
+		m4[i] = ShapeRenderer::applyTransform(shape.scale, shape.rotation, shape.translate);
+	}
+	const double build4 = millisecondsSince(start);
+	start = Clock::now();
+	for (size_t i = 0; i < count; i++) {
+		const ShapeInstance& shape = shapes[i];
+		m2[i] = pieceAffine(shape.scale, shape.rotation, glm::vec2(shape.translate));
+	}
+	const double build2 = millisecondsSince(start);
+
+	glm::vec2 sum4(0.0f), sum2(0.0f);
+	start = Clock::now();
+	for (size_t i = 0; i < count; i++) sum4 += glm::vec2(m4[i] * glm::vec4(0.5f, 0.25f, 0.0f, 1.0f));
+	const double apply4 = millisecondsSince(start);
+	start = Clock::now();
+	for (size_t i = 0; i < count; i++) sum2 += m2[i].apply(glm::vec2(0.5f, 0.25f));
+	const double apply2 = millisecondsSince(start);
+
+	start = Clock::now();
+	for (size_t i = 0; i < count; i++) t4[i] = glm::inverse(m4[i]);
+	const double inverse4 = millisecondsSince(start);
+	start = Clock::now();
+	for (size_t i = 0; i < count; i++) t2[i] = m2[i].inverse();
+	const double inverse2 = millisecondsSince(start);
+
+	auto row = [](const char* name, double mat4, double affine) {
+		std::cout << "  " << name << std::setw(10) << mat4 << " ms" << std::setw(10) << affine << " ms"
+			<< std::setw(8) << mat4 / affine << "x" << std::endl;
+	};
+	std::cout << "Affine benchmark: " << count << " pieces (checksum " << sum4.x + sum2.x << ")\n"
+		<< std::fixed << std::setprecision(3)
+		<< "                             mat4       Affine2D  speedup" << std::endl;
+	row("compose R2 T R S  ", compose4, compose2);
+	row("build piece       ", build4, build2);
+	row("transform point   ", apply4, apply2);
+	row("inverse           ", inverse4, inverse2);
+	std::cout << "  bytes per instance " << std::setw(10) << sizeof(glm::mat4) + sizeof(glm::vec4)
+		<< std::setw(13) << sizeof(AffineInstance) << "  (mat4 + vec4 uniforms vs instance attributes)\n"
+		<< "  max |compose mat4 - Affine2D| " << std::scientific << error << std::endl;
+	return EXIT_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////// TRANSFORM PATHS
+
+/* CPU side of each transform path per frame, over a range of piece counts:
+   what the CPU computes and how many bytes it sends before the GPU can draw.
+   Only the CPU half is measured here. The parameter path moves the trig to
+   the vertex shader, so whether it pays off depends on a GPU this sweep
+   never touches: run the app on a --pieces scene, press T to switch paths,
+   and compare the [transform] cpu/gpu lines on the machine in question. */
+static int benchTransformPaths(int argc, char* argv[]) {
+	const size_t largest = argCount(argc, argv, 3, 1000000);
+	const int frames = 20;
+	std::cout << "Transform paths, CPU per frame (" << workerCount() << " threads):\n"
+		<< "      pieces     matrix ms     affine ms     params ms   matrix MB   affine MB   params MB" << std::endl;
+	for (size_t count = 1000; count <= largest; count *= 10) {
+		const std::vector<ShapeInstance> shapes = randomTangram(count, sceneExtent(count), 2526u);
+		std::vector<uint32_t> visible(count);
+		for (uint32_t i = 0; i < count; i++) visible[i] = i;
+		std::vector<glm::mat4> matrices(count);
+		std::vector<AffineInstance> affine(count);
+		std::vector<ParameterInstance> params(count);
+
+		/* The matrix path builds one mat4 per draw call, on the calling thread. */
+		auto start = Clock::now();
+		for (int f = 0; f < frames; f++) {
+			for (size_t i = 0; i < count; i++) {
+				const ShapeInstance& shape = shapes[visible[i]];
+				matrices[i] = ShapeRenderer::applyTransform(shape.scale, shape.rotation, shape.translate);
+			}
+		}
+		const double matrix = millisecondsSince(start) / frames;
+		start = Clock::now();
+		for (int f = 0; f < frames; f++) fillAffineInstances(shapes, visible.cbegin(), count, -1, affine.data());
+		const double affineMs = millisecondsSince(start) / frames;
+		start = Clock::now();
+		for (int f = 0; f < frames; f++) fillParameterInstances(shapes, visible.cbegin(), count, -1, params.data());
+		const double paramsMs = millisecondsSince(start) / frames;
+
+		const double mb = static_cast<double>(count) / (1024.0 * 1024.0);
+		std::cout << std::fixed << std::setprecision(3) << std::setw(12) << count
+			<< std::setw(14) << matrix << std::setw(14) << affineMs << std::setw(14) << paramsMs
+			<< std::setw(12) << mb * (sizeof(glm::mat4) + sizeof(glm::vec4))
+			<< std::setw(12) << mb * sizeof(AffineInstance)
+			<< std::setw(12) << mb * sizeof(ParameterInstance) << std::endl;
+	}
+	return EXIT_SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////// REGISTRY
+
+int runBenchmark(const std::string& name, int argc, char* argv[]) {
+	const std::map<std::string, std::function<int(int, char*[])>> benchmarks = {
+		{ "spatial", benchSpatial },
+		{ "picking", benchPicking },
+		{ "scene-load", benchSceneLoad },
+		{ "animation", benchAnimation },
+		{ "affine", benchAffine },
+		{ "transform-paths", benchTransformPaths },
+	};
+	auto it = benchmarks.find(name);
+	if (it == benchmarks.end()) {
+		std::cerr << "Unknown benchmark: " << name << "\nAvailable:";
+		for (const auto& entry : benchmarks) std::cerr << " " << entry.first;
+		std::cerr << std::endl;
+		return EXIT_FAILURE;
+	}
+	return it->second(argc, argv);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+/* Runs the named headless benchmark (no window or GL context is created).
+   Invoked as: ComputerGraphics --bench <name> [args...]. Returns the exit code. */
+int runBenchmark(const std::string& name, int argc, char* argv[]);
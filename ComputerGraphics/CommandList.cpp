@@ -0,0 +1,150 @@
+#include "CommandList.h"
+#include "ShapeRenderer.h"
+
+#include <cstring>
+
+const char* replayModeName(ReplayMode mode) {
+	switch (mode) {
+	case ReplayMode::Immediate: return "immediate";
+	case ReplayMode::Loop: return "loop";
+	case ReplayMode::Indirect: return "indirect";
+	default: return "?";
+	}
+}
+
+CommandList::~CommandList() {
+	if (Vao) glDeleteVertexArrays(1, &Vao);
+	GLuint buffers[] = { Elements, IndirectBuffer, DrawBuffer };
+	glDeleteBuffers(3, buffers);
+}
+
+void CommandList::create(GLuint vertexBuffer, const GLubyte* indices, size_t indexCount) {
+	Shaders = std::make_unique<mgl::ShaderProgram>();
+	Shaders->addShader(GL_VERTEX_SHADER, "clip-indirect-vs.glsl");
+	Shaders->addShader(GL_FRAGMENT_SHADER, "clip-fs.glsl");
+	Shaders->addAttribute(mgl::POSITION_ATTRIBUTE, 0);
+	Shaders->addUniform("DrawBase");
+	Shaders->create();
+	DrawBaseId = Shaders->Uniforms["DrawBase"].index;
+
+	SceneIndices.assign(indices, indices + indexCount);
+	glGenBuffers(1, &Elements);
+	glGenBuffers(1, &IndirectBuffer);
+	glGenBuffers(1, &DrawBuffer);
+
+	/* Same vertices as the scene, own triangle list indices. */
+	glGenVertexArrays(1, &Vao);
+	glBindVertexArray(Vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid*>(0));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Elements);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/* One multi-draw takes one primitive type, so strips become triangle lists:
+   triangle k of a strip is (k, k+1, k+2), with the first two swapped on odd
+   k to keep the winding. */
+const CommandList::Range& CommandList::triangleRange(GLenum mode, GLintptr offset, GLsizei count) {
+	for (const Range& range : Ranges) {
+		if (range.mode == mode && range.offset == offset && range.count == count) return range;
+	}
+	const GLubyte* i = SceneIndices.data() + offset;
+	Range range = { mode, offset, count, static_cast<GLuint>(TriangleIndices.size()), 0 };
+	if (mode == GL_TRIANGLE_STRIP) {
+		for (GLsizei k = 0; k + 2 < count; k++) {
+			const bool odd = (k & 1) != 0;
+			TriangleIndices.insert(TriangleIndices.end(), { i[odd ? k + 1 : k], i[odd ? k : k + 1], i[k + 2] });
+			range.triangles++;
+		}
+	} else {
+		TriangleIndices.insert(TriangleIndices.end(), i, i + count);
+		range.triangles = static_cast<GLuint>(count / 3);
+	}
+	Ranges.push_back(range);
+	return Ranges.back();
+}
+
+void CommandList::begin() {
+	Commands.clear();
+	Draws.clear();
+	Indirect.clear();
+	FirstBlended = 0;
+}
+
+void CommandList::beginBlended() {
+	FirstBlended = Draws.size();
+}
+
+void CommandList::record(GLint matrixId, GLint colorId, const GLfloat* matrix, const glm::vec4& color,
+	GLenum mode, GLsizei count, GLintptr offset) {
+	MatrixId = matrixId;
+	ColorId = colorId;
+	Commands.push_back({ mode, count, offset });
+	DrawData draw;
+	std::memcpy(draw.Matrix, matrix, sizeof(draw.Matrix));
+	std::memcpy(draw.Color, &color[0], sizeof(draw.Color));
+	Draws.push_back(draw);
+	const Range& range = triangleRange(mode, offset, count);
+	Indirect.push_back({ range.triangles * 3, 1, range.first, 0, 0 });
+}
+
+void CommandList::end() {
+	if (TriangleIndices.size() != UploadedIndices) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Elements);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, TriangleIndices.size(), TriangleIndices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		UploadedIndices = TriangleIndices.size();
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, Indirect.size() * sizeof(DrawIndirect), Indirect.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, DrawBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, Draws.size() * sizeof(DrawData), Draws.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	Valid = true;
+	Recordings++;
+}
+
+void CommandList::replayRange(ReplayMode mode, size_t first, size_t last) const {
+	if (first == last) return;
+	if (mode == ReplayMode::Loop) {
+		for (size_t i = first; i < last; i++) {
+			const Command& command = Commands[i];
+			glUniformMatrix4fv(MatrixId, 1, GL_FALSE, Draws[i].Matrix);
+			glUniform4fv(ColorId, 1, Draws[i].Color);
+			glDrawElements(command.mode, command.count, GL_UNSIGNED_BYTE, reinterpret_cast<GLvoid*>(command.offset));
+		}
+		return;
+	}
+	/* gl_DrawID restarts at 0 in every multi-draw; DrawBase offsets it. */
+	glUniform1i(DrawBaseId, static_cast<GLint>(first));
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_BYTE,
+		reinterpret_cast<GLvoid*>(first * sizeof(DrawIndirect)), static_cast<GLsizei>(last - first), 0);
+}
+
+void CommandList::replay(ReplayMode mode, bool blended) const {
+	if (mode == ReplayMode::Indirect) {
+		Shaders->bind();
+		glBindVertexArray(Vao);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, DrawBuffer);
+	}
+	replayRange(mode, 0, FirstBlended);
+	if (blended && FirstBlended != Draws.size()) {
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+		replayRange(mode, FirstBlended, Draws.size());
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+	}
+	if (mode == ReplayMode::Indirect) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindVertexArray(0);
+		Shaders->unbind();
+	}
+}
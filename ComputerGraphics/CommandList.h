@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <mgl.hpp>
+
+/* How a recorded command list is played back. */
+enum class ReplayMode {
+	Immediate,	// no list: drawScene walks the shapes through the renderers every frame
+	Loop,		// the recorded uniforms and draws, issued from one flat array
+	Indirect,	// two glMultiDrawElementsIndirect calls; per-draw data in an SSBO read at gl_DrawID
+	Count
+};
+
+const char* replayModeName(ReplayMode mode);
+
+/* The draws of a scene pass, recorded once with everything resolved: matrix,
+   color, primitive and index range per draw, in submission order, opaque
+   first. Replaying costs no transform building and no virtual calls, so the
+   list only has to be recorded again when the scene itself changes.
+
+   Recording goes through the renderers: while ShapeRenderer::setRecorder
+   points at a list, draws append to it instead of reaching GL. */
+class CommandList {
+public:
+	/* Per-draw data of the indirect path, std430 layout. */
+	struct DrawData {
+		GLfloat Matrix[16];
+		GLfloat Color[4];
+	};
+
+	CommandList() = default;
+	~CommandList();
+
+	/* vertexBuffer and indices are the scene's own, as the renderers draw
+	   them; the indirect path rebuilds strips as triangle lists over them.
+	   The vertex buffer is bound, not copied, so it must outlive the list. */
+	void create(GLuint vertexBuffer, const GLubyte* indices, size_t indexCount);
+
+	/* Drops the old commands and starts recording opaque draws. */
+	void begin();
+	/* Draws recorded from here on are blended. */
+	void beginBlended();
+	/* Uploads the indirect commands and per-draw data. */
+	void end();
+	void record(GLint matrixId, GLint colorId, const GLfloat* matrix, const glm::vec4& color,
+		GLenum mode, GLsizei count, GLintptr offset);
+
+	bool valid() const { return Valid; }
+	void invalidate() { Valid = false; }
+	size_t size() const { return Draws.size(); }
+	int recordings() const { return Recordings; }
+
+	/* Loop expects the scene's program and vertex array to be bound; Indirect
+	   binds its own and leaves none bound. Blended draws, unless left out,
+	   get the usual alpha blending with depth writes off. */
+	void replay(ReplayMode mode, bool blended = true) const;
+
+private:
+	struct DrawIndirect {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+	struct Command {
+		GLenum mode;
+		GLsizei count;
+		GLintptr offset;
+	};
+	/* Where a (mode, offset, count) draw of the scene's indices went in the
+	   triangle list index buffer. */
+	struct Range {
+		GLenum mode;
+		GLintptr offset;
+		GLsizei count;
+		GLuint first, triangles;
+	};
+
+	std::unique_ptr<mgl::ShaderProgram> Shaders;
+	GLint DrawBaseId = -1;
+	GLuint Vao = 0, Elements = 0, IndirectBuffer = 0, DrawBuffer = 0;
+	std::vector<GLubyte> SceneIndices, TriangleIndices;
+	std::vector<Range> Ranges;
+	size_t UploadedIndices = 0;
+
+	GLint MatrixId = -1, ColorId = -1;
+	std::vector<Command> Commands;
+	std::vector<DrawData> Draws;
+	std::vector<DrawIndirect> Indirect;
+	size_t FirstBlended = 0;
+	bool Valid = false;
+	int Recordings = 0;
+
+	const Range& triangleRange(GLenum mode, GLintptr offset, GLsizei count);
+	void replayRange(ReplayMode mode, size_t first, size_t last) const;
+};
@@ -3,7 +3,10 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <iomanip>
 #include <random>
 #include <iostream>
 #include <glm/vec3.hpp> 
@@ -13,6 +16,15 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include "ErrorProfile.h"
+#include "FastTrig.h"
+#include "FrameBatch.h"
+#include "MatrixBatch.h"
+#include "Parallel.h"
+#include "PropertyTest.h"
+#include "QuatBatch.h"
+#include "RotateBatch.h"
+
 using namespace std;
 using namespace glm;
 
@@ -48,10 +60,34 @@ void generate_random_mat3(mat3* m, float min = -5.0f, float max = 5.0f) {
 	*m = mat3(col1, col2, col3);
 }
 
+/* 1-norm condition number ||m|| ||inverse(m)||, computed in double. Float
+   results of inversion lose about log10 of it in significant digits. */
+template <length_t N, typename T>
+double condition_number(const mat<N, N, T>& m) {
+	const mat<N, N, double> d(m);
+	if (determinant(d) == 0.0) return INFINITY;
+	const mat<N, N, double> inv = inverse(d);
+	double norm = 0.0, inverse_norm = 0.0;
+	for (length_t c = 0; c < N; c++) {
+		double column = 0.0, inverse_column = 0.0;
+		for (length_t r = 0; r < N; r++) {
+			column += std::abs(d[c][r]);
+			inverse_column += std::abs(inv[c][r]);
+		}
+		norm = std::max(norm, column);
+		inverse_norm = std::max(inverse_norm, inverse_column);
+	}
+	return norm * inverse_norm;
+}
+
+/* Invertible in float terms, too: nearly singular draws would make the
+   THRESHOLD comparisons of their inverses fail on rounding alone. */
+const double MAX_TEST_CONDITION = 50.0;
+
 void random_invertable_mat3(mat3* m, float min = -5.0f, float max = 5.0f) {
 	do {
 		generate_random_mat3(m, min, max);
-	} while (determinant(*m) == 0);
+	} while (determinant(*m) == 0 || condition_number(*m) > MAX_TEST_CONDITION);
 }
 
 void create_coordinate_frame(vec3 view, vec3 up, Coordinate_frame* frame) {
@@ -61,9 +97,9 @@ void create_coordinate_frame(vec3 view, vec3 up, Coordinate_frame* frame) {
 }
 
 bool compare_matrix(mat3 m1, mat3 m2) {
-	for (int i = 0; i < 2; i++) {
-		for (int j = 0; j < 2; j++) {
-			if (epsilonNotEqual(m1[i][j], m1[i][j], THRESHOLD)) {
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			if (epsilonNotEqual(m1[i][j], m2[i][j], THRESHOLD)) {
 				return false;
 			}
 		}
@@ -83,16 +119,23 @@ bool matrix_inverse_distributive_property(mat3 m1, mat3 m2) {
 	return compare_matrix(left, right);
 }
 
+/* Trig is the sine/cosine policy of FastTrig.h; libm unless asked otherwise. */
+template <typename Trig = Exact_trig>
 vec3 rodrigues_vector_rotation_formula(vec3 axis, vec3 vector, float rads) {
 	vec3 axis_norm = normalize(axis);
+	float s, c;
+	Trig::sincos(rads, s, c);
 
-	return vector * cos(rads) +
-		(cross(axis_norm, vector)) * sin(rads) +
-		axis_norm * (dot(axis_norm, vector)) * (1 - cos(rads));
+	return vector * c +
+		(cross(axis_norm, vector)) * s +
+		axis_norm * (dot(axis_norm, vector)) * (1 - c);
 }
 
+template <typename Trig = Exact_trig>
 mat3 rodrigues_matrix_rotation_formula(mat3 axis, float rads) {
-	return mat3(1) + sin(rads) * axis + (1 - cos(rads)) * axis * axis;
+	float s, c;
+	Trig::sincos(rads, s, c);
+	return mat3(1) + s * axis + (1 - c) * axis * axis;
 }
 
 void qtest_triple_product() {
@@ -106,7 +149,8 @@ void qtest_triple_product() {
 
 	std::cout << "Testing Triple Product Proposition with:\nr1 = " << to_string(r1) << "\nr2 = " << to_string(r2) << std::endl;
 
-	assert(all(epsilonEqual(r1, r2, THRESHOLD)));
+	/* Each side is a sum of products of three coordinates, so rounding grows with |i||j||k|. */
+	assert(all(epsilonEqual(r1, r2, THRESHOLD * length(i) * length(j) * length(k))));
 	std::cout << "Triple Product equality test success.\nResults are: \nleft side = " << to_string(r1) << "  \nrigth side = " << to_string(r2) << std::endl;
 }
 
@@ -198,18 +242,16 @@ void qtest_coordinate_frame() {
 
 void qtest_rodrigues_matrix_rotation() {
 	//90 rotatation though x,y,z sequencially in all cases. Just to clarify
+	// Axis matrices are written row by row, make_mat3 reads columns: transpose.
 	float xaxis[9] = { 0, 0, 0, 0, 0, -1, 0, 1, 0 }, yaxis[9] = { 0,0,1,0,0,0,-1,0,0 }, zaxis[9] = { 0,-1,0,1,0,0,0,0,0 };
-	mat3 matx = make_mat3(xaxis), maty = make_mat3(yaxis), matz = make_mat3(zaxis);
+	mat3 matx = transpose(make_mat3(xaxis)), maty = transpose(make_mat3(yaxis)), matz = transpose(make_mat3(zaxis));
 
-	//values to be used as the matrix to be rotated
-	float xmat[9] = { 1,0,0,0,0,0,0,0,0 }, ymat[9] = { 0,0,0,0,1,0,0,0,0 }, zmat[9] = { 1,0,0,0,0,0,0,0,0 };
-	mat3 rotx = make_mat3(xmat), roty = make_mat3(ymat), rotz = make_mat3(zmat);
+	//vectors to be rotated
+	const vec3 rotx = { 1, 0, 0 }, roty = { 0, 1, 0 }, rotz = { 0, 0, 1 };
 
 	// xyz order means negative,otherwise it's positive. expected axis is the one that wasn't present yet
-	float expxy[9] = { 0,0,0,0,0,0,0,0,-1 }, expxz[9] = { 0,0,0,0,1,0,0,0,0 }, expyz[9] = { -1,0,0,0,0,0,0,0,0 },
-		expyx[9] = { 0,0,0,0,0,0,0,0,1 }, expzx[9] = { 0,0,0,0,-1,0,0,0,0 }, expzy[9] = { 1,0,0,0,0,0,0,0,0 };
-	mat3 expXY = make_mat3(expxy), expXZ = make_mat3(expxz), expYZ = make_mat3(expyz),
-		expYX = make_mat3(expyx), expZX = make_mat3(expzx), expZY = make_mat3(expzy);
+	const vec3 expXY = { 0, 0, -1 }, expXZ = { 0, 1, 0 }, expYZ = { -1, 0, 0 },
+		expYX = { 0, 0, 1 }, expZX = { 0, -1, 0 }, expZY = { 1, 0, 0 };
 
 	const float angle = radians(90.f);
 
@@ -217,18 +259,18 @@ void qtest_rodrigues_matrix_rotation() {
 		rodriguesY = rodrigues_matrix_rotation_formula(maty, angle),
 		rodriguesZ = rodrigues_matrix_rotation_formula(matz, angle);
 
-	assert(compare_matrix(rotx * rodriguesX, expXY));
-	std::cout << "Rodrigues case XY result: " << to_string(rotx * rodriguesY) << "\nExpected: " << to_string(expXY) << std::endl;
-	assert(compare_matrix(rotx * rodriguesZ, expXZ));
-	std::cout << "Rodrigues case XZ result: " << to_string(rotx * rodriguesZ) << "\nExpected: " << to_string(expXZ) << std::endl;
-	assert(compare_matrix(roty * rodriguesZ, expYZ));
-	std::cout << "Rodrigues case YZ result: " << to_string(roty * rodriguesZ) << "\nExpected: " << to_string(expYZ) << std::endl;
-	assert(compare_matrix(roty * rodriguesX, expYX));
-	std::cout << "Rodrigues case YX result: " << to_string(roty * rodriguesX) << "\nExpected: " << to_string(expYX) << std::endl;
-	assert(compare_matrix(rotz * rodriguesX, expZX));
-	std::cout << "Rodrigues case ZX result: " << to_string(rotz * rodriguesX) << "\nExpected: " << to_string(expZX) << std::endl;
-	assert(compare_matrix(rotz * rodriguesY, expZY));
-	std::cout << "Rodrigues case ZY result: " << to_string(rotz * rodriguesY) << "\nExpected: " << to_string(expZY) << std::endl;
+	assert(all(epsilonEqual(rodriguesY * rotx, expXY, THRESHOLD)));
+	std::cout << "Rodrigues case XY result: " << to_string(rodriguesY * rotx) << "\nExpected: " << to_string(expXY) << std::endl;
+	assert(all(epsilonEqual(rodriguesZ * rotx, expXZ, THRESHOLD)));
+	std::cout << "Rodrigues case XZ result: " << to_string(rodriguesZ * rotx) << "\nExpected: " << to_string(expXZ) << std::endl;
+	assert(all(epsilonEqual(rodriguesZ * roty, expYZ, THRESHOLD)));
+	std::cout << "Rodrigues case YZ result: " << to_string(rodriguesZ * roty) << "\nExpected: " << to_string(expYZ) << std::endl;
+	assert(all(epsilonEqual(rodriguesX * roty, expYX, THRESHOLD)));
+	std::cout << "Rodrigues case YX result: " << to_string(rodriguesX * roty) << "\nExpected: " << to_string(expYX) << std::endl;
+	assert(all(epsilonEqual(rodriguesX * rotz, expZX, THRESHOLD)));
+	std::cout << "Rodrigues case ZX result: " << to_string(rodriguesX * rotz) << "\nExpected: " << to_string(expZX) << std::endl;
+	assert(all(epsilonEqual(rodriguesY * rotz, expZY, THRESHOLD)));
+	std::cout << "Rodrigues case ZY result: " << to_string(rodriguesY * rotz) << "\nExpected: " << to_string(expZY) << std::endl;
 }
 
 void qtest_matrix_transpose_property() {
@@ -265,13 +307,646 @@ void qtest_matrix_inverse_distributive_property() {
 		<< to_string(m2) << std::endl;
 }
 
-int main() {
+void qtest_quat_batch() {
+	/* Batched conversion must match glm's own quaternion to matrix cast, and
+	   rotate vectors like the Rodrigues formula, which shares no code with it. */
+	const int count = 64;
+	Vec3SoA axis; axis.resize(count);
+	std::vector<float> angles(count);
+	for (int i = 0; i < count; i++) {
+		vec3 a; generate_random_vec3(&a, -1.0f, 1.0f);
+		axis.set(i, a);
+		angles[i] = randomFloat(-pi<float>(), pi<float>());
+	}
+	QuatSoA q; axis_angle_to_quat_batch(axis, angles, q);
+	Mat3SoA m3; quat_to_mat3_batch(q, m3);
+	Mat4SoA m4; quat_to_mat4_batch(q, nullptr, m4);
+	for (int i = 0; i < count; i++) {
+		const quat expected = angleAxis(angles[i], normalize(axis.get(i)));
+		assert(compare_matrix(m3.get(i), mat3_cast(expected)));
+		assert(compare_matrix(mat3(m4.get(i)), mat3_cast(expected)));
+		assert(epsilonEqual(m4.get(i)[3][3], 1.0f, THRESHOLD));
+		vec3 v; generate_random_vec3(&v, -1.0f, 1.0f);
+		const vec3 rotated = rodrigues_vector_rotation_formula(axis.get(i), v, angles[i]);
+		assert(all(epsilonEqual(m3.get(i) * v, rotated, THRESHOLD * 10.0f)));
+		assert(all(epsilonEqual(vec3(m4.get(i) * vec4(v, 1.0f)), rotated, THRESHOLD * 10.0f)));
+	}
+
+	/* Interpolation endpoints, and slerp's constant angular speed at the midpoint. */
+	QuatSoA a, b; a.resize(count); b.resize(count);
+	for (int i = 0; i < count; i++) {
+		a.set(i, q.get(i));
+		b.set(i, -q.get((i + 1) % count));	// negated: exercises the shortest-arc flip
+	}
+	QuatSoA n0, n1, mid;
+	nlerp_batch(a, b, 0.0f, n0);
+	nlerp_batch(a, b, 1.0f, n1);
+	slerp_batch(a, b, 0.5f, mid);
+	for (int i = 0; i < count; i++) {
+		assert(all(epsilonEqual(vec4(n0.get(i).x, n0.get(i).y, n0.get(i).z, n0.get(i).w),
+			vec4(a.get(i).x, a.get(i).y, a.get(i).z, a.get(i).w), THRESHOLD)));
+		assert(abs(dot(n1.get(i), b.get(i))) > 1.0f - THRESHOLD);
+		const quat expected = slerp(a.get(i), -b.get(i), 0.5f);
+		assert(abs(dot(mid.get(i), expected)) > 1.0f - 1.0e-4f);
+	}
+	std::cout << "Quaternion batch conversion and interpolation success over " << count << " rotations." << std::endl;
+}
+
+void qtest_rotate_batch() {
+	/* Both batch forms must agree with the scalar formula, tails included. */
+	const int count = 37;
+	Vec3SoA vectors; vectors.resize(count);
+	Vec3SoA axes; axes.resize(count);
+	std::vector<float> angles(count);
+	for (int i = 0; i < count; i++) {
+		vec3 v, a; generate_random_vec3(&v); generate_random_vec3(&a);
+		vectors.set(i, v);
+		axes.set(i, a);
+		angles[i] = randomFloat(-pi<float>(), pi<float>());
+	}
+
+	const vec3 shared_axis = axes.get(0);
+	Vec3SoA shared; rodrigues_rotate_batch(shared_axis, angles[0], vectors, shared);
+	Rodrigues_terms terms; rodrigues_terms_batch(axes, angles, terms);
+	Vec3SoA each; rodrigues_rotate_batch(terms, vectors, each);
+	for (int i = 0; i < count; i++) {
+		const vec3 v = vectors.get(i);
+		const float tolerance = THRESHOLD * 10.0f * std::max(1.0f, length(v));
+		assert(all(epsilonEqual(shared.get(i), rodrigues_vector_rotation_formula(shared_axis, v, angles[0]), tolerance)));
+		assert(all(epsilonEqual(each.get(i), rodrigues_vector_rotation_formula(axes.get(i), v, angles[i]), tolerance)));
+	}
+
+	/* In place: a quarter turn and back must give the input again. */
+	Vec3SoA round_trip = vectors;
+	rodrigues_rotate_batch(vec3(0.f, 0.f, 1.f), radians(90.f), round_trip, round_trip);
+	rodrigues_rotate_batch(vec3(0.f, 0.f, -1.f), radians(90.f), round_trip, round_trip);
+	for (int i = 0; i < count; i++) {
+		assert(all(epsilonEqual(round_trip.get(i), vectors.get(i), THRESHOLD * 10.0f)));
+	}
+	std::cout << "Rodrigues batch rotation success over " << count << " vectors (" << rotate_batch_isa() << ")." << std::endl;
+}
+
+void qtest_fast_trig() {
+	/* The minimax sincos must stay within its documented bound of the exact
+	   values, in the scalar call, the batch (vector body and tail) and the
+	   Rodrigues formula built on it. */
+	const int count = 1037;
+	std::vector<float> angles(count), s(count), c(count);
+	for (int i = 0; i < count; i++) {
+		const float range = i % 2 ? 2.0f * pi<float>() : Fast_trig::MaxArgument;
+		angles[i] = randomFloat(-range, range);
+	}
+	angles[0] = 0.0f; angles[1] = pi<float>(); angles[2] = -half_pi<float>();
+	Fast_trig::sincos_batch(angles.data(), s.data(), c.data(), count);
+	for (int i = 0; i < count; i++) {
+		float fs, fc;
+		Fast_trig::sincos(angles[i], fs, fc);
+		const double x = angles[i];
+		assert(std::abs(fs - std::sin(x)) <= Fast_trig::MaxError && std::abs(fc - std::cos(x)) <= Fast_trig::MaxError);
+		assert(std::abs(s[i] - std::sin(x)) <= Fast_trig::MaxError && std::abs(c[i] - std::cos(x)) <= Fast_trig::MaxError);
+	}
+
+	for (int i = 0; i < 10; i++) {
+		vec3 v, a; generate_random_vec3(&v); generate_random_vec3(&a);
+		const float rads = randomFloat(-pi<float>(), pi<float>());
+		const float tolerance = THRESHOLD * std::max(1.0f, length(v));
+		assert(all(epsilonEqual(rodrigues_vector_rotation_formula<Fast_trig>(a, v, rads),
+			rodrigues_vector_rotation_formula<Exact_trig>(a, v, rads), tolerance)));
+	}
+	std::cout << "Fast sincos success over " << count << " angles (max error " << Fast_trig::MaxError << ")." << std::endl;
+}
+
+/* Largest deviation from unit length and from mutual orthogonality. */
+float frame_orthonormality_error(const Coordinate_frame& f) {
+	if (any(isnan(f.u)) || any(isnan(f.v)) || any(isnan(f.w))) return INFINITY;
+	float error = 0.0f;
+	for (const vec3& axis : { f.u, f.v, f.w }) error = std::max(error, std::abs(length(axis) - 1.0f));
+	error = std::max({ error, std::abs(dot(f.u, f.v)), std::abs(dot(f.u, f.w)), std::abs(dot(f.v, f.w)) });
+	return error;
+}
+
+void qtest_frame_batch() {
+	/* Regular views must match create_coordinate_frame; views along up
+	   (case 3 of qtest_coordinate_frame, and its opposite) must still be
+	   orthonormal. 11 views leave a scalar tail after any SIMD width. */
+	const vec3 up = { 0.0f, 1.0f, 0.0f };
+	const vec3 views[] = { { 2.0f, 3.0f, 5.0f }, { 3.0f, 2.0f, 5.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -4.0f, 0.0f },
+		{ 1.0e-5f, 1.0f, 0.0f }, { -1.0f, 0.5f, 0.25f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 2.0f, 0.0f },
+		{ 7.0f, -3.0f, 1.0f }, { 0.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+	const int count = sizeof(views) / sizeof(views[0]);
+	Vec3SoA soa; soa.resize(count);
+	for (int i = 0; i < count; i++) soa.set(i, views[i]);
+
+	Frame_batch frames;
+	create_coordinate_frame_batch(soa, up, frames);
+	for (int i = 0; i < count; i++) {
+		const Coordinate_frame batch = { frames.u.get(i), frames.v.get(i), frames.w.get(i) };
+		assert(frame_orthonormality_error(batch) < THRESHOLD);
+		assert(all(epsilonEqual(batch.v, normalize(views[i]), THRESHOLD)));
+		assert(all(epsilonEqual(cross(batch.v, batch.w), batch.u, THRESHOLD)));
+		if (length(cross(up, normalize(views[i]))) > 1.0e-2f) {
+			Coordinate_frame expected;
+			create_coordinate_frame(views[i], up, &expected);
+			assert(all(epsilonEqual(batch.u, expected.u, THRESHOLD)));
+			assert(all(epsilonEqual(batch.w, expected.w, THRESHOLD)));
+		}
+	}
+
+	/* Views just outside the Parallel2 switch-over, around a tilted up: the
+	   cross product is mostly cancellation there and must still give an
+	   orthonormal frame. */
+	const vec3 tilted = normalize(vec3(0.3f, 0.8f, 0.52f));
+	const vec3 side = normalize(cross(tilted, vec3(1.0f, 0.0f, 0.0f)));
+	const float offsets[] = { 1.001e-3f, 1.01e-3f, 1.05e-3f, 1.1e-3f, 1.2e-3f, 1.5e-3f, 2.0e-3f, -1.01e-3f, -1.1e-3f, -2.0e-3f, 5.0e-3f };
+	Vec3SoA near; near.resize(count);
+	for (int i = 0; i < count; i++) near.set(i, tilted + offsets[i] * side);
+	Frame_batch near_frames;
+	create_coordinate_frame_batch(near, tilted, near_frames);
+	for (int i = 0; i < count; i++) {
+		const Coordinate_frame batch = { near_frames.u.get(i), near_frames.v.get(i), near_frames.w.get(i) };
+		assert(frame_orthonormality_error(batch) < THRESHOLD);
+	}
+	std::cout << "Coordinate frame batch success, degenerate case 3 gives: \nu = "
+		<< to_string(frames.u.get(2)) << "\nv = "
+		<< to_string(frames.v.get(2)) << "\nw = "
+		<< to_string(frames.w.get(2)) << std::endl;
+}
+
+template <int C, int R, typename T>
+bool compare_matrix_relative(const mat<C, R, T>& m1, const mat<C, R, T>& m2, T tolerance) {
+	T scale = T(1);
+	for (int c = 0; c < C; c++) for (int r = 0; r < R; r++) scale = std::max(scale, std::abs(m2[c][r]));
+	for (int c = 0; c < C; c++) for (int r = 0; r < R; r++) {
+		if (!(std::abs(m1[c][r] - m2[c][r]) <= tolerance * scale)) return false;
+	}
+	return true;
+}
+
+void qtest_matrix_batch() {
+	/* Every kernel against glm, in float and double; the last matrix is singular. */
+	const int count = 21;
+	Mat3SoA m3; m3.resize(count);
+	Mat4SoA m4; m4.resize(count);
+	Mat4dSoA m4d; m4d.resize(count);
+	for (int i = 0; i < count; i++) {
+		mat3 a; random_invertable_mat3(&a);
+		mat4 b = translate(mat4(a), vec3(randomFloat(), randomFloat(), randomFloat()));
+		b[0][3] = randomFloat(); b[2][3] = randomFloat();	// not affine
+		if (i == count - 1) { a[2] = a[0] * 2.0f; b[3] = b[1]; }
+		m3.set(i, a);
+		m4.set(i, b);
+		m4d.set(i, dmat4(b));
+	}
+
+	std::vector<float> det3, det4;
+	determinant_batch(m3, det3);
+	determinant_batch(m4, det4);
+	Mat3SoA inv3, inv_t3; Mat4SoA inv4; Mat4dSoA inv4d; Mat3SoA normal; Mat4SoA affine_inv;
+	std::vector<uint8_t> singular3, singular4, singular4d, singular_t3, singular_normal, singular_affine;
+	assert(inverse_batch(m3, inv3, singular3) == 1);
+	assert(inverse_batch(m4, inv4, singular4) == 1);
+	assert(inverse_batch(m4d, inv4d, singular4d) == 1);
+	assert(inverse_transpose_batch(m3, inv_t3, singular_t3) == 1);
+	normal_matrix_batch(m4, normal, singular_normal);
+
+	Mat4SoA affine; affine.resize(count);
+	for (int i = 0; i < count; i++) {
+		mat4 a = m4.get(i); a[0][3] = a[1][3] = a[2][3] = 0.0f; a[3][3] = 1.0f;
+		affine.set(i, a);
+	}
+	affine_inverse_batch(affine, affine_inv, singular_affine);
+
+	/* Both sides round, by up to a few ulps times the condition number. */
+	const float ulps = 16.0f * epsilon<float>();
+	for (int i = 0; i < count - 1; i++) {
+		assert(!singular3[i] && !singular4[i] && !singular4d[i] && !singular_t3[i] && !singular_normal[i] && !singular_affine[i]);
+		const float tolerance3 = ulps * float(condition_number(m3.get(i)));
+		const float tolerance4 = ulps * float(condition_number(m4.get(i)));
+		const float tolerance_affine = ulps * float(condition_number(affine.get(i)));
+		const dmat4 d4 = m4d.get(i);
+		const float det_scale = float(length(d4[0]) * length(d4[1]) * length(d4[2]) * length(d4[3]));
+		const mat3 a = m3.get(i);
+		assert(epsilonEqual(det3[i], determinant(a), ulps * length(a[0]) * length(a[1]) * length(a[2])));
+		assert(epsilonEqual(det4[i], float(determinant(d4)), ulps * det_scale));
+		assert(compare_matrix_relative(inv3.get(i), inverse(m3.get(i)), tolerance3));
+		assert(compare_matrix_relative(inv4.get(i), inverse(m4.get(i)), tolerance4));
+		assert(compare_matrix_relative(inv4d.get(i), inverse(d4), 1.0e-12 * condition_number(d4)));
+		assert(compare_matrix_relative(inv_t3.get(i), transpose(inverse(m3.get(i))), tolerance3));
+		assert(compare_matrix_relative(normal.get(i), transpose(inverse(mat3(m4.get(i)))), tolerance3));
+		assert(compare_matrix_relative(affine_inv.get(i), inverse(affine.get(i)), tolerance_affine));
+	}
+	const int last = count - 1;
+	assert(singular3[last] && singular4[last] && singular4d[last] && singular_t3[last]);
+	assert(inv3.get(last) == mat3(0.0f) && inv4.get(last) == mat4(0.0f));
+	std::cout << "Matrix batch determinant and inverse success over " << count << " matrices." << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////// BENCHMARKS
+
+double milliseconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+mat3 skew_matrix(vec3 axis) {
+	const vec3 a = normalize(axis);
+	return mat3(0.0f, a.z, -a.y, -a.z, 0.0f, a.x, a.y, -a.x, 0.0f);
+}
+
+/* Largest deviation of a rotation's image of v from the double precision
+   Rodrigues reference, and of R^T R from the identity. */
+struct Rotation_error {
+	double max_vector = 0.0, sum_vector = 0.0, max_orthogonality = 0.0;
+
+	void add(const mat3& r, const dvec3& axis, double rads, const vec3& v) {
+		const dvec3 k = normalize(axis), dv(v);
+		const dvec3 expected = dv * std::cos(rads) + cross(k, dv) * std::sin(rads) + k * dot(k, dv) * (1.0 - std::cos(rads));
+		const double e = length(dvec3(r * v) - expected) / length(dv);
+		max_vector = std::max(max_vector, e);
+		sum_vector += e;
+		const dmat3 rr(r), identity = transpose(rr) * rr - dmat3(1.0);
+		for (int c = 0; c < 3; c++) for (int row = 0; row < 3; row++)
+			max_orthogonality = std::max(max_orthogonality, std::abs(identity[c][row]));
+	}
+};
+
+void bench_rotation_paths(size_t count) {
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f), angle(-pi<float>(), pi<float>());
+	Vec3SoA axis; axis.resize(count);
+	std::vector<float> angles(count);
+	std::vector<vec3> vectors(count);
+	for (size_t i = 0; i < count; i++) {
+		vec3 a;
+		do a = vec3(unit(rng), unit(rng), unit(rng)); while (dot(a, a) < 1.0e-4f);
+		axis.set(i, a);
+		angles[i] = angle(rng);
+		vectors[i] = vec3(unit(rng), unit(rng), unit(rng)) * 5.0f;
+	}
+
+	std::vector<mat3> rodrigues(count), rotate_mat(count);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) rodrigues[i] = rodrigues_matrix_rotation_formula(skew_matrix(axis.get(i)), angles[i]);
+	const double rodrigues_ms = milliseconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) rotate_mat[i] = mat3(rotate(mat4(1.0f), angles[i], axis.get(i)));
+	const double rotate_ms = milliseconds_since(start);
+
+	/* Outputs are allocated up front, like the mat3 arrays above, so no path pays for first-touch page faults. */
+	QuatSoA q; q.resize(count);
+	Mat3SoA quat_mat; quat_mat.resize(count);
+	start = std::chrono::steady_clock::now();
+	axis_angle_to_quat_batch(axis, angles, q);
+	quat_to_mat3_batch(q, quat_mat);
+	const double quat_ms = milliseconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	quat_to_mat3_batch(q, quat_mat);
+	const double convert_ms = milliseconds_since(start);
+
+	QuatSoA shifted; shifted.resize(count);
+	for (size_t i = 0; i < count; i++) shifted.set(i, q.get((i + 1) % count));
+	QuatSoA blended; blended.resize(count);
+	start = std::chrono::steady_clock::now();
+	nlerp_batch(q, shifted, 0.3f, blended);
+	const double nlerp_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	slerp_batch(q, shifted, 0.3f, blended);
+	const double slerp_ms = milliseconds_since(start);
+
+	Rotation_error rodrigues_error, rotate_error, quat_error;
+	for (size_t i = 0; i < count; i++) {
+		const dvec3 a(axis.get(i));
+		rodrigues_error.add(rodrigues[i], a, angles[i], vectors[i]);
+		rotate_error.add(rotate_mat[i], a, angles[i], vectors[i]);
+		quat_error.add(quat_mat.get(i), a, angles[i], vectors[i]);
+	}
+
+	auto report = [count](const char* name, double ms, const Rotation_error* error) {
+		std::cout << "  " << name << ": " << ms << " ms (" << count / ms / 1000.0 << " M/s)";
+		if (error) {
+			std::cout << ", max error " << error->max_vector << ", mean error " << error->sum_vector / count
+				<< ", max |R^T R - I| " << error->max_orthogonality;
+		}
+		std::cout << std::endl;
+	};
+	std::cout << "Rotation matrices from " << count << " axis-angle pairs:" << std::endl;
+	report("Rodrigues mat3   ", rodrigues_ms, &rodrigues_error);
+	report("glm::rotate mat4 ", rotate_ms, &rotate_error);
+	report("quat SoA batch   ", quat_ms, &quat_error);
+	report("  quat->mat3 only", convert_ms, nullptr);
+	report("nlerp SoA batch  ", nlerp_ms, nullptr);
+	report("slerp SoA batch  ", slerp_ms, nullptr);
+}
+
+void bench_rodrigues_batch(size_t count) {
+	std::mt19937 rng(4321);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f), angle(-pi<float>(), pi<float>());
+	std::vector<vec3> aos(count);
+	Vec3SoA vectors; vectors.resize(count);
+	Vec3SoA axes; axes.resize(count);
+	std::vector<float> angles(count);
+	for (size_t i = 0; i < count; i++) {
+		aos[i] = vec3(unit(rng), unit(rng), unit(rng));
+		vectors.set(i, aos[i]);
+		axes.set(i, vec3(unit(rng), unit(rng), unit(rng)));
+		angles[i] = angle(rng);
+	}
+	const vec3 axis(0.3f, -0.5f, 0.8f);
+	const float rads = 0.7f;
+
+	std::vector<vec3> scalar(count);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) scalar[i] = rodrigues_vector_rotation_formula(axis, aos[i], rads);
+	const double scalar_ms = milliseconds_since(start);
+
+	Vec3SoA out; out.resize(count);
+	start = std::chrono::steady_clock::now();
+	rodrigues_rotate_batch(axis, rads, vectors, out);
+	const double shared_ms = milliseconds_since(start);
+	double max_error = 0.0;
+	for (size_t i = 0; i < count; i++) max_error = std::max(max_error, double(length(out.get(i) - scalar[i])));
+
+	Rodrigues_terms terms; terms.resize(count);
+	start = std::chrono::steady_clock::now();
+	rodrigues_terms_batch<Exact_trig>(axes, angles, terms);
+	const double exact_terms_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	rodrigues_terms_batch<Fast_trig>(axes, angles, terms);
+	const double terms_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	rodrigues_rotate_batch(terms, vectors, out);
+	const double each_ms = milliseconds_since(start);
+
+	auto report = [count](const char* name, double ms) {
+		std::cout << "  " << name << ": " << ms << " ms (" << count / ms / 1.0e6 << " Gvec/s)" << std::endl;
+	};
+	std::cout << "Rodrigues rotation of " << count << " vectors, " << rotate_batch_isa()
+		<< ", " << workerCount() << " threads:" << std::endl;
+	report("scalar formula, shared axis  ", scalar_ms);
+	report("batch, shared axis           ", shared_ms);
+	report("batch terms, libm trig       ", exact_terms_ms);
+	report("batch terms, minimax trig    ", terms_ms);
+	report("batch, per-element terms     ", each_ms);
+	std::cout << "  max difference batch vs scalar: " << max_error << std::endl;
+}
+
+void bench_trig(size_t count) {
+	std::mt19937 rng(1357);
+	std::uniform_real_distribution<float> angle(-2.0f * pi<float>(), 2.0f * pi<float>());
+	std::vector<float> angles(count), s(count), c(count);
+	for (float& a : angles) a = angle(rng);
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) Exact_trig::sincos(angles[i], s[i], c[i]);
+	const double exact_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) Fast_trig::sincos(angles[i], s[i], c[i]);
+	const double fast_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	Exact_trig::sincos_batch(angles.data(), s.data(), c.data(), count);
+	const double exact_batch_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	Fast_trig::sincos_batch(angles.data(), s.data(), c.data(), count);
+	const double fast_batch_ms = milliseconds_since(start);
+	double max_error = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		max_error = std::max({ max_error, std::abs(s[i] - std::sin(double(angles[i]))), std::abs(c[i] - std::cos(double(angles[i]))) });
+	}
+
+	auto report = [count](const char* name, double ms) {
+		std::cout << "  " << name << ": " << ms << " ms (" << count / ms / 1.0e3 << " M/s)" << std::endl;
+	};
+	std::cout << "sincos of " << count << " angles, " << rotate_batch_isa() << ":" << std::endl;
+	report("libm scalar   ", exact_ms);
+	report("minimax scalar", fast_ms);
+	report("libm batch    ", exact_batch_ms);
+	report("minimax batch ", fast_batch_ms);
+	std::cout << "  max error minimax batch: " << max_error << std::endl;
+}
+
+void bench_frame_batch(size_t count) {
+	std::mt19937 rng(2468);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	const vec3 up = { 0.0f, 1.0f, 0.0f };
+	std::cout << "Coordinate frames for " << count << " views, " << rotate_batch_isa() << ":" << std::endl;
+	for (int degenerate = 0; degenerate < 2; degenerate++) {
+		std::vector<vec3> views(count);
+		Vec3SoA soa; soa.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			views[i] = degenerate ? up * (unit(rng) < 0.0f ? -2.0f : 3.0f) : vec3(unit(rng), unit(rng), unit(rng));
+			soa.set(i, views[i]);
+		}
+
+		std::vector<Coordinate_frame> scalar(count);
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < count; i++) create_coordinate_frame(views[i], up, &scalar[i]);
+		const double scalar_ms = milliseconds_since(start);
+
+		Frame_batch frames; frames.resize(count);
+		start = std::chrono::steady_clock::now();
+		create_coordinate_frame_batch(soa, up, frames);
+		const double batch_ms = milliseconds_since(start);
+
+		size_t scalar_bad = 0;
+		float batch_error = 0.0f;
+		for (size_t i = 0; i < count; i++) {
+			if (!(frame_orthonormality_error(scalar[i]) < 1.0e-4f)) scalar_bad++;
+			batch_error = std::max(batch_error, frame_orthonormality_error({ frames.u.get(i), frames.v.get(i), frames.w.get(i) }));
+		}
+		std::cout << "  " << (degenerate ? "views along up" : "random views  ")
+			<< ": create_coordinate_frame " << scalar_ms << " ms (" << scalar_bad << " non-orthonormal)"
+			<< ", batch " << batch_ms << " ms (max orthonormality error " << batch_error << ")" << std::endl;
+	}
+}
+
+template <typename T>
+void bench_inverse_precision(size_t count, const char* precision) {
+	std::mt19937 rng(1357);
+	std::uniform_real_distribution<T> unit(T(-5), T(5));
+	std::vector<mat<4, 4, T>> models(count);
+	MatSoAT<4, 4, T> soa; soa.resize(count);
+	MatSoAT<3, 3, T> soa3; soa3.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		mat<4, 4, T> m(T(1));
+		for (int c = 0; c < 4; c++) for (int r = 0; r < 3; r++) m[c][r] = unit(rng);
+		models[i] = m;
+		soa.set(i, m);
+		soa3.set(i, mat<3, 3, T>(m));
+	}
+
+	std::vector<mat<4, 4, T>> inverses(count);
+	std::vector<mat<3, 3, T>> inverses3(count), normals(count);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) inverses[i] = inverse(models[i]);
+	const double glm4_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) inverses[i] = affineInverse(models[i]);
+	const double glm_affine_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) inverses3[i] = inverse(mat<3, 3, T>(models[i]));
+	const double glm3_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) normals[i] = transpose(inverse(mat<3, 3, T>(models[i])));
+	const double glm_normal_ms = milliseconds_since(start);
+
+	MatSoAT<4, 4, T> out; out.resize(count);
+	MatSoAT<3, 3, T> out3; out3.resize(count);
+	std::vector<uint8_t> singular(count);
+	std::vector<T> det(count);
+	start = std::chrono::steady_clock::now();
+	inverse_batch(soa, out, singular);
+	const double batch4_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	affine_inverse_batch(soa, out, singular);
+	const double affine_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	inverse_batch(soa3, out3, singular);
+	const double batch3_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	normal_matrix_batch(soa, out3, singular);
+	const double normal_ms = milliseconds_since(start);
+	start = std::chrono::steady_clock::now();
+	determinant_batch(soa, det);
+	const double det4_ms = milliseconds_since(start);
+
+	auto report = [count](const char* name, double glm_ms, double batch_ms) {
+		std::cout << "  " << name << ": ";
+		if (glm_ms > 0.0) std::cout << "glm " << count / glm_ms / 1000.0 << " M/s, ";
+		std::cout << "batch " << count / batch_ms / 1000.0 << " M/s";
+		if (glm_ms > 0.0) std::cout << " (" << glm_ms / batch_ms << "x)";
+		std::cout << std::endl;
+	};
+	std::cout << "Inverting " << count << " " << precision << " matrices:" << std::endl;
+	report("mat4 inverse       ", glm4_ms, batch4_ms);
+	report("mat4 affine inverse", glm_affine_ms, affine_ms);
+	report("mat3 inverse       ", glm3_ms, batch3_ms);
+	report("normal matrix      ", glm_normal_ms, normal_ms);
+	report("mat4 determinant   ", 0.0, det4_ms);
+}
+
+void bench_inverse_batch(size_t count) {
+	bench_inverse_precision<float>(count, "float");
+	bench_inverse_precision<double>(count, "double");
+}
+
+//////////////////////////////////////////////////////////////////// PROPERTIES
+
+/* The identities the qtests above check once, as properties over random
+   inputs in [-5, 5]. Errors are relative to the magnitude each side is
+   computed from, so a pass means "agrees to a few float ulps". */
+
+Sample_error property_triple_product(const float* in) {
+	const vec3 i = make_vec3(in), j = make_vec3(in + 3), k = make_vec3(in + 6);
+	const vec3 r1 = cross(i, cross(j, k));
+	const vec3 r2 = j * (dot(i, k)) - k * (dot(i, j));
+	return compare_components(value_ptr(r1), value_ptr(r2), 3, length(i) * length(j) * length(k));
+}
+
+float frobenius(const mat3& m) {
+	return sqrt(dot(m[0], m[0]) + dot(m[1], m[1]) + dot(m[2], m[2]));
+}
+
+Sample_error property_transpose(const float* in) {
+	const mat3 m1 = make_mat3(in), m2 = make_mat3(in + 9);
+	const mat3 left = transpose(m1 * m2), right = transpose(m2) * transpose(m1);
+	return compare_components(value_ptr(left), value_ptr(right), 9, frobenius(m1) * frobenius(m2));
+}
+
+Sample_error property_inverse_distributive(const float* in) {
+	const mat3 m1 = make_mat3(in), m2 = make_mat3(in + 9);
+	/* Inversion amplifies rounding by the condition number; allow for it, but
+	   only over the matrices random_invertable_mat3 would accept, so the
+	   allowance stays bounded. */
+	const double condition1 = condition_number(m1), condition2 = condition_number(m2);
+	if (!(condition1 <= MAX_TEST_CONDITION && condition2 <= MAX_TEST_CONDITION)) return Sample_error();
+	const mat3 left = inverse(m1 * m2), right = inverse(m2) * inverse(m1);
+	Sample_error error = compare_components(value_ptr(left), value_ptr(right), 9, frobenius(right));
+	error.allowed = condition1 * condition2;
+	return error;
+}
+
+Sample_error property_rodrigues(const float* in) {
+	const vec3 axis = make_vec3(in), v = make_vec3(in + 3);
+	const float rads = in[6] * pi<float>() / 5.0f;
+	if (dot(axis, axis) < 1.0e-6f) return Sample_error();	// no axis, no rotation
+	const vec3 by_vector = rodrigues_vector_rotation_formula(axis, v, rads);
+	const vec3 by_matrix = rodrigues_matrix_rotation_formula(skew_matrix(axis), rads) * v;
+	return compare_components(value_ptr(by_vector), value_ptr(by_matrix), 3, length(v));
+}
+
+std::vector<Property> math_properties() {
+	const double eps = epsilon<float>();
+	return {
+		{ "triple product", 9, -5.0f, 5.0f, 8.0 * eps, property_triple_product },
+		{ "transpose of product", 18, -5.0f, 5.0f, 4.0 * eps, property_transpose },
+		{ "inverse of product", 18, -5.0f, 5.0f, 16.0 * eps, property_inverse_distributive },
+		{ "rodrigues vector vs matrix", 7, -5.0f, 5.0f, 8.0 * eps, property_rodrigues },
+	};
+}
+
+int run_properties(uint64_t samples, uint64_t seed) {
+	std::cout << "Property runs with seed " << seed << " on " << workerCount() << " threads:" << std::endl;
+	uint64_t failures = 0;
+	for (const Property& property : math_properties()) {
+		const Property_report report = run_property(property, samples, seed);
+		print_property_report(property, report, seed);
+		failures += report.failures;
+	}
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int replay(const std::string& name, uint64_t seed, uint64_t sample) {
+	for (const Property& property : math_properties()) {
+		if (property.name != name) continue;
+		std::vector<float> input;
+		const Sample_error error = replay_property(property, seed, sample, input);
+		std::cout << property.name << " sample " << sample << " of seed " << seed << ":\n  input";
+		for (float f : input) std::cout << ' ' << std::setprecision(9) << f;
+		std::cout << std::setprecision(6) << "\n  relative error " << error.relative << ", " << error.ulps
+			<< " ulps, allowed " << property.tolerance * error.allowed << std::endl;
+		return EXIT_SUCCESS;
+	}
+	std::cerr << "[ERROR] Unknown property: " << name << std::endl;
+	return EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[]) {
 	srand(time(0));
-	const auto tests = { qtest_triple_product, qtest_coordinate_frame, qtest_rodrigues_vector, qtest_rodrigues_matrix_rotation ,qtest_matrix_transpose_property ,qtest_matrix_inverse_distributive_property };
+	const auto tests = { qtest_triple_product, qtest_coordinate_frame, qtest_rodrigues_vector, qtest_rodrigues_matrix_rotation ,qtest_matrix_transpose_property ,qtest_matrix_inverse_distributive_property, qtest_quat_batch, qtest_rotate_batch, qtest_fast_trig, qtest_frame_batch, qtest_matrix_batch };
 	for (const auto& test : tests) {
 		test();
 		std::cout << std::endl;
 	}
 	std::cout << std::endl;
+
+	/* --bench [count] runs the batch kernels against the scalar paths above. */
+	if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+		const size_t count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+		bench_rotation_paths(count);
+		bench_rodrigues_batch(count);
+		bench_trig(count);
+		bench_frame_batch(count);
+		bench_inverse_batch(count);
+	}
+	/* --prop [samples] [seed] checks the identities over many random samples;
+	   --replay name seed sample shows the inputs of one of them. */
+	if (argc > 1 && std::strcmp(argv[1], "--prop") == 0) {
+		const uint64_t samples = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4000000;
+		const uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : std::random_device()();
+		return run_properties(samples, seed);
+	}
+	/* --profile [samples] [seed] [tolerance] bins float, double and compensated
+	   errors by condition number, to tell which operations can stay in float. */
+	if (argc > 1 && std::strcmp(argv[1], "--profile") == 0) {
+		const uint64_t samples = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+		const uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : std::random_device()();
+		const double tolerance = argc > 4 ? std::strtod(argv[4], nullptr) : 1.0e-5;
+		std::cout << "Condition profile with seed " << seed << std::endl;
+		print_condition_profile(profile_condition(samples, seed), tolerance);
+	}
+	if (argc > 4 && std::strcmp(argv[1], "--replay") == 0) {
+		return replay(argv[2], std::strtoull(argv[3], nullptr, 10), std::strtoull(argv[4], nullptr, 10));
+	}
 	return EXIT_SUCCESS;
 }
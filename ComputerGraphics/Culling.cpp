@@ -0,0 +1,102 @@
+#include "Culling.h"
+#include "Affine2D.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULL_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define CULL_NEON 1
+#include <arm_neon.h>
+#endif
+
+void BoundsSoA::resize(size_t count) {
+	MinX.resize(count);
+	MinY.resize(count);
+	MaxX.resize(count);
+	MaxY.resize(count);
+}
+
+void computeBounds(const std::vector<ShapeInstance>& shapes, BoundsSoA& bounds) {
+	bounds.resize(shapes.size());
+	parallelFor(0, shapes.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const ShapeInstance& shape = shapes[i];
+			const Affine2D m = pieceAffine(shape.scale, shape.rotation, glm::vec2(shape.translate));
+			const ShapeOutline outline = shapeOutline(shape.type);
+
+			glm::vec2 lo(std::numeric_limits<float>::max());
+			glm::vec2 hi(-std::numeric_limits<float>::max());
+			for (int p = 0; p < outline.count; p++) {
+				const glm::vec2 clip = m.apply(outline.points[p]);
+				lo = glm::min(lo, clip);
+				hi = glm::max(hi, clip);
+			}
+			bounds.MinX[i] = lo.x;
+			bounds.MinY[i] = lo.y;
+			bounds.MaxX[i] = hi.x;
+			bounds.MaxY[i] = hi.y;
+		}
+	});
+}
+
+static inline bool overlaps(const BoundsSoA& b, size_t i, const ClipRect& r) {
+	return b.MaxX[i] >= r.MinX && b.MinX[i] <= r.MaxX &&
+		b.MaxY[i] >= r.MinY && b.MinY[i] <= r.MaxY;
+}
+
+static inline void emitMask(unsigned mask, uint32_t base, std::vector<uint32_t>& visible) {
+	while (mask) {
+		unsigned bit = 0;
+		while (!(mask & (1u << bit))) bit++;
+		visible.push_back(base + bit);
+		mask &= mask - 1;
+	}
+}
+
+CullStats cullBounds(const BoundsSoA& bounds, const ClipRect& rect, std::vector<uint32_t>& visible) {
+	const auto start = std::chrono::high_resolution_clock::now();
+	const size_t n = bounds.size();
+	visible.clear();
+	visible.reserve(n);
+
+	size_t i = 0;
+#if defined(CULL_SSE2)
+	const __m128 rMinX = _mm_set1_ps(rect.MinX), rMaxX = _mm_set1_ps(rect.MaxX);
+	const __m128 rMinY = _mm_set1_ps(rect.MinY), rMaxY = _mm_set1_ps(rect.MaxY);
+	for (; i + 4 <= n; i += 4) {
+		__m128 in = _mm_and_ps(
+			_mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&bounds.MaxX[i]), rMinX),
+				_mm_cmple_ps(_mm_loadu_ps(&bounds.MinX[i]), rMaxX)),
+			_mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&bounds.MaxY[i]), rMinY),
+				_mm_cmple_ps(_mm_loadu_ps(&bounds.MinY[i]), rMaxY)));
+		emitMask(static_cast<unsigned>(_mm_movemask_ps(in)), static_cast<uint32_t>(i), visible);
+	}
+#elif defined(CULL_NEON)
+	const float32x4_t rMinX = vdupq_n_f32(rect.MinX), rMaxX = vdupq_n_f32(rect.MaxX);
+	const float32x4_t rMinY = vdupq_n_f32(rect.MinY), rMaxY = vdupq_n_f32(rect.MaxY);
+	const uint32x4_t lanes = { 1, 2, 4, 8 };
+	for (; i + 4 <= n; i += 4) {
+		uint32x4_t in = vandq_u32(
+			vandq_u32(vcgeq_f32(vld1q_f32(&bounds.MaxX[i]), rMinX),
+				vcleq_f32(vld1q_f32(&bounds.MinX[i]), rMaxX)),
+			vandq_u32(vcgeq_f32(vld1q_f32(&bounds.MaxY[i]), rMinY),
+				vcleq_f32(vld1q_f32(&bounds.MinY[i]), rMaxY)));
+		emitMask(vaddvq_u32(vandq_u32(in, lanes)), static_cast<uint32_t>(i), visible);
+	}
+#endif
+	for (; i < n; i++) {
+		if (overlaps(bounds, i, rect)) visible.push_back(static_cast<uint32_t>(i));
+	}
+
+	CullStats stats;
+	stats.Visible = visible.size();
+	stats.Culled = n - visible.size();
+	stats.Milliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+	return stats;
+}
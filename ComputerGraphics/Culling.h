@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Scene.h"
+
+/* Axis aligned bounds of every instance, stored as separate streams so the
+   visibility test can load four instances per register. */
+struct BoundsSoA {
+	std::vector<float> MinX, MinY, MaxX, MaxY;
+
+	void resize(size_t count);
+	size_t size() const { return MinX.size(); }
+};
+
+/* Region of clip space that is considered visible. Defaults to the full
+   [-1, 1] viewport; a camera can narrow it to its own frustum footprint. */
+struct ClipRect {
+	float MinX = -1.0f, MinY = -1.0f;
+	float MaxX = 1.0f, MaxY = 1.0f;
+};
+
+struct CullStats {
+	size_t Visible = 0;
+	size_t Culled = 0;
+	double Milliseconds = 0.0;
+};
+
+void computeBounds(const std::vector<ShapeInstance>& shapes, BoundsSoA& bounds);
+
+/* Writes the index of every instance overlapping the rect into visible. */
+CullStats cullBounds(const BoundsSoA& bounds, const ClipRect& rect, std::vector<uint32_t>& visible);
@@ -0,0 +1,359 @@
+#include "ErrorProfile.h"
+#include "Parallel.h"
+#include "PropertyTest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+static const uint64_t ShardSize = 1 << 14;
+static const int InputsPerSample = 24;
+
+const char* profile_op_name(Profile_op op) {
+	static const char* const Names[] = { "transform M v", "product M N", "determinant", "inverse", "solve M x = b" };
+	return Names[static_cast<int>(op)];
+}
+
+const char* profile_precision_name(Profile_precision precision) {
+	static const char* const Names[] = { "float", "double", "compensated" };
+	return Names[static_cast<int>(precision)];
+}
+
+///////////////////////////////////////////////////////////////// COMPENSATED
+
+template <typename T>
+static inline void twoSum(T a, T b, T& s, T& e) {
+	s = a + b;
+	const T z = s - a;
+	e = (a - (s - z)) + (b - z);
+}
+
+template <typename T>
+static inline void twoProduct(T a, T b, T& p, T& e) {
+	p = a * b;
+	e = std::fma(a, b, -p);
+}
+
+template <typename T>
+T dot2(const T* a, const T* b, int n) {
+	T p, s, h, r, q;
+	twoProduct(a[0], b[0], p, s);
+	for (int i = 1; i < n; i++) {
+		twoProduct(a[i], b[i], h, r);
+		twoSum(p, h, p, q);
+		s += q + r;
+	}
+	return p + s;
+}
+
+template <typename T>
+T difference_of_products(T a, T b, T c, T d) {
+	const T w = c * d;
+	const T e = std::fma(-c, d, w);
+	const T f = std::fma(a, b, -w);
+	return f + e;
+}
+
+template <typename T>
+glm::mat<3, 3, T> compensated_product(const glm::mat<3, 3, T>& a, const glm::mat<3, 3, T>& b) {
+	glm::mat<3, 3, T> result;
+	for (int r = 0; r < 3; r++) {
+		const T row[3] = { a[0][r], a[1][r], a[2][r] };
+		for (int c = 0; c < 3; c++) result[c][r] = dot2(row, &b[c][0], 3);
+	}
+	return result;
+}
+
+template <typename T>
+glm::vec<3, T> compensated_transform(const glm::mat<3, 3, T>& m, const glm::vec<3, T>& v) {
+	glm::vec<3, T> result;
+	for (int r = 0; r < 3; r++) {
+		const T row[3] = { m[0][r], m[1][r], m[2][r] };
+		result[r] = dot2(row, &v[0], 3);
+	}
+	return result;
+}
+
+/* Columns c1 x c2, c2 x c0, c0 x c1: the rows of det * inverse. */
+template <typename T>
+static glm::mat<3, 3, T> cofactorColumns(const glm::mat<3, 3, T>& m) {
+	glm::mat<3, 3, T> cof;
+	for (int i = 0; i < 3; i++) {
+		const glm::vec<3, T>& a = m[(i + 1) % 3];
+		const glm::vec<3, T>& b = m[(i + 2) % 3];
+		cof[i] = glm::vec<3, T>(difference_of_products(a.y, b.z, a.z, b.y),
+			difference_of_products(a.z, b.x, a.x, b.z),
+			difference_of_products(a.x, b.y, a.y, b.x));
+	}
+	return cof;
+}
+
+/* The six products of the cofactor expansion split exactly into hi + lo, so
+   the twelve-term dot2 only rounds the triple products, not the cofactors. */
+template <typename T>
+T compensated_determinant(const glm::mat<3, 3, T>& m) {
+	T a[12], b[12];
+	for (int i = 0; i < 3; i++) {
+		const glm::vec<3, T>& c1 = m[1];
+		const glm::vec<3, T>& c2 = m[2];
+		const int j = (i + 1) % 3, k = (i + 2) % 3;
+		twoProduct(c1[j], c2[k], b[4 * i], b[4 * i + 1]);
+		twoProduct(c1[k], c2[j], b[4 * i + 2], b[4 * i + 3]);
+		b[4 * i + 2] = -b[4 * i + 2];
+		b[4 * i + 3] = -b[4 * i + 3];
+		a[4 * i] = a[4 * i + 1] = a[4 * i + 2] = a[4 * i + 3] = m[0][i];
+	}
+	return dot2(a, b, 12);
+}
+
+template <typename T>
+glm::mat<3, 3, T> compensated_inverse(const glm::mat<3, 3, T>& m) {
+	return glm::transpose(cofactorColumns(m)) / compensated_determinant(m);
+}
+
+template <typename T>
+glm::vec<3, T> gaussian_solve(const glm::mat<3, 3, T>& m, const glm::vec<3, T>& b) {
+	T a[3][4];
+	for (int r = 0; r < 3; r++) a[r][0] = m[0][r], a[r][1] = m[1][r], a[r][2] = m[2][r], a[r][3] = b[r];
+	for (int c = 0; c < 3; c++) {
+		int pivot = c;
+		for (int r = c + 1; r < 3; r++) if (std::abs(a[r][c]) > std::abs(a[pivot][c])) pivot = r;
+		if (pivot != c) std::swap(a[pivot], a[c]);
+		for (int r = c + 1; r < 3; r++) {
+			const T f = a[r][c] / a[c][c];
+			for (int k = c; k < 4; k++) a[r][k] -= f * a[c][k];
+		}
+	}
+	glm::vec<3, T> x;
+	for (int r = 2; r >= 0; r--) {
+		T s = a[r][3];
+		for (int k = r + 1; k < 3; k++) s -= a[r][k] * x[k];
+		x[r] = s / a[r][r];
+	}
+	return x;
+}
+
+/* The residual b - M x cancels to the size of the error in x, so it is
+   taken with dot2; solving for the correction needs no extra precision. */
+template <typename T>
+glm::vec<3, T> compensated_solve(const glm::mat<3, 3, T>& m, const glm::vec<3, T>& b) {
+	const glm::vec<3, T> x = gaussian_solve(m, b);
+	glm::vec<3, T> residual;
+	for (int r = 0; r < 3; r++) {
+		const T row[4] = { m[0][r], m[1][r], m[2][r], b[r] };
+		const T terms[4] = { -x[0], -x[1], -x[2], T(1) };
+		residual[r] = dot2(row, terms, 4);
+	}
+	return x + gaussian_solve(m, residual);
+}
+
+#define INSTANTIATE(T) \
+	template T dot2<T>(const T*, const T*, int); \
+	template T difference_of_products<T>(T, T, T, T); \
+	template glm::mat<3, 3, T> compensated_product<T>(const glm::mat<3, 3, T>&, const glm::mat<3, 3, T>&); \
+	template glm::vec<3, T> compensated_transform<T>(const glm::mat<3, 3, T>&, const glm::vec<3, T>&); \
+	template T compensated_determinant<T>(const glm::mat<3, 3, T>&); \
+	template glm::mat<3, 3, T> compensated_inverse<T>(const glm::mat<3, 3, T>&); \
+	template glm::vec<3, T> gaussian_solve<T>(const glm::mat<3, 3, T>&, const glm::vec<3, T>&); \
+	template glm::vec<3, T> compensated_solve<T>(const glm::mat<3, 3, T>&, const glm::vec<3, T>&);
+
+INSTANTIATE(float)
+INSTANTIATE(double)
+
+///////////////////////////////////////////////////////////////////// PROFILE
+
+void Condition_profile::add(Profile_op op, Profile_precision precision, int conditionBin, double error) {
+	const int o = static_cast<int>(op), p = static_cast<int>(precision);
+	if (!std::isfinite(error)) {
+		non_finite[o][p][conditionBin]++;
+		return;
+	}
+	const int bin = error <= 0.0 ? 0 :
+		std::clamp(static_cast<int>(std::floor((std::log10(error) - ErrorFloor) * 4.0)), 0, ErrorBins - 1);
+	histogram[o][p][conditionBin][bin]++;
+	max_error[o][p][conditionBin] = std::max(max_error[o][p][conditionBin], error);
+}
+
+void Condition_profile::merge(const Condition_profile& other) {
+	for (int o = 0; o < Ops; o++) for (int p = 0; p < Precisions; p++) for (int c = 0; c < ConditionBins; c++) {
+		for (int e = 0; e < ErrorBins; e++) histogram[o][p][c][e] += other.histogram[o][p][c][e];
+		max_error[o][p][c] = std::max(max_error[o][p][c], other.max_error[o][p][c]);
+		non_finite[o][p][c] += other.non_finite[o][p][c];
+	}
+	for (int c = 0; c < ConditionBins; c++) samples[c] += other.samples[c];
+}
+
+double Condition_profile::quantile(Profile_op op, Profile_precision precision, int conditionBin, double q) const {
+	const int o = static_cast<int>(op), p = static_cast<int>(precision);
+	const uint64_t* bins = histogram[o][p][conditionBin];
+	uint64_t total = non_finite[o][p][conditionBin];
+	for (int e = 0; e < ErrorBins; e++) total += bins[e];
+	const double target = q * static_cast<double>(total);
+	uint64_t seen = 0;
+	for (int e = 0; e < ErrorBins; e++) {
+		seen += bins[e];
+		if (seen > 0 && static_cast<double>(seen) >= target) return std::pow(10.0, ErrorFloor + (e + 1) / 4.0);
+	}
+	return total ? INFINITY : 0.0;
+}
+
+/* U diag(1, s, 1 / condition) V^T for random rotations U and V. */
+static glm::dmat3 conditionedMatrix(const float* r, double logCondition) {
+	glm::dquat u(r[0], r[1], r[2], r[3]), v(r[4], r[5], r[6], r[7]);
+	u = glm::length(u) > 1.0e-3 ? glm::normalize(u) : glm::dquat(1.0, 0.0, 0.0, 0.0);
+	v = glm::length(v) > 1.0e-3 ? glm::normalize(v) : glm::dquat(1.0, 0.0, 0.0, 0.0);
+	const double condition = std::pow(10.0, logCondition);
+	glm::dmat3 s(1.0);
+	s[1][1] = std::pow(condition, -0.5 * (r[8] + 1.0));	// somewhere between 1 and 1 / condition
+	s[2][2] = 1.0 / condition;
+	return glm::mat3_cast(u) * s * glm::transpose(glm::mat3_cast(v));
+}
+
+static double conditionNumber(const glm::dmat3& m) {
+	if (glm::determinant(m) == 0.0) return INFINITY;
+	const glm::dmat3 inv = glm::inverse(m);
+	double norm = 0.0, inverseNorm = 0.0;
+	for (int c = 0; c < 3; c++) {
+		norm = std::max(norm, std::abs(m[c][0]) + std::abs(m[c][1]) + std::abs(m[c][2]));
+		inverseNorm = std::max(inverseNorm, std::abs(inv[c][0]) + std::abs(inv[c][1]) + std::abs(inv[c][2]));
+	}
+	return norm * inverseNorm;
+}
+
+template <typename A>
+static double relativeError(const A& value, const A& reference) {
+	double diff = 0.0, norm = 0.0;
+	const double* values = glm::value_ptr(value);
+	const double* references = glm::value_ptr(reference);
+	for (int i = 0; i < static_cast<int>(sizeof(A) / sizeof(double)); i++) {
+		const double r = references[i];
+		const double d = values[i] - r;
+		diff += d * d;
+		norm += r * r;
+	}
+	return norm > 0.0 ? std::sqrt(diff / norm) : std::sqrt(diff);
+}
+static double relativeError(double value, double reference) {
+	return reference != 0.0 ? std::abs(value - reference) / std::abs(reference) : std::abs(value);
+}
+
+static void profileSample(const float* r, double maxLogCondition, Condition_profile& profile) {
+	const double logCondition = 0.5 * (r[9] + 1.0) * maxLogCondition;
+	const glm::mat3 m(conditionedMatrix(r, logCondition));
+	const glm::mat3 n(conditionedMatrix(r + 10, 0.5 * (r[19] + 1.0) * maxLogCondition));
+	const glm::vec3 v(r[20], r[21], r[22]);
+	const glm::dmat3 dm(m), dn(n);
+	const glm::dvec3 dv(v);
+
+	const double condition = conditionNumber(dm);
+	const int bin = std::isfinite(condition) ?
+		std::clamp(static_cast<int>(std::floor(std::log10(condition))), 0, Condition_profile::ConditionBins - 1) :
+		Condition_profile::ConditionBins - 1;
+	profile.samples[bin]++;
+
+	/* Reference: the compensated kernels in double, on the exact float inputs. */
+	const glm::dmat3 refInverse = compensated_inverse(dm);
+	const glm::dvec3 refTransform = compensated_transform(dm, dv);
+	const glm::dmat3 refProduct = compensated_product(dm, dn);
+	const double refDeterminant = compensated_determinant(dm);
+	const glm::dvec3 refSolve = compensated_solve(dm, dv);
+
+	const Profile_precision F = Profile_precision::Float, D = Profile_precision::Double, C = Profile_precision::Compensated;
+	profile.add(Profile_op::Transform, F, bin, relativeError(glm::dvec3(m * v), refTransform));
+	profile.add(Profile_op::Transform, D, bin, relativeError(dm * dv, refTransform));
+	profile.add(Profile_op::Transform, C, bin, relativeError(glm::dvec3(compensated_transform(m, v)), refTransform));
+
+	profile.add(Profile_op::Product, F, bin, relativeError(glm::dmat3(m * n), refProduct));
+	profile.add(Profile_op::Product, D, bin, relativeError(dm * dn, refProduct));
+	profile.add(Profile_op::Product, C, bin, relativeError(glm::dmat3(compensated_product(m, n)), refProduct));
+
+	profile.add(Profile_op::Determinant, F, bin, relativeError(double(glm::determinant(m)), refDeterminant));
+	profile.add(Profile_op::Determinant, D, bin, relativeError(glm::determinant(dm), refDeterminant));
+	profile.add(Profile_op::Determinant, C, bin, relativeError(double(compensated_determinant(m)), refDeterminant));
+
+	const glm::mat3 inverseF = glm::inverse(m), inverseC = compensated_inverse(m);
+	const glm::dmat3 inverseD = glm::inverse(dm);
+	profile.add(Profile_op::Inverse, F, bin, relativeError(glm::dmat3(inverseF), refInverse));
+	profile.add(Profile_op::Inverse, D, bin, relativeError(inverseD, refInverse));
+	profile.add(Profile_op::Inverse, C, bin, relativeError(glm::dmat3(inverseC), refInverse));
+
+	profile.add(Profile_op::Solve, F, bin, relativeError(glm::dvec3(gaussian_solve(m, v)), refSolve));
+	profile.add(Profile_op::Solve, D, bin, relativeError(gaussian_solve(dm, dv), refSolve));
+	profile.add(Profile_op::Solve, C, bin, relativeError(glm::dvec3(compensated_solve(m, v)), refSolve));
+}
+
+Condition_profile profile_condition(uint64_t samples, uint64_t seed, double maxLogCondition) {
+	const auto start = std::chrono::steady_clock::now();
+	Condition_profile result;
+	std::mutex merging;
+	const size_t shards = static_cast<size_t>((samples + ShardSize - 1) / ShardSize);
+	parallelFor(0, shards, [&](size_t begin, size_t end) {
+		std::unique_ptr<Condition_profile> local(new Condition_profile());
+		std::vector<float> input(InputsPerSample);
+		for (size_t shard = begin; shard < end; shard++) {
+			Xoshiro128x8 generator(seed, shard);
+			const uint64_t count = std::min<uint64_t>(ShardSize, samples - shard * ShardSize);
+			for (uint64_t s = 0; s < count; s++) {
+				generator.uniform(input.data(), input.size(), -1.0f, 1.0f);
+				profileSample(input.data(), maxLogCondition, *local);
+			}
+		}
+		std::lock_guard<std::mutex> lock(merging);
+		result.merge(*local);
+	}, 1);
+	result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+void print_condition_profile(const Condition_profile& profile, double tolerance) {
+	const int P = Condition_profile::Precisions;
+	uint64_t total = 0;
+	for (int c = 0; c < Condition_profile::ConditionBins; c++) total += profile.samples[c];
+	std::cout << "Relative error by condition number, " << total << " matrices in " << profile.milliseconds
+		<< " ms (p50 / p99 / max, then non-finite count):" << std::scientific << std::setprecision(0) << std::endl;
+
+	for (int o = 0; o < Condition_profile::Ops; o++) {
+		const Profile_op op = static_cast<Profile_op>(o);
+		std::cout << "  " << std::left << std::setw(15) << profile_op_name(op) << std::right;
+		for (int p = 0; p < P; p++) std::cout << std::setw(26) << profile_precision_name(static_cast<Profile_precision>(p));
+		std::cout << std::endl;
+		for (int c = 0; c < Condition_profile::ConditionBins; c++) {
+			if (!profile.samples[c]) continue;
+			std::cout << "    cond " << (c == Condition_profile::ConditionBins - 1 ? ">=" : "~ ") << "1e" << std::setw(2) << std::left << c << std::right;
+			for (int p = 0; p < P; p++) {
+				const Profile_precision precision = static_cast<Profile_precision>(p);
+				std::cout << "   " << profile.quantile(op, precision, c, 0.5) << " " << profile.quantile(op, precision, c, 0.99)
+					<< " " << profile.max_error[o][p][c] << " " << std::setw(3) << profile.non_finite[o][p][c];
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	std::cout << "Largest condition number with p99 error below " << tolerance << ":" << std::endl;
+	for (int o = 0; o < Condition_profile::Ops; o++) {
+		const Profile_op op = static_cast<Profile_op>(o);
+		std::cout << "  " << std::left << std::setw(15) << profile_op_name(op) << std::right;
+		for (int p = 0; p < P; p++) {
+			const Profile_precision precision = static_cast<Profile_precision>(p);
+			int safe = -1;
+			for (int c = 0; c < Condition_profile::ConditionBins; c++) {
+				if (!profile.samples[c]) continue;
+				if (profile.quantile(op, precision, c, 0.99) >= tolerance) break;
+				safe = c;
+			}
+			std::cout << "   " << profile_precision_name(precision) << ": ";
+			if (safe < 0) std::cout << "none";
+			else if (safe == Condition_profile::ConditionBins - 1) std::cout << "all";
+			else std::cout << "< 1e" << safe + 1;
+		}
+		std::cout << std::endl;
+	}
+	std::cout << std::defaultfloat << std::setprecision(6);
+}
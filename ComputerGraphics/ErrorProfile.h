@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+/* Profiles how the rounding error of 3x3 transform operations grows with the
+   condition number of the matrix, in float, double and compensated float.
+   Matrices are built as U diag(s) V^T from random rotations with singular
+   values spread over a chosen condition number, rounded to float, and every
+   operation is compared against a compensated double reference computed from
+   those same float inputs. Errors are binned per decade of the (measured)
+   condition number. */
+
+enum class Profile_op { Transform, Product, Determinant, Inverse, Solve, Count };
+enum class Profile_precision { Float, Double, Compensated, Count };
+
+const char* profile_op_name(Profile_op op);
+const char* profile_precision_name(Profile_precision precision);
+
+/* Error-free transformations and compensated kernels (Ogita, Rump and Oishi,
+   "Accurate sum and dot product"), for T = float or double. Results are as
+   accurate as if computed in twice the working precision, then rounded. */
+template <typename T> T dot2(const T* a, const T* b, int n);
+/* a * b - c * d with one rounding error (Kahan's fma trick). */
+template <typename T> T difference_of_products(T a, T b, T c, T d);
+template <typename T> glm::mat<3, 3, T> compensated_product(const glm::mat<3, 3, T>& a, const glm::mat<3, 3, T>& b);
+template <typename T> glm::vec<3, T> compensated_transform(const glm::mat<3, 3, T>& m, const glm::vec<3, T>& v);
+template <typename T> T compensated_determinant(const glm::mat<3, 3, T>& m);
+template <typename T> glm::mat<3, 3, T> compensated_inverse(const glm::mat<3, 3, T>& m);
+/* M x = b by Gaussian elimination with partial pivoting; the compensated
+   solve adds one step of iterative refinement on a dot2 residual. */
+template <typename T> glm::vec<3, T> gaussian_solve(const glm::mat<3, 3, T>& m, const glm::vec<3, T>& b);
+template <typename T> glm::vec<3, T> compensated_solve(const glm::mat<3, 3, T>& m, const glm::vec<3, T>& b);
+
+struct Condition_profile {
+	static const int ConditionBins = 9;			// 1e0, 1e1, ... 1e7, >= 1e8
+	static const int ErrorBins = 80;			// log10(relative error) in quarter decades
+	static constexpr double ErrorFloor = -18.0;	// first error bin starts at 1e-18
+	static const int Ops = static_cast<int>(Profile_op::Count);
+	static const int Precisions = static_cast<int>(Profile_precision::Count);
+
+	uint64_t histogram[Ops][Precisions][ConditionBins][ErrorBins] = {};
+	double max_error[Ops][Precisions][ConditionBins] = {};	// finite errors only
+	uint64_t non_finite[Ops][Precisions][ConditionBins] = {};	// inf or NaN results, kept out of the bins
+	uint64_t samples[ConditionBins] = {};
+	double milliseconds = 0.0;
+
+	void add(Profile_op op, Profile_precision precision, int conditionBin, double error);
+	void merge(const Condition_profile& other);
+	/* Upper edge of the bin holding the given quantile (0..1) of the errors;
+	   non-finite errors rank above every bin, so a quantile among them is inf. */
+	double quantile(Profile_op op, Profile_precision precision, int conditionBin, double q) const;
+};
+
+/* samples matrices per run, log10 condition numbers uniform in [0, maxLogCondition].
+   Sharded like the property tests, so it is reproducible from the seed. */
+Condition_profile profile_condition(uint64_t samples, uint64_t seed, double maxLogCondition = 8.0);
+
+/* Per-decade p50/p99/max/non-finite tables, and for every operation the largest condition
+   number at which each precision keeps its p99 relative error below tolerance. */
+void print_condition_profile(const Condition_profile& profile, double tolerance);
@@ -0,0 +1,36 @@
+#include "FastTrig.h"
+#include "Parallel.h"
+
+#include <cmath>
+
+static const size_t MinChunk = 16384;
+
+void Exact_trig::sincos(float x, float& s, float& c) {
+	s = std::sin(x);
+	c = std::cos(x);
+}
+
+void Exact_trig::sincos_batch(const float* x, float* s, float* c, size_t n) {
+	parallelFor(0, n, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			s[i] = std::sin(x[i]);
+			c[i] = std::cos(x[i]);
+		}
+	}, MinChunk);
+}
+
+void Fast_trig::sincos_batch(const float* x, float* s, float* c, size_t n) {
+	parallelFor(0, n, [&](size_t begin, size_t end) {
+		size_t i = begin;
+#if defined(SIMD_LANES)
+		typedef simd::Pack<float> P;
+		for (; i + P::Width <= end; i += P::Width) {
+			P ps, pc;
+			lanes(P::load(x + i), ps, pc);
+			ps.store(s + i);
+			pc.store(c + i);
+		}
+#endif
+		for (; i < end; i++) lanes(x[i], s[i], c[i]);
+	}, MinChunk);
+}
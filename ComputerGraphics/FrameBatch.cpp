@@ -0,0 +1,88 @@
+#include "FrameBatch.h"
+#include "Parallel.h"
+#include "SimdLane.h"
+
+#include <algorithm>
+#include <cmath>
+
+/* |up x v|^2 below this (v unit, up unit) means v is within about 0.06
+   degrees of up and the cross product is mostly rounding noise. Just above
+   it the cross product has lost about three digits to cancellation, so w is
+   projected back off v before it is normalised. */
+static const float Parallel2 = 1.0e-6f;
+
+void create_coordinate_frame_batch(const Vec3SoA& views, glm::vec3 up, Frame_batch& frames) {
+	const size_t n = views.size();
+	frames.resize(n);
+	const glm::vec3 k = glm::normalize(up);
+	const float* vx = views.x.data(); const float* vy = views.y.data(); const float* vz = views.z.data();
+	float* ux = frames.u.x.data(); float* uy = frames.u.y.data(); float* uz = frames.u.z.data();
+	float* nx = frames.v.x.data(); float* ny = frames.v.y.data(); float* nz = frames.v.z.data();
+	float* wx = frames.w.x.data(); float* wy = frames.w.y.data(); float* wz = frames.w.z.data();
+
+	parallelFor(0, n, [&](size_t begin, size_t end) {
+		size_t i = begin;
+#if defined(SIMD_LANES)
+		using namespace simd;
+		const Lane upx = splat(k.x), upy = splat(k.y), upz = splat(k.z);
+		const Lane one = splat(1.0f), limit = splat(Parallel2);
+		for (; i + Width <= end; i += Width) {
+			/* v = normalize(view) */
+			Lane x = load(vx + i), y = load(vy + i), z = load(vz + i);
+			const Lane inv = div(one, sqrt(add(add(mul(x, x), mul(y, y)), mul(z, z))));
+			x = mul(x, inv); y = mul(y, inv); z = mul(z, inv);
+
+			/* w from up x v, with the rounding along v removed ... */
+			Lane cx = sub(mul(upy, z), mul(upz, y));
+			Lane cy = sub(mul(upz, x), mul(upx, z));
+			Lane cz = sub(mul(upx, y), mul(upy, x));
+			const Lane along = add(add(mul(cx, x), mul(cy, y)), mul(cz, z));
+			cx = sub(cx, mul(along, x)); cy = sub(cy, mul(along, y)); cz = sub(cz, mul(along, z));
+			const Lane len2 = add(add(mul(cx, cx), mul(cy, cy)), mul(cz, cz));
+			const Lane degenerate = less(len2, limit);
+			const Lane winv = div(one, sqrt(select(degenerate, one, len2)));
+
+			/* ... or the Duff et al. tangent of v when up x v vanishes. */
+			const Lane s = sign(z);
+			const Lane a = div(splat(-1.0f), add(s, z));
+			const Lane bx = add(one, mul(mul(s, mul(x, x)), a));
+			const Lane by = mul(s, mul(mul(x, y), a));
+			const Lane bz = sub(splat(0.0f), mul(s, x));
+
+			const Lane tx = select(degenerate, bx, mul(cx, winv));
+			const Lane ty = select(degenerate, by, mul(cy, winv));
+			const Lane tz = select(degenerate, bz, mul(cz, winv));
+			store(nx + i, x); store(ny + i, y); store(nz + i, z);
+			store(wx + i, tx); store(wy + i, ty); store(wz + i, tz);
+			/* u = v x w is unit already: v and w are orthonormal. */
+			store(ux + i, sub(mul(y, tz), mul(z, ty)));
+			store(uy + i, sub(mul(z, tx), mul(x, tz)));
+			store(uz + i, sub(mul(x, ty), mul(y, tx)));
+		}
+#endif
+		for (; i < end; i++) {
+			const float inv = 1.0f / std::sqrt(vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+			const float x = vx[i] * inv, y = vy[i] * inv, z = vz[i] * inv;
+			float cx = k.y * z - k.z * y, cy = k.z * x - k.x * z, cz = k.x * y - k.y * x;
+			const float along = cx * x + cy * y + cz * z;
+			cx -= along * x; cy -= along * y; cz -= along * z;
+			const float len2 = cx * cx + cy * cy + cz * cz;
+			float tx, ty, tz;
+			if (len2 < Parallel2) {
+				const float s = std::copysign(1.0f, z);
+				const float a = -1.0f / (s + z);
+				tx = 1.0f + s * x * x * a;
+				ty = s * x * y * a;
+				tz = -s * x;
+			} else {
+				const float winv = 1.0f / std::sqrt(len2);
+				tx = cx * winv; ty = cy * winv; tz = cz * winv;
+			}
+			nx[i] = x; ny[i] = y; nz[i] = z;
+			wx[i] = tx; wy[i] = ty; wz[i] = tz;
+			ux[i] = y * tz - z * ty;
+			uy[i] = z * tx - x * tz;
+			uz[i] = x * ty - y * tx;
+		}
+	}, 65536);
+}
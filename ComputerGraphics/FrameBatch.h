@@ -0,0 +1,19 @@
+#pragma once
+
+#include "SoA.h"
+
+/* Orthonormal frames in the layout of create_coordinate_frame: v along the
+   view direction, w = normalize(up x v), u = v x w. */
+struct Frame_batch {
+	Vec3SoA u, v, w;
+
+	void resize(size_t n) { u.resize(n); v.resize(n); w.resize(n); }
+	size_t size() const { return v.size(); }
+};
+
+/* Builds one frame per non-zero view vector. Where a view is (nearly)
+   parallel to up, w comes from the branchless Frisvad/Duff basis of v
+   instead, so every frame is finite and orthonormal. Both candidates are
+   computed for every lane and blended with a mask, so degenerate inputs cost
+   the same as regular ones. Large batches are split across worker threads. */
+void create_coordinate_frame_batch(const Vec3SoA& views, glm::vec3 up, Frame_batch& frames);
@@ -0,0 +1,473 @@
+#include "FrameCapture.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+const char* captureFormatName(CaptureFormat format) {
+	switch (format) {
+	case CaptureFormat::Y4m: return "y4m";
+	case CaptureFormat::Ppm: return "ppm";
+	case CaptureFormat::Png: return "png";
+	}
+	return "?";
+}
+
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+//////////////////////////////////////////////////////////////////////// ENCODING
+
+/* Readbacks are RGBA rows bottom-up; every format wants them top-down. */
+static const uint8_t* sourceRow(const uint8_t* rgba, int width, int height, int row) {
+	return rgba + static_cast<size_t>(height - 1 - row) * width * 4;
+}
+
+/* Full-range BT.601 (C420jpeg) in 8.8 fixed point, chroma from 2x2 averages. */
+static void encodeY4mFrame(const uint8_t* rgba, int width, int height, std::vector<uint8_t>& out) {
+	const int cw = (width + 1) / 2, ch = (height + 1) / 2;
+	const char tag[] = "FRAME\n";
+	const size_t header = sizeof(tag) - 1;
+	out.resize(header + static_cast<size_t>(width) * height + 2 * static_cast<size_t>(cw) * ch);
+	std::copy(tag, tag + header, out.begin());
+	uint8_t* y = out.data() + header;
+	uint8_t* u = y + static_cast<size_t>(width) * height;
+	uint8_t* v = u + static_cast<size_t>(cw) * ch;
+
+	for (int row = 0; row < height; row++) {
+		const uint8_t* p = sourceRow(rgba, width, height, row);
+		uint8_t* dst = y + static_cast<size_t>(row) * width;
+		for (int x = 0; x < width; x++, p += 4) {
+			dst[x] = static_cast<uint8_t>((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+		}
+	}
+	for (int cy = 0; cy < ch; cy++) {
+		const uint8_t* row0 = sourceRow(rgba, width, height, 2 * cy);
+		const uint8_t* row1 = sourceRow(rgba, width, height, std::min(2 * cy + 1, height - 1));
+		for (int cx = 0; cx < cw; cx++) {
+			const int x0 = 8 * cx, x1 = 4 * std::min(2 * cx + 1, width - 1);
+			const int r = (row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) >> 2;
+			const int g = (row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1] + 2) >> 2;
+			const int b = (row0[x0 + 2] + row0[x1 + 2] + row1[x0 + 2] + row1[x1 + 2] + 2) >> 2;
+			const size_t i = static_cast<size_t>(cy) * cw + cx;
+			u[i] = static_cast<uint8_t>(std::min(255, (-43 * r - 85 * g + 128 * b + 32896) >> 8));
+			v[i] = static_cast<uint8_t>(std::min(255, (128 * r - 107 * g - 21 * b + 32896) >> 8));
+		}
+	}
+}
+
+static void encodePpm(const uint8_t* rgba, int width, int height, std::vector<uint8_t>& out) {
+	char header[64];
+	const int length = std::snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+	out.resize(length + static_cast<size_t>(width) * height * 3);
+	std::copy(header, header + length, out.begin());
+	uint8_t* dst = out.data() + length;
+	for (int row = 0; row < height; row++) {
+		const uint8_t* p = sourceRow(rgba, width, height, row);
+		for (int x = 0; x < width; x++, p += 4, dst += 3) {
+			dst[0] = p[0];
+			dst[1] = p[1];
+			dst[2] = p[2];
+		}
+	}
+}
+
+static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+	static const std::array<uint32_t, 256> table = [] {
+		std::array<uint32_t, 256> t = {};
+		for (uint32_t n = 0; n < 256; n++) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			t[n] = c;
+		}
+		return t;
+	}();
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+	for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+static void putChunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t size) {
+	putBigEndian(out, static_cast<uint32_t>(size));
+	const size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data, data + size);
+	putBigEndian(out, crc32(out.data() + start, size + 4));
+}
+
+/* Deflate bits go out least significant first; Huffman codes most
+   significant first, so those are reversed before they are put. */
+class BitWriter {
+public:
+	explicit BitWriter(std::vector<uint8_t>& out) : Out(out) {}
+
+	void put(uint32_t bits, int count) {
+		Buffer |= static_cast<uint64_t>(bits) << Count;
+		Count += count;
+		while (Count >= 8) {
+			Out.push_back(static_cast<uint8_t>(Buffer));
+			Buffer >>= 8;
+			Count -= 8;
+		}
+	}
+	void putCode(uint32_t code, int length) {
+		uint32_t reversed = 0;
+		for (int i = 0; i < length; i++) reversed |= ((code >> i) & 1) << (length - 1 - i);
+		put(reversed, length);
+	}
+	void flush() {
+		if (Count > 0) Out.push_back(static_cast<uint8_t>(Buffer));
+		Buffer = 0;
+		Count = 0;
+	}
+
+private:
+	std::vector<uint8_t>& Out;
+	uint64_t Buffer = 0;
+	int Count = 0;
+};
+
+/* The fixed literal/length code of RFC 1951, 3.2.6. */
+static void putLiteral(BitWriter& bits, int symbol) {
+	if (symbol < 144) bits.putCode(0x30 + symbol, 8);
+	else if (symbol < 256) bits.putCode(0x190 + symbol - 144, 9);
+	else if (symbol < 280) bits.putCode(symbol - 256, 7);
+	else bits.putCode(0xC0 + symbol - 280, 8);
+}
+
+static void putMatch(BitWriter& bits, int length, int distance) {
+	static const uint16_t LengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const uint8_t LengthExtra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const uint16_t DistanceBase[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const uint8_t DistanceExtra[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	int l = 28;
+	while (LengthBase[l] > length) l--;
+	putLiteral(bits, 257 + l);
+	bits.put(length - LengthBase[l], LengthExtra[l]);
+	int d = 29;
+	while (DistanceBase[d] > distance) d--;
+	bits.putCode(d, 5);
+	bits.put(distance - DistanceBase[d], DistanceExtra[d]);
+}
+
+/* One fixed-Huffman block with greedy LZ77 over a 32K window. Rendered
+   frames are mostly flat color, so the runs (distance 3) and repeated rows
+   (distance = stride) this finds are most of the saving; dynamic Huffman
+   tables would add little for their cost on the writer threads. */
+static void deflateFixed(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+	const int HashBits = 15, MaxChain = 8, MinMatch = 3, MaxMatch = 258;
+	const size_t Window = 32768;
+	std::vector<int32_t> head(size_t(1) << HashBits, -1), prev(Window, -1);
+	auto hash = [&](size_t i) {
+		return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & ((1 << HashBits) - 1);
+	};
+	auto insert = [&](size_t i) {
+		if (i + MinMatch > size) return;
+		const int h = hash(i);
+		prev[i & (Window - 1)] = head[h];
+		head[h] = static_cast<int32_t>(i);
+	};
+
+	BitWriter bits(out);
+	bits.put(1, 1);	// final block
+	bits.put(1, 2);	// fixed Huffman codes
+	size_t i = 0;
+	while (i < size) {
+		int bestLength = 0, bestDistance = 0;
+		if (i + MinMatch <= size) {
+			const int limit = static_cast<int>(std::min<size_t>(MaxMatch, size - i));
+			int32_t candidate = head[hash(i)];
+			for (int chain = 0; chain < MaxChain && candidate >= 0 && i - candidate <= Window; chain++) {
+				const uint8_t* a = data + candidate;
+				const uint8_t* b = data + i;
+				int length = 0;
+				while (length < limit && a[length] == b[length]) length++;
+				if (length > bestLength) {
+					bestLength = length;
+					bestDistance = static_cast<int>(i - candidate);
+					if (length == limit) break;
+				}
+				candidate = prev[candidate & (Window - 1)];
+			}
+		}
+		if (bestLength >= MinMatch) {
+			putMatch(bits, bestLength, bestDistance);
+			for (int k = 0; k < bestLength; k++) insert(i + k);
+			i += bestLength;
+		} else {
+			putLiteral(bits, data[i]);
+			insert(i);
+			i++;
+		}
+	}
+	putLiteral(bits, 256);	// end of block
+	bits.flush();
+}
+
+/* RGB, filter 0 on every row, deflated into a zlib stream. */
+static void encodePng(const uint8_t* rgba, int width, int height, std::vector<uint8_t>& out,
+	std::vector<uint8_t>& raw, std::vector<uint8_t>& zlib) {
+	const size_t stride = 1 + static_cast<size_t>(width) * 3;
+	raw.resize(stride * height);
+	uint32_t a = 1, b = 0;	// Adler-32 of the filtered rows
+	for (int row = 0; row < height; row++) {
+		const uint8_t* p = sourceRow(rgba, width, height, row);
+		uint8_t* dst = raw.data() + row * stride;
+		*dst++ = 0;
+		for (int x = 0; x < width; x++, p += 4, dst += 3) {
+			dst[0] = p[0];
+			dst[1] = p[1];
+			dst[2] = p[2];
+		}
+		for (size_t k = 0; k < stride; k++) {
+			a += raw[row * stride + k];
+			b += a;
+			if ((k & 2047) == 2047) {	// keeps b within 32 bits
+				a %= 65521;
+				b %= 65521;
+			}
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+
+	zlib.clear();
+	zlib.push_back(0x78);	// deflate, 32K window
+	zlib.push_back(0x01);	// fastest level, check bits
+	deflateFixed(raw.data(), raw.size(), zlib);
+	putBigEndian(zlib, (b << 16) | a);
+
+	static const uint8_t Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	out.assign(Signature, Signature + sizeof(Signature));
+	uint8_t ihdr[13] = {
+		static_cast<uint8_t>(width >> 24), static_cast<uint8_t>(width >> 16), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width),
+		static_cast<uint8_t>(height >> 24), static_cast<uint8_t>(height >> 16), static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+		8, 2, 0, 0, 0 };	// 8 bits, RGB, deflate, adaptive filters, no interlace
+	putChunk(out, "IHDR", ihdr, sizeof(ihdr));
+	putChunk(out, "IDAT", zlib.data(), zlib.size());
+	putChunk(out, "IEND", nullptr, 0);
+}
+
+/////////////////////////////////////////////////////////////////////// CAPTURE
+
+FrameCapture::~FrameCapture() {
+	/* Slots still being read back need the context to be collected and
+	   their buffers freed, so stop() must have run before this. */
+	assert(!Active && "FrameCapture destroyed while capturing; call stop() first");
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		Stopping = true;
+	}
+	Changed.notify_all();
+	for (std::thread& writer : Writers) writer.join();
+}
+
+void FrameCapture::start(const std::string& path, int fps) {
+	stop();
+	const size_t dot = path.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	if (extension == "y4m") Format = CaptureFormat::Y4m;
+	else if (extension == "ppm") Format = CaptureFormat::Ppm;
+	else if (extension == "png") Format = CaptureFormat::Png;
+	else {
+		std::cerr << "[ERROR] Unknown capture format: " << path << std::endl;
+		throw std::runtime_error("Failed to start capture.");
+	}
+	Path = path;
+	Stem = path.substr(0, dot);
+	Extension = path.substr(dot);
+	Fps = std::max(fps, 1);
+	if (Format == CaptureFormat::Y4m) {
+		Stream.open(path, std::ios::binary | std::ios::trunc);
+		if (!Stream) {
+			std::cerr << "[ERROR] Cannot write capture: " << path << std::endl;
+			throw std::runtime_error("Failed to start capture.");
+		}
+	}
+	StreamWidth = StreamHeight = 0;
+	Frames = 0;
+	Stats = CaptureStats();
+	Queue.clear();
+	Stopping = false;
+	/* One stream must be written in order; images are independent. */
+	const unsigned writers = Format == CaptureFormat::Y4m ? 1 : std::clamp(workerCount() - 1, 1u, 3u);
+	for (unsigned i = 0; i < writers; i++) Writers.emplace_back(&FrameCapture::writerLoop, this);
+	Active = true;
+}
+
+void FrameCapture::stop() {
+	if (!Active) return;
+	collect(true);
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		Stopping = true;
+	}
+	Changed.notify_all();
+	for (std::thread& writer : Writers) writer.join();
+	Writers.clear();
+	if (Stream.is_open()) Stream.close();
+	for (Slot& slot : Ring) {
+		if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+		slot = Slot();
+	}
+	Active = false;
+	const CaptureStats stats = Stats;
+	std::cout << "[capture] " << stats.Written << " frames to " << Path;
+	if (stats.Skipped) std::cout << ", " << stats.Skipped << " skipped (size changed)";
+	std::cout << std::endl;
+}
+
+/* Hands finished readbacks to the writers, oldest first so a stream stays
+   in order. With wait, blocks until every pending readback is done. */
+void FrameCapture::collect(bool wait) {
+	for (;;) {
+		Slot* oldest = nullptr;
+		for (Slot& slot : Ring) {
+			if (slot.state == SlotState::Reading && (!oldest || slot.frame < oldest->frame)) oldest = &slot;
+		}
+		if (!oldest) return;
+		GLenum status = glClientWaitSync(oldest->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (wait && status == GL_TIMEOUT_EXPIRED) status = glClientWaitSync(oldest->fence, 0, 100000000);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return;
+		glDeleteSync(oldest->fence);
+		oldest->fence = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			oldest->state = SlotState::Writing;
+			Queue.push_back(static_cast<int>(oldest - Ring));
+		}
+		Changed.notify_all();
+	}
+}
+
+void FrameCapture::capture(int width, int height) {
+	if (!Active || width <= 0 || height <= 0) return;
+	const auto start = std::chrono::high_resolution_clock::now();
+	collect(false);
+
+	auto freeSlot = [this]() -> Slot* {
+		for (Slot& slot : Ring) {
+			if (slot.state == SlotState::Free) return &slot;
+		}
+		return nullptr;
+	};
+	Slot* slot;
+	{
+		std::unique_lock<std::mutex> lock(Lock);
+		slot = freeSlot();
+	}
+	if (!slot) {
+		/* The writers are behind: wait rather than drop a frame. */
+		const auto stall = std::chrono::high_resolution_clock::now();
+		collect(true);
+		std::unique_lock<std::mutex> lock(Lock);
+		Changed.wait(lock, [&] { return (slot = freeSlot()) != nullptr; });
+		Stats.StallMs += millisecondsSince(stall);
+	}
+
+	const GLsizeiptr bytes = static_cast<GLsizeiptr>(width) * height * 4;
+	if (slot->capacity < bytes) {
+		const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		if (slot->pbo) glDeleteBuffers(1, &slot->pbo);
+		glGenBuffers(1, &slot->pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+		glBufferStorage(GL_PIXEL_PACK_BUFFER, bytes, nullptr, flags);
+		slot->mapped = static_cast<const uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, flags));
+		slot->capacity = bytes;
+		if (!slot->mapped) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			throw std::runtime_error("Failed to map capture buffer.");
+		}
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->width = width;
+	slot->height = height;
+	slot->frame = Frames++;
+
+	std::lock_guard<std::mutex> lock(Lock);
+	slot->state = SlotState::Reading;
+	Stats.Captured++;
+	Stats.RenderMs += millisecondsSince(start);
+}
+
+CaptureStats FrameCapture::stats() const {
+	std::lock_guard<std::mutex> lock(Lock);
+	return Stats;
+}
+
+//////////////////////////////////////////////////////////////////////// WRITERS
+
+void FrameCapture::writerLoop() {
+	std::vector<uint8_t> scratch;
+	for (;;) {
+		int index;
+		{
+			std::unique_lock<std::mutex> lock(Lock);
+			Changed.wait(lock, [this] { return Stopping || !Queue.empty(); });
+			if (Queue.empty()) return;
+			index = Queue.front();
+			Queue.erase(Queue.begin());
+		}
+		const auto start = std::chrono::high_resolution_clock::now();
+		write(Ring[index], scratch);
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			Ring[index].state = SlotState::Free;
+			Stats.WriteMs += millisecondsSince(start);
+		}
+		Changed.notify_all();
+	}
+}
+
+void FrameCapture::write(const Slot& slot, std::vector<uint8_t>& scratch) {
+	if (Format == CaptureFormat::Y4m) {
+		if (StreamWidth == 0) {
+			StreamWidth = slot.width;
+			StreamHeight = slot.height;
+			Stream << "YUV4MPEG2 W" << StreamWidth << " H" << StreamHeight << " F" << Fps << ":1 Ip A1:1 C420jpeg\n";
+		}
+		if (slot.width != StreamWidth || slot.height != StreamHeight) {
+			std::lock_guard<std::mutex> lock(Lock);
+			Stats.Skipped++;
+			return;
+		}
+		encodeY4mFrame(slot.mapped, slot.width, slot.height, scratch);
+		Stream.write(reinterpret_cast<const char*>(scratch.data()), static_cast<std::streamsize>(scratch.size()));
+	} else {
+		char number[16];
+		std::snprintf(number, sizeof(number), "_%06llu", static_cast<unsigned long long>(slot.frame));
+		if (Format == CaptureFormat::Ppm) {
+			encodePpm(slot.mapped, slot.width, slot.height, scratch);
+		} else {
+			thread_local std::vector<uint8_t> raw, zlib;
+			encodePng(slot.mapped, slot.width, slot.height, scratch, raw, zlib);
+		}
+		std::ofstream file(Stem + number + Extension, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(scratch.data()), static_cast<std::streamsize>(scratch.size()));
+		if (!file) {
+			std::cerr << "[ERROR] Cannot write capture: " << Stem + number + Extension << std::endl;
+			return;
+		}
+	}
+	std::lock_guard<std::mutex> lock(Lock);
+	Stats.Written++;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mgl.hpp>
+
+enum class CaptureFormat {
+	Y4m,	// one raw YUV 4:2:0 stream, playable and encodable by ffmpeg
+	Ppm,	// numbered raw RGB images
+	Png		// numbered PNG images
+};
+
+const char* captureFormatName(CaptureFormat format);
+
+struct CaptureStats {
+	uint64_t Captured = 0;		// readbacks issued
+	uint64_t Written = 0;		// frames on disk
+	uint64_t Skipped = 0;		// Y4M frames whose size differs from the stream's
+	double RenderMs = 0.0;		// render thread: issuing readbacks and handing them over
+	double StallMs = 0.0;		// the part of RenderMs spent waiting for a free slot
+	double WriteMs = 0.0;		// writer threads: conversion, encoding and I/O
+};
+
+/* Records rendered frames without stalling the render thread. Each frame is
+   read into a persistently mapped pixel buffer with glReadPixels, which
+   only queues the copy. A later capture() sees the buffer's fence signalled
+   and hands the mapped pixels to the writer threads; the slot is reused
+   once they are done with it. Only a full ring, when the writers fall
+   behind, makes the render thread wait.
+
+   Y4M frames are converted to YUV and appended by one writer, in order.
+   Image sequences are encoded by several writers, one frame each. The
+   tree has no zlib, so PNGs are deflated here with fixed Huffman codes and
+   greedy LZ77: flat-shaded frames shrink about a hundredfold, at roughly
+   16 ms per 720p frame per writer. */
+class FrameCapture {
+public:
+	static constexpr int Slots = 6;
+
+	FrameCapture() = default;
+	~FrameCapture();
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	/* The format comes from the extension of path: .y4m writes that file,
+	   .ppm and .png write name_000000.ext, name_000001.ext, ... fps is only
+	   recorded in the Y4M header; frames are the frames rendered. */
+	void start(const std::string& path, int fps);
+	/* Completes every readback, waits for the writers and closes the output.
+	   Needs the GL context, and must run before destruction. */
+	void stop();
+	bool active() const { return Active; }
+	CaptureFormat format() const { return Format; }
+	const std::string& path() const { return Path; }
+
+	/* Queues a readback of the lower-left width x height pixels of the read
+	   framebuffer, after the frame is drawn. */
+	void capture(int width, int height);
+
+	CaptureStats stats() const;
+
+private:
+	enum class SlotState { Free, Reading, Writing };
+
+	struct Slot {
+		GLuint pbo = 0;
+		const uint8_t* mapped = nullptr;
+		GLsizeiptr capacity = 0;
+		GLsync fence = nullptr;
+		int width = 0, height = 0;
+		uint64_t frame = 0;
+		SlotState state = SlotState::Free;
+	};
+
+	Slot Ring[Slots];
+	std::vector<int> Queue;			// slots handed to the writers, oldest first
+	std::vector<std::thread> Writers;
+	mutable std::mutex Lock;
+	std::condition_variable Changed;
+	bool Stopping = false;
+
+	bool Active = false;
+	CaptureFormat Format = CaptureFormat::Y4m;
+	std::string Path, Stem, Extension;
+	int Fps = 60;
+	std::ofstream Stream;			// the Y4M file
+	int StreamWidth = 0, StreamHeight = 0;
+	uint64_t Frames = 0;
+	CaptureStats Stats;
+
+	void collect(bool wait);
+	void writerLoop();
+	void write(const Slot& slot, std::vector<uint8_t>& scratch);
+};
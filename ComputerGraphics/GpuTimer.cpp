@@ -0,0 +1,35 @@
+#include "GpuTimer.h"
+
+GpuTimer::~GpuTimer() {
+	if (Queries[0]) glDeleteQueries(Slots, Queries);
+}
+
+void GpuTimer::create() {
+	glGenQueries(Slots, Queries);
+}
+
+void GpuTimer::begin() {
+	Active = !Busy[Next];
+	if (Active) glBeginQuery(GL_TIME_ELAPSED, Queries[Next]);
+}
+
+void GpuTimer::end() {
+	if (!Active) return;
+	glEndQuery(GL_TIME_ELAPSED);
+	Busy[Next] = true;
+	Next = (Next + 1) % Slots;
+	Active = false;
+}
+
+bool GpuTimer::poll(double& milliseconds) {
+	if (!Busy[Oldest]) return false;
+	GLint available = 0;
+	glGetQueryObjectiv(Queries[Oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) return false;
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(Queries[Oldest], GL_QUERY_RESULT, &nanoseconds);
+	milliseconds = static_cast<double>(nanoseconds) * 1.0e-6;
+	Busy[Oldest] = false;
+	Oldest = (Oldest + 1) % Slots;
+	return true;
+}
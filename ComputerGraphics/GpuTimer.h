@@ -0,0 +1,27 @@
+#pragma once
+
+#include <mgl.hpp>
+
+/* GPU time of a span of commands, from GL_TIME_ELAPSED queries. A small ring
+   lets a span start every frame while older ones are still in flight, and
+   results are read back without stalling, a few frames late. Spans of one
+   timer must not nest or overlap another GL_TIME_ELAPSED query. */
+class GpuTimer {
+public:
+	static constexpr int Slots = 4;
+
+	~GpuTimer();
+
+	void create();
+	/* Starts a span; skipped (with its end) when every slot is in flight. */
+	void begin();
+	void end();
+	/* The oldest finished span, in milliseconds. */
+	bool poll(double& milliseconds);
+
+private:
+	GLuint Queries[Slots] = {};
+	bool Busy[Slots] = {};
+	int Next = 0, Oldest = 0;
+	bool Active = false;
+};
@@ -0,0 +1,76 @@
+#include "LayerCache.h"
+
+LayerCache::~LayerCache() {
+	mgl::Engine::getInstance().getTargets().release(Target);
+	if (Vao) glDeleteVertexArrays(1, &Vao);
+}
+
+void LayerCache::create(int width, int height) {
+	Shaders = std::make_unique<mgl::ShaderProgram>();
+	Shaders->addShader(GL_VERTEX_SHADER, "composite-vs.glsl");
+	Shaders->addShader(GL_FRAGMENT_SHADER, "composite-fs.glsl");
+	Shaders->addUniform("Layers");
+	Shaders->create();
+	LayersId = Shaders->Uniforms["Layers"].index;
+
+	/* The full-screen triangle has no attributes, but core profile still
+	   wants a vertex array bound to draw. */
+	glGenVertexArrays(1, &Vao);
+
+	resize(width, height);
+}
+
+void LayerCache::resize(int width, int height) {
+	if (width == Width && height == Height && Target) return;
+	mgl::RenderTargetPool& targets = mgl::Engine::getInstance().getTargets();
+	targets.release(Target);
+	Width = width;
+	Height = height;
+	mgl::RenderTargetDesc desc;
+	desc.Width = width;
+	desc.Height = height;
+	desc.Depth = GL_DEPTH_COMPONENT24;
+	desc.Sampled = true;
+	Target = targets.acquire(desc);
+	Valid = false;
+}
+
+void LayerCache::setCut(int cut) {
+	if (cut == Cut) return;
+	Cut = cut;
+	Valid = false;
+}
+
+void LayerCache::setEnabled(bool enabled) {
+	Enabled = enabled;
+	Valid = false;
+}
+
+void LayerCache::begin() {
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &Previous);
+	glBindFramebuffer(GL_FRAMEBUFFER, Target->Fbo);
+	glViewport(0, 0, Width, Height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void LayerCache::end() {
+	glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(Previous));
+	Valid = true;
+	Rebuilds++;
+}
+
+void LayerCache::composite() const {
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	Shaders->bind();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, Target->Color);
+	glUniform1i(LayersId, 0);
+	glBindVertexArray(Vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	Shaders->unbind();
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+}
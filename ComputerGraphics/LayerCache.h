@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+
+#include <mgl.hpp>
+
+/* The static layers of the scene, rendered once into a texture and
+   composited back each frame with a single full-screen triangle. The cache
+   holds every layer below a cut; layers at or above it are dynamic and are
+   drawn over the composite as usual, so they are always in front of what
+   the cache holds and blending against it stays exact.
+
+   The cache is rebuilt only after invalidate(): when the cut moves, the
+   render target is resized, or something inside a static layer changes. */
+class LayerCache {
+public:
+	LayerCache() = default;
+	~LayerCache();
+
+	void create(int width, int height);
+	void resize(int width, int height);
+
+	/* Layers below cut are static. A new cut invalidates the cache. */
+	void setCut(int cut);
+	int cut() const { return Cut; }
+	void invalidate() { Valid = false; }
+	bool valid() const { return Valid; }
+	/* Off, every layer is drawn live each frame. */
+	bool enabled() const { return Enabled; }
+	void setEnabled(bool enabled);
+
+	/* Binds the cache target, cleared, for drawing the static layers into.
+	   end() restores the previous target and marks the cache valid. */
+	void begin();
+	void end();
+
+	/* Draws the cached layers over whatever is bound, depth untouched and
+	   clipped by the current scissor. */
+	void composite() const;
+
+	int rebuilds() const { return Rebuilds; }
+
+private:
+	std::unique_ptr<mgl::ShaderProgram> Shaders;
+	GLint LayersId = -1;
+	GLuint Vao = 0;
+	mgl::RenderTarget* Target = nullptr;	// from the engine's pool
+	GLint Previous = 0;
+	int Width = 0, Height = 0;
+	int Cut = 0;
+	bool Valid = false;
+	bool Enabled = true;
+	int Rebuilds = 0;
+};
@@ -0,0 +1,308 @@
+#include "MatrixBatch.h"
+#include "Parallel.h"
+#include "SimdLane.h"
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+/* Each kernel is a generic lambda over its value type V, run on simd::Pack<T>
+   for whole lane groups and on plain T for the tail (or for everything when
+   the target has no SIMD for T). The singular case is a select, not a
+   branch, so lanes never diverge. */
+
+static const size_t MinChunk = 16384;
+
+template <typename T>
+static inline T tolerance() {
+	return T(4) * std::numeric_limits<T>::epsilon();
+}
+
+/* Scalar counterparts of the Pack mask operations. */
+template <typename T>
+static inline T select(bool mask, T a, T b) {
+	return mask ? a : b;
+}
+static inline unsigned bits(bool mask) {
+	return mask ? 1u : 0u;
+}
+
+template <typename V, typename T>
+static inline V loadAs(const T* p) {
+	if constexpr (std::is_same<V, T>::value) return *p;
+	else return V::load(p);
+}
+template <typename V, typename T>
+static inline void storeAs(T* p, const V& v) {
+	if constexpr (std::is_same<V, T>::value) *p = v;
+	else v.store(p);
+}
+template <typename V, typename T>
+static constexpr size_t widthOf() {
+	if constexpr (std::is_same<V, T>::value) return 1;
+	else return V::Width;
+}
+
+template <typename T, typename Kernel>
+static void forEachLane(size_t n, const Kernel& kernel) {
+	parallelFor(0, n, [&](size_t begin, size_t end) {
+		size_t i = begin;
+#if defined(SIMD_LANES)
+		if constexpr (simd::LaneOf<T>::Exists) {
+			typedef simd::Pack<T> P;
+			for (; i + P::Width <= end; i += P::Width) kernel(P(), i);
+		}
+#endif
+		for (; i < end; i++) kernel(T(), i);
+	}, MinChunk);
+}
+
+/* Pointers to the element streams, so loops index plain arrays. */
+template <int C, int R, typename T>
+struct Streams {
+	const T* a[C * R];
+	explicit Streams(const MatSoAT<C, R, T>& m) { for (int e = 0; e < C * R; e++) a[e] = m.m[e].data(); }
+};
+template <int C, int R, typename T>
+struct OutStreams {
+	T* a[C * R];
+	OutStreams(MatSoAT<C, R, T>& m, size_t n) { m.resize(n); for (int e = 0; e < C * R; e++) a[e] = m.m[e].data(); }
+};
+
+/* Cofactor matrix of the 3x3 with columns c0, c1, c2, which is det times the
+   inverse-transpose: its columns are c1 x c2, c2 x c0 and c0 x c1. Also
+   returns the determinant and the Hadamard bound |c0| |c1| |c2|. */
+template <typename V>
+static inline void cofactors3(const V m[9], V cof[9], V& det, V& bound) {
+	using std::sqrt;
+	cof[0] = m[4] * m[8] - m[5] * m[7];
+	cof[1] = m[5] * m[6] - m[3] * m[8];
+	cof[2] = m[3] * m[7] - m[4] * m[6];
+	cof[3] = m[7] * m[2] - m[8] * m[1];
+	cof[4] = m[8] * m[0] - m[6] * m[2];
+	cof[5] = m[6] * m[1] - m[7] * m[0];
+	cof[6] = m[1] * m[5] - m[2] * m[4];
+	cof[7] = m[2] * m[3] - m[0] * m[5];
+	cof[8] = m[0] * m[4] - m[1] * m[3];
+	det = m[0] * cof[0] + m[1] * cof[1] + m[2] * cof[2];
+	const V l0 = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+	const V l1 = m[3] * m[3] + m[4] * m[4] + m[5] * m[5];
+	const V l2 = m[6] * m[6] + m[7] * m[7] + m[8] * m[8];
+	bound = sqrt(l0 * l1 * l2);
+}
+
+/* 1 / det, or 0 where the matrix is singular; writes the singular mask. */
+template <typename V, typename T>
+static inline V inverseDeterminant(const V& det, const V& bound, uint8_t* singular) {
+	using std::abs;
+	const auto ok = V(tolerance<T>()) * bound < abs(det);	// false for NaN too
+	const unsigned okBits = bits(ok);
+	for (size_t l = 0; l < widthOf<V, T>(); l++) singular[l] = (okBits >> l) & 1u ? 0 : 1;
+	return select(ok, V(T(1)) / det, V(T(0)));
+}
+
+/* Load the upper-left 3x3 of stream matrix element i, column major. */
+template <typename V, int C, int R, typename T>
+static inline void load3(const Streams<C, R, T>& s, size_t i, V m[9]) {
+	for (int c = 0; c < 3; c++) for (int r = 0; r < 3; r++) m[c * 3 + r] = loadAs<V>(s.a[c * R + r] + i);
+}
+
+static size_t countSingular(const std::vector<uint8_t>& singular) {
+	size_t count = 0;
+	for (uint8_t s : singular) count += s;
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////// 3x3
+
+template <typename T>
+void determinant_batch(const MatSoAT<3, 3, T>& m, std::vector<T>& det) {
+	const size_t n = m.size();
+	det.resize(n);
+	const Streams<3, 3, T> in(m);
+	T* out = det.data();
+	forEachLane<T>(n, [&](auto zero, size_t i) {
+		typedef decltype(zero) V;
+		V a[9], cof[9], d, bound;
+		load3(in, i, a);
+		cofactors3(a, cof, d, bound);
+		storeAs(out + i, d);
+	});
+}
+
+template <typename T>
+size_t inverse_batch(const MatSoAT<3, 3, T>& m, MatSoAT<3, 3, T>& inverse, std::vector<uint8_t>& singular) {
+	const size_t n = m.size();
+	singular.resize(n);
+	const Streams<3, 3, T> in(m);
+	const OutStreams<3, 3, T> out(inverse, n);
+	uint8_t* mask = singular.data();
+	forEachLane<T>(n, [&](auto zero, size_t i) {
+		typedef decltype(zero) V;
+		V a[9], cof[9], det, bound;
+		load3(in, i, a);
+		cofactors3(a, cof, det, bound);
+		const V inv = inverseDeterminant<V, T>(det, bound, mask + i);
+		for (int c = 0; c < 3; c++) for (int r = 0; r < 3; r++) storeAs(out.a[c * 3 + r] + i, cof[r * 3 + c] * inv);
+	});
+	return countSingular(singular);
+}
+
+template <typename T>
+size_t inverse_transpose_batch(const MatSoAT<3, 3, T>& m, MatSoAT<3, 3, T>& result, std::vector<uint8_t>& singular) {
+	const size_t n = m.size();
+	singular.resize(n);
+	const Streams<3, 3, T> in(m);
+	const OutStreams<3, 3, T> out(result, n);
+	uint8_t* mask = singular.data();
+	forEachLane<T>(n, [&](auto zero, size_t i) {
+		typedef decltype(zero) V;
+		V a[9], cof[9], det, bound;
+		load3(in, i, a);
+		cofactors3(a, cof, det, bound);
+		const V inv = inverseDeterminant<V, T>(det, bound, mask + i);
+		for (int e = 0; e < 9; e++) storeAs(out.a[e] + i, cof[e] * inv);
+	});
+	return countSingular(singular);
+}
+
+////////////////////////////////////////////////////////////////////////// 4x4
+
+/* Laplace expansion by 2x2 minors of the first two and last two columns
+   (Eberly, "The Laplace Expansion Theorem"). a[c * 4 + r] is column major;
+   the formulas are symmetric under transposition so they apply as written. */
+template <typename V>
+struct Minors4 {
+	V s0, s1, s2, s3, s4, s5, c0, c1, c2, c3, c4, c5;
+
+	explicit Minors4(const V a[16]) {
+		s0 = a[0] * a[5] - a[4] * a[1];
+		s1 = a[0] * a[6] - a[4] * a[2];
+		s2 = a[0] * a[7] - a[4] * a[3];
+		s3 = a[1] * a[6] - a[5] * a[2];
+		s4 = a[1] * a[7] - a[5] * a[3];
+		s5 = a[2] * a[7] - a[6] * a[3];
+		c5 = a[10] * a[15] - a[14] * a[11];
+		c4 = a[9] * a[15] - a[13] * a[11];
+		c3 = a[9] * a[14] - a[13] * a[10];
+		c2 = a[8] * a[15] - a[12] * a[11];
+		c1 = a[8] * a[14] - a[12] * a[10];
+		c0 = a[8] * a[13] - a[12] * a[9];
+	}
+	V determinant() const { return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0; }
+};
+
+template <typename V>
+static inline V hadamard4(const V a[16]) {
+	using std::sqrt;
+	V product = a[0] * a[0] + a[1] * a[1] + a[2] * a[2] + a[3] * a[3];
+	for (int c = 1; c < 4; c++) {
+		product = product * (a[c * 4] * a[c * 4] + a[c * 4 + 1] * a[c * 4 + 1] + a[c * 4 + 2] * a[c * 4 + 2] + a[c * 4 + 3] * a[c * 4 + 3]);
+	}
+	return sqrt(product);
+}
+
+template <typename T>
+void determinant_batch(const MatSoAT<4, 4, T>& m, std::vector<T>& det) {
+	const size_t n = m.size();
+	det.resize(n);
+	const Streams<4, 4, T> in(m);
+	T* out = det.data();
+	forEachLane<T>(n, [&](auto zero, size_t i) {
+		typedef decltype(zero) V;
+		V a[16];
+		for (int e = 0; e < 16; e++) a[e] = loadAs<V>(in.a[e] + i);
+		storeAs(out + i, Minors4<V>(a).determinant());
+	});
+}
+
+template <typename T>
+size_t inverse_batch(const MatSoAT<4, 4, T>& m, MatSoAT<4, 4, T>& inverse, std::vector<uint8_t>& singular) {
+	const size_t n = m.size();
+	singular.resize(n);
+	const Streams<4, 4, T> in(m);
+	const OutStreams<4, 4, T> out(inverse, n);
+	uint8_t* mask = singular.data();
+	forEachLane<T>(n, [&](auto zero, size_t i) {
+		typedef decltype(zero) V;
+		V a[16];
+		for (int e = 0; e < 16; e++) a[e] = loadAs<V>(in.a[e] + i);
+		const Minors4<V> k(a);
+		const V inv = inverseDeterminant<V, T>(k.determinant(), hadamard4(a), mask + i);
+		T* const* o = out.a;
+		storeAs(o[0] + i, (a[5] * k.c5 - a[6] * k.c4 + a[7] * k.c3) * inv);
+		storeAs(o[1] + i, (a[2] * k.c4 - a[1] * k.c5 - a[3] * k.c3) * inv);
+		storeAs(o[2] + i, (a[13] * k.s5 - a[14] * k.s4 + a[15] * k.s3) * inv);
+		storeAs(o[3] + i, (a[10] * k.s4 - a[9] * k.s5 - a[11] * k.s3) * inv);
+		storeAs(o[4] + i, (a[6] * k.c2 - a[4] * k.c5 - a[7] * k.c1) * inv);
+		storeAs(o[5] + i, (a[0] * k.c5 - a[2] * k.c2 + a[3] * k.c1) * inv);
+		storeAs(o[6] + i, (a[14] * k.s2 - a[12] * k.s5 - a[15] * k.s1) * inv);
+		storeAs(o[7] + i, (a[8] * k.s5 - a[10] * k.s2 + a[11] * k.s1) * inv);
+		storeAs(o[8] + i, (a[4] * k.c4 - a[5] * k.c2 + a[7] * k.c0) * inv);
+		storeAs(o[9] + i, (a[1] * k.c2 - a[0] * k.c4 - a[3] * k.c0) * inv);
+		storeAs(o[10] + i, (a[12] * k.s4 - a[13] * k.s2 + a[15] * k.s0) * inv);
+		storeAs(o[11] + i, (a[9] * k.s2 - a[8] * k.s4 - a[11] * k.s0) * inv);
+		storeAs(o[12] + i, (a[5] * k.c1 - a[4] * k.c3 - a[6] * k.c0) * inv);
+		storeAs(o[13] + i, (a[0] * k.c3 - a[1] * k.c1 + a[2] * k.c0) * inv);
+		storeAs(o[14] + i, (a[13] * k.s1 - a[12] * k.s3 - a[14] * k.s0) * inv);
+		storeAs(o[15] + i, (a[8] * k.s3 - a[9] * k.s1 + a[10] * k.s0) * inv);
+	});
+	return countSingular(singular);
+}
+
+template <typename T>
+size_t normal_matrix_batch(const MatSoAT<4, 4, T>& model, MatSoAT<3, 3, T>& normal, std::vector<uint8_t>& singular) {
+	const size_t n = model.size();
+	singular.resize(n);
+	const Streams<4, 4, T> in(model);
+	const OutStreams<3, 3, T> out(normal, n);
+	uint8_t* mask = singular.data();
+	forEachLane<T>(n, [&](auto zero, size_t i) {
+		typedef decltype(zero) V;
+		V a[9], cof[9], det, bound;
+		load3(in, i, a);
+		cofactors3(a, cof, det, bound);
+		const V inv = inverseDeterminant<V, T>(det, bound, mask + i);
+		for (int e = 0; e < 9; e++) storeAs(out.a[e] + i, cof[e] * inv);
+	});
+	return countSingular(singular);
+}
+
+template <typename T>
+size_t affine_inverse_batch(const MatSoAT<4, 4, T>& m, MatSoAT<4, 4, T>& inverse, std::vector<uint8_t>& singular) {
+	const size_t n = m.size();
+	singular.resize(n);
+	const Streams<4, 4, T> in(m);
+	const OutStreams<4, 4, T> out(inverse, n);
+	uint8_t* mask = singular.data();
+	forEachLane<T>(n, [&](auto zero, size_t i) {
+		typedef decltype(zero) V;
+		V a[9], cof[9], det, bound;
+		load3(in, i, a);
+		cofactors3(a, cof, det, bound);
+		const V inv = inverseDeterminant<V, T>(det, bound, mask + i);
+		const V tx = loadAs<V>(in.a[12] + i), ty = loadAs<V>(in.a[13] + i), tz = loadAs<V>(in.a[14] + i);
+		/* inverse(A) = transpose(cof) / det; its rows are the cofactor columns. */
+		for (int c = 0; c < 3; c++) {
+			for (int r = 0; r < 3; r++) storeAs(out.a[c * 4 + r] + i, cof[r * 3 + c] * inv);
+			storeAs(out.a[c * 4 + 3] + i, V(T(0)));
+		}
+		for (int r = 0; r < 3; r++) {
+			storeAs(out.a[12 + r] + i, -(cof[r * 3] * tx + cof[r * 3 + 1] * ty + cof[r * 3 + 2] * tz) * inv);
+		}
+		storeAs(out.a[15] + i, V(T(1)));
+	});
+	return countSingular(singular);
+}
+
+#define INSTANTIATE(T) \
+	template void determinant_batch<T>(const MatSoAT<3, 3, T>&, std::vector<T>&); \
+	template void determinant_batch<T>(const MatSoAT<4, 4, T>&, std::vector<T>&); \
+	template size_t inverse_batch<T>(const MatSoAT<3, 3, T>&, MatSoAT<3, 3, T>&, std::vector<uint8_t>&); \
+	template size_t inverse_batch<T>(const MatSoAT<4, 4, T>&, MatSoAT<4, 4, T>&, std::vector<uint8_t>&); \
+	template size_t inverse_transpose_batch<T>(const MatSoAT<3, 3, T>&, MatSoAT<3, 3, T>&, std::vector<uint8_t>&); \
+	template size_t normal_matrix_batch<T>(const MatSoAT<4, 4, T>&, MatSoAT<3, 3, T>&, std::vector<uint8_t>&); \
+	template size_t affine_inverse_batch<T>(const MatSoAT<4, 4, T>&, MatSoAT<4, 4, T>&, std::vector<uint8_t>&);
+
+INSTANTIATE(float)
+INSTANTIATE(double)
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include "SoA.h"
+
+/* Batched determinants and inverses of small matrices over SoA streams, for
+   T = float and double. Outputs may not alias inputs.
+
+   The inverses flag numerically singular matrices in a mask (1 = singular):
+   those whose |determinant| is within a few ulps of the product of their
+   column lengths, the largest it could be (Hadamard's bound). Their output
+   is all zeros instead of infinities or NaNs. Each returns the number of
+   singular matrices. Large batches are split across worker threads. */
+
+template <typename T>
+void determinant_batch(const MatSoAT<3, 3, T>& m, std::vector<T>& det);
+template <typename T>
+void determinant_batch(const MatSoAT<4, 4, T>& m, std::vector<T>& det);
+
+template <typename T>
+size_t inverse_batch(const MatSoAT<3, 3, T>& m, MatSoAT<3, 3, T>& inverse, std::vector<uint8_t>& singular);
+template <typename T>
+size_t inverse_batch(const MatSoAT<4, 4, T>& m, MatSoAT<4, 4, T>& inverse, std::vector<uint8_t>& singular);
+
+/* transpose(inverse(m)), without the transpose. */
+template <typename T>
+size_t inverse_transpose_batch(const MatSoAT<3, 3, T>& m, MatSoAT<3, 3, T>& result, std::vector<uint8_t>& singular);
+
+/* Normal matrices: inverse-transpose of the upper-left 3x3 of each model matrix. */
+template <typename T>
+size_t normal_matrix_batch(const MatSoAT<4, 4, T>& model, MatSoAT<3, 3, T>& normal, std::vector<uint8_t>& singular);
+
+/* Inverse of affine transforms (last row 0 0 0 1, which is not checked):
+   inverse(M) = [inverse(A), -inverse(A) t]. Much cheaper than a full 4x4. */
+template <typename T>
+size_t affine_inverse_batch(const MatSoAT<4, 4, T>& m, MatSoAT<4, 4, T>& inverse, std::vector<uint8_t>& singular);
@@ -0,0 +1,132 @@
+#include "MultiViewRenderer.h"
+#include "Affine2D.h"
+#include "AffineRenderer.h"
+#include "ParameterRenderer.h"
+#include "ShapeRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+static const GLuint SCALE_ROTATION = 5, TRANSLATE = 6, INSTANCE_COLOR = 7;
+
+MultiViewRenderer::~MultiViewRenderer() {
+	if (Vao) glDeleteVertexArrays(1, &Vao);
+}
+
+void MultiViewRenderer::create(GLuint vertexBuffer, GLuint indexBuffer) {
+	Shaders = std::make_unique<mgl::ShaderProgram>();
+	Shaders->addShader(GL_VERTEX_SHADER, "multiview-vs.glsl");
+	Shaders->addShader(GL_FRAGMENT_SHADER, "clip-fs.glsl");
+	Shaders->addAttribute(mgl::POSITION_ATTRIBUTE, 0);
+	Shaders->addAttribute("inScaleRotation", SCALE_ROTATION);
+	Shaders->addAttribute("inTranslate", TRANSLATE);
+	Shaders->addAttribute("inInstanceColor", INSTANCE_COLOR);
+	Shaders->addUniform("Tilt");
+	Shaders->addUniform("Views");
+	Shaders->addUniform("FirstView");
+	Shaders->addUniform("View");
+	Shaders->create();
+	ViewsId = Shaders->Uniforms["Views"].index;
+	FirstViewId = Shaders->Uniforms["FirstView"].index;
+	ViewId = Shaders->Uniforms["View"].index;
+	SinglePass = GLEW_ARB_shader_viewport_layer_array != 0;
+
+	Shaders->bind();
+	glUniform2f(Shaders->Uniforms["Tilt"].index, TiltCos, TiltSin);
+	Shaders->unbind();
+	for (glm::vec4& view : ViewTransforms) view = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+
+	Instances.create(4096 * sizeof(ParameterInstance));
+	glGenVertexArrays(1, &Vao);
+	glBindVertexArray(Vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid*>(0));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, Instances.getBuffer());
+	glEnableVertexAttribArray(SCALE_ROTATION);
+	glVertexAttribPointer(SCALE_ROTATION, 3, GL_FLOAT, GL_FALSE, sizeof(ParameterInstance),
+		reinterpret_cast<GLvoid*>(offsetof(ParameterInstance, ScaleRotation)));
+	glEnableVertexAttribArray(TRANSLATE);
+	glVertexAttribPointer(TRANSLATE, 3, GL_FLOAT, GL_FALSE, sizeof(ParameterInstance),
+		reinterpret_cast<GLvoid*>(offsetof(ParameterInstance, Translate)));
+	glEnableVertexAttribArray(INSTANCE_COLOR);
+	glVertexAttribPointer(INSTANCE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParameterInstance),
+		reinterpret_cast<GLvoid*>(offsetof(ParameterInstance, Color)));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MultiViewRenderer::setViews(int views) {
+	GLint maxViewports = MaxViews;
+	glGetIntegerv(GL_MAX_VIEWPORTS, &maxViewports);
+	Views = std::clamp(views, 1, std::min<int>(MaxViews, maxViewports));
+}
+
+void MultiViewRenderer::setView(int view, glm::vec2 scale, glm::vec2 offset) {
+	ViewTransforms[view] = glm::vec4(scale, offset);
+}
+
+ClipRect MultiViewRenderer::sceneBounds() const {
+	ClipRect bounds = { 1.0f, 1.0f, -1.0f, -1.0f };
+	for (int v = 0; v < Views; v++) {
+		const glm::vec4& t = ViewTransforms[v];
+		const glm::vec2 a = (glm::vec2(-1.0f) - glm::vec2(t.z, t.w)) / glm::vec2(t.x, t.y);
+		const glm::vec2 b = (glm::vec2(1.0f) - glm::vec2(t.z, t.w)) / glm::vec2(t.x, t.y);
+		bounds.MinX = std::min({ bounds.MinX, a.x, b.x });
+		bounds.MinY = std::min({ bounds.MinY, a.y, b.y });
+		bounds.MaxX = std::max({ bounds.MaxX, a.x, b.x });
+		bounds.MaxY = std::max({ bounds.MaxY, a.y, b.y });
+	}
+	return bounds;
+}
+
+/* Cell of the view on a columns x rows grid, filled top row first. */
+glm::vec4 MultiViewRenderer::viewport(int view, int width, int height) const {
+	const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(Views))));
+	const int rows = (Views + columns - 1) / columns;
+	const float w = static_cast<float>(width) / columns, h = static_cast<float>(height) / rows;
+	const int column = view % columns, row = rows - 1 - view / columns;
+	return glm::vec4(column * w, row * h, w, h);
+}
+
+void MultiViewRenderer::draw(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+	std::vector<uint32_t>::const_iterator last, int32_t selected, int width, int height) {
+	const size_t count = static_cast<size_t>(last - first);
+	if (count == 0) return;
+	GLintptr offset;
+	ParameterInstance* instances = static_cast<ParameterInstance*>(Instances.allocate(count * sizeof(ParameterInstance), offset));
+	fillParameterInstances(shapes, first, count, selected, instances);
+
+	glBindVertexArray(Vao);
+	glBindVertexBuffer(SCALE_ROTATION, Instances.getBuffer(), offset + offsetof(ParameterInstance, ScaleRotation), sizeof(ParameterInstance));
+	glBindVertexBuffer(TRANSLATE, Instances.getBuffer(), offset + offsetof(ParameterInstance, Translate), sizeof(ParameterInstance));
+	glBindVertexBuffer(INSTANCE_COLOR, Instances.getBuffer(), offset + offsetof(ParameterInstance, Color), sizeof(ParameterInstance));
+	Shaders->bind();
+	glUniform4fv(ViewId, MaxViews, &ViewTransforms[0][0]);
+
+	if (SinglePass) {
+		for (int v = 0; v < Views; v++) {
+			const glm::vec4 cell = viewport(v, width, height);
+			glViewportIndexedf(v, cell.x, cell.y, cell.z, cell.w);
+		}
+		/* Piece k feeds instances k * views .. k * views + views - 1. */
+		for (GLuint binding : { SCALE_ROTATION, TRANSLATE, INSTANCE_COLOR }) glVertexBindingDivisor(binding, Views);
+		glUniform1i(ViewsId, Views);
+		glUniform1i(FirstViewId, 0);
+		drawShapeRuns(shapes, first, count, Views);
+	} else {
+		for (GLuint binding : { SCALE_ROTATION, TRANSLATE, INSTANCE_COLOR }) glVertexBindingDivisor(binding, 1);
+		glUniform1i(ViewsId, 1);
+		for (int v = 0; v < Views; v++) {
+			const glm::vec4 cell = viewport(v, width, height);
+			glViewportIndexedf(0, cell.x, cell.y, cell.z, cell.w);
+			glUniform1i(FirstViewId, v);
+			drawShapeRuns(shapes, first, count);
+		}
+	}
+
+	Shaders->unbind();
+	glBindVertexArray(0);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <mgl.hpp>
+
+#include "Culling.h"
+#include "Scene.h"
+
+/* Draws the scene into several viewports at once: thumbnails, split
+   screens, previews. Pieces go up once as ParameterInstance data and every
+   piece is instanced once per view (attribute divisor = views); the vertex
+   shader sends instance i to viewport i % views through gl_ViewportIndex.
+   N views cost one scene's instance building and draw calls.
+
+   Writing gl_ViewportIndex from a vertex shader needs
+   ARB_shader_viewport_layer_array. Without it the same instances are drawn
+   once per view with glViewport, which still builds them only once. */
+class MultiViewRenderer {
+public:
+	static constexpr int MaxViews = 16;
+
+	MultiViewRenderer() = default;
+	~MultiViewRenderer();
+
+	/* vertexBuffer and indexBuffer are the scene's own. The VAO binds
+	   them, so they must outlive the renderer. */
+	void create(GLuint vertexBuffer, GLuint indexBuffer);
+
+	/* Views are laid out on a near-square grid over the render target. */
+	void setViews(int views);
+	int views() const { return Views; }
+	/* Zoom and pan of a view, in clip space after the figure transform. */
+	void setView(int view, glm::vec2 scale, glm::vec2 offset);
+	bool singlePass() const { return SinglePass; }
+
+	/* The part of the scene some view shows, for culling. */
+	ClipRect sceneBounds() const;
+
+	/* Draws shapes[*first] .. shapes[*(last - 1)] into every view of a
+	   width x height target. Leaves viewport 0 on the first view. */
+	void draw(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+		std::vector<uint32_t>::const_iterator last, int32_t selected, int width, int height);
+
+private:
+	std::unique_ptr<mgl::ShaderProgram> Shaders;
+	GLint ViewsId = -1, FirstViewId = -1, ViewId = -1;
+	GLuint Vao = 0;
+	mgl::StreamBuffer Instances;
+	int Views = 1;
+	bool SinglePass = false;
+	glm::vec4 ViewTransforms[MaxViews];
+
+	glm::vec4 viewport(int view, int width, int height) const;
+};
@@ -0,0 +1,55 @@
+#include "Overdraw.h"
+
+OverdrawCounter::~OverdrawCounter() {
+	if (Queries[0]) glDeleteQueries(Count, Queries);
+}
+
+void OverdrawCounter::create() {
+	glGenQueries(Count, Queries);
+}
+
+void OverdrawCounter::begin(Query query) {
+	glBeginQuery(GL_SAMPLES_PASSED, Queries[query]);
+	Pending = true;
+}
+
+void OverdrawCounter::end() {
+	glEndQuery(GL_SAMPLES_PASSED);
+}
+
+void OverdrawCounter::beginCounting(Query query) {
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDisable(GL_DEPTH_TEST);
+	if (query == Covered) {
+		/* The first fragment of a pixel passes and bumps it off zero. */
+		glStencilMask(0xFF);
+		glClear(GL_STENCIL_BUFFER_BIT);
+		glEnable(GL_STENCIL_TEST);
+		glStencilFunc(GL_EQUAL, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+	}
+	begin(query);
+}
+
+void OverdrawCounter::endCounting() {
+	end();
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_STENCIL_TEST);
+	glEnable(GL_DEPTH_TEST);
+}
+
+bool OverdrawCounter::poll(OverdrawStats& stats) {
+	if (!Pending) return false;
+	for (GLuint query : Queries) {
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) return false;
+	}
+	glGetQueryObjectui64v(Queries[Shaded], GL_QUERY_RESULT, &stats.Shaded);
+	glGetQueryObjectui64v(Queries[Covered], GL_QUERY_RESULT, &stats.Covered);
+	glGetQueryObjectui64v(Queries[Rasterized], GL_QUERY_RESULT, &stats.Rasterized);
+	Pending = false;
+	return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <mgl.hpp>
+
+struct OverdrawStats {
+	GLuint64 Shaded = 0;		// samples that passed the depth test in the real pass
+	GLuint64 Covered = 0;		// samples left visible after the pass (one per covered pixel)
+	GLuint64 Rasterized = 0;	// samples an unordered, depth-less submission would shade
+
+	double overdraw() const { return Covered ? static_cast<double>(Shaded) / Covered : 0.0; }
+	double unsorted() const { return Covered ? static_cast<double>(Rasterized) / Covered : 0.0; }
+};
+
+/* Measures fragment overdraw with GL_SAMPLES_PASSED queries. The real pass is
+   wrapped in the Shaded query; the caller then redraws the same opaque set
+   twice with color and depth writes off and the depth test off. Covered lets
+   only the first fragment of each pixel through a stencil count, so pieces
+   overlapping at equal depth are not counted twice; Rasterized lets every
+   fragment through. Needs a stencil buffer. Results are read back without
+   stalling, a few frames later. */
+class OverdrawCounter {
+public:
+	enum Query { Shaded, Covered, Rasterized, Count };
+
+	~OverdrawCounter();
+
+	void create();
+	/* True when no measurement is in flight and a new one may start. */
+	bool idle() const { return !Pending; }
+
+	void begin(Query query);
+	void end();
+	/* Sets up depth/color state for the two counting redraws. */
+	void beginCounting(Query query);
+	void endCounting();
+
+	bool poll(OverdrawStats& stats);
+
+private:
+	GLuint Queries[Count] = {};
+	bool Pending = false;
+};
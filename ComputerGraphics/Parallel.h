@@ -0,0 +1,32 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+inline unsigned workerCount() {
+	unsigned n = std::thread::hardware_concurrency();
+	return n == 0 ? 1 : n;
+}
+
+/* Splits [begin, end) into one contiguous chunk per worker and calls
+   fn(chunkBegin, chunkEnd) on each. Small ranges run on the calling thread. */
+template <typename Fn>
+void parallelFor(size_t begin, size_t end, Fn fn, size_t minChunk = 4096) {
+	const size_t count = end > begin ? end - begin : 0;
+	const size_t workers = std::min<size_t>(workerCount(), (count + minChunk - 1) / std::max<size_t>(minChunk, 1));
+	if (workers <= 1) {
+		if (count) fn(begin, end);
+		return;
+	}
+	const size_t chunk = (count + workers - 1) / workers;
+	std::vector<std::thread> threads;
+	threads.reserve(workers - 1);
+	for (size_t w = 1; w < workers; w++) {
+		const size_t b = begin + w * chunk;
+		const size_t e = std::min(end, b + chunk);
+		if (b < e) threads.emplace_back(fn, b, e);
+	}
+	fn(begin, std::min(end, begin + chunk));
+	for (std::thread& t : threads) t.join();
+}
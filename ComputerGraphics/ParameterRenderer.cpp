@@ -0,0 +1,78 @@
+#include "ParameterRenderer.h"
+#include "Affine2D.h"
+#include "Color.h"
+#include "Parallel.h"
+
+#include <cstddef>
+
+static const GLuint SCALE_ROTATION = 5, TRANSLATE = 6, INSTANCE_COLOR = 7;
+
+void ParameterRenderer::create(GLuint vao) {
+	Shaders = std::make_unique<mgl::ShaderProgram>();
+	Shaders->addShader(GL_VERTEX_SHADER, "clip-params-vs.glsl");
+	Shaders->addShader(GL_FRAGMENT_SHADER, "clip-fs.glsl");
+	Shaders->addAttribute(mgl::POSITION_ATTRIBUTE, 0);
+	Shaders->addAttribute("inScaleRotation", SCALE_ROTATION);
+	Shaders->addAttribute("inTranslate", TRANSLATE);
+	Shaders->addAttribute("inInstanceColor", INSTANCE_COLOR);
+	Shaders->addUniform("Tilt");
+	Shaders->create();
+
+	Shaders->bind();
+	glUniform2f(Shaders->Uniforms["Tilt"].index, TiltCos, TiltSin);
+	Shaders->unbind();
+
+	Instances.create(4096 * sizeof(ParameterInstance));
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, Instances.getBuffer());
+	glEnableVertexAttribArray(SCALE_ROTATION);
+	glVertexAttribPointer(SCALE_ROTATION, 3, GL_FLOAT, GL_FALSE, sizeof(ParameterInstance),
+		reinterpret_cast<GLvoid*>(offsetof(ParameterInstance, ScaleRotation)));
+	glVertexAttribDivisor(SCALE_ROTATION, 1);
+	glEnableVertexAttribArray(TRANSLATE);
+	glVertexAttribPointer(TRANSLATE, 3, GL_FLOAT, GL_FALSE, sizeof(ParameterInstance),
+		reinterpret_cast<GLvoid*>(offsetof(ParameterInstance, Translate)));
+	glVertexAttribDivisor(TRANSLATE, 1);
+	glEnableVertexAttribArray(INSTANCE_COLOR);
+	glVertexAttribPointer(INSTANCE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParameterInstance),
+		reinterpret_cast<GLvoid*>(offsetof(ParameterInstance, Color)));
+	glVertexAttribDivisor(INSTANCE_COLOR, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void fillParameterInstances(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+	size_t count, int32_t selected, ParameterInstance* out) {
+	parallelFor(0, count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const uint32_t index = first[i];
+			const ShapeInstance& shape = shapes[index];
+			ParameterInstance& instance = out[i];
+			instance.ScaleRotation[0] = shape.scale.x;
+			instance.ScaleRotation[1] = shape.scale.y;
+			instance.ScaleRotation[2] = shape.rotation;
+			instance.Translate[0] = shape.translate.x;
+			instance.Translate[1] = shape.translate.y;
+			instance.Translate[2] = shape.translate.z;
+			packColor(static_cast<int32_t>(index) == selected ? Color::White : shape.color, instance.Color);
+		}
+	}, 16384);
+}
+
+void ParameterRenderer::draw(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+	std::vector<uint32_t>::const_iterator last, int32_t selected) {
+	const size_t count = static_cast<size_t>(last - first);
+	if (count == 0) return;
+	/* Straight into this frame's region of the mapped stream; the engine's
+	   frame fences keep the GPU off it. */
+	GLintptr offset;
+	ParameterInstance* instances = static_cast<ParameterInstance*>(Instances.allocate(count * sizeof(ParameterInstance), offset));
+	fillParameterInstances(shapes, first, count, selected, instances);
+	glBindVertexBuffer(SCALE_ROTATION, Instances.getBuffer(), offset + offsetof(ParameterInstance, ScaleRotation), sizeof(ParameterInstance));
+	glBindVertexBuffer(TRANSLATE, Instances.getBuffer(), offset + offsetof(ParameterInstance, Translate), sizeof(ParameterInstance));
+	glBindVertexBuffer(INSTANCE_COLOR, Instances.getBuffer(), offset + offsetof(ParameterInstance, Color), sizeof(ParameterInstance));
+
+	Shaders->bind();
+	drawShapeRuns(shapes, first, count);
+	Shaders->unbind();
+}
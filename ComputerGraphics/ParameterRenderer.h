@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <mgl.hpp>
+
+#include "AffineRenderer.h"
+#include "Scene.h"
+
+/* One instance of the parameter path: the piece's own fields, 28 bytes.
+   No transform is computed on the CPU; clip-params-vs.glsl builds
+   R2 * T * R * S per vertex. The fields are still copied out of the shapes
+   every frame (fillParameterInstances): animation writes the shapes, which
+   culling and picking read as well, so this path saves the matrix math,
+   not the copy. */
+struct ParameterInstance {
+	GLfloat ScaleRotation[3];	// scale x, scale y, rotation
+	GLfloat Translate[3];		// translation and depth
+	GLubyte Color[4];			// RGBA8
+};
+
+void fillParameterInstances(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+	size_t count, int32_t selected, ParameterInstance* out);
+
+/* Draws pieces from their raw parameters, in runs like AffineRenderer. */
+class ParameterRenderer {
+public:
+	ParameterRenderer() = default;
+	~ParameterRenderer() = default;
+
+	/* Adds the instance attributes (locations 5 to 7, divisor 1) to vao. */
+	void create(GLuint vao);
+
+	void draw(const std::vector<ShapeInstance>& shapes, std::vector<uint32_t>::const_iterator first,
+		std::vector<uint32_t>::const_iterator last, int32_t selected);
+
+private:
+	std::unique_ptr<mgl::ShaderProgram> Shaders;
+	mgl::StreamBuffer Instances;
+};
@@ -9,4 +9,6 @@ void ParellelogramRenderer::draw(
 	this->draw_internal(scale, rotation, translate, color, GL_TRIANGLE_STRIP, 7);
 }
 
-
+void ParellelogramRenderer::drawBaked(GLint piece, const GLfloat* matrix, glm::vec4 color) {
+	this->draw_baked_internal(piece, matrix, color, GL_TRIANGLE_STRIP, 7);
+}
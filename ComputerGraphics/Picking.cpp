@@ -0,0 +1,211 @@
+#include "Picking.h"
+#include "Affine2D.h"
+#include "SquareRenderer.h"
+#include "TriangleRenderer.h"
+#include "ParellelogramRenderer.h"
+
+#include <algorithm>
+#include <climits>
+
+////////////////////////////////////////////////////////////////////////// CPU
+
+bool pointInShape(const ShapeInstance& shape, glm::vec2 clip) {
+	const glm::vec2 p = pieceAffine(shape.scale, shape.rotation, glm::vec2(shape.translate)).inverse().apply(clip);
+	const ShapeOutline outline = shapeOutline(shape.type);
+
+	/* Outlines are stored in strip order; walk quads as 0, 1, 3, 2. */
+	static const int StripToLoop[] = { 0, 1, 3, 2 };
+	bool inside = false;
+	for (int i = 0, j = outline.count - 1; i < outline.count; j = i++) {
+		const glm::vec2 a = outline.points[outline.count == 4 ? StripToLoop[i] : i];
+		const glm::vec2 b = outline.points[outline.count == 4 ? StripToLoop[j] : j];
+		if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x) {
+			inside = !inside;
+		}
+	}
+	return inside;
+}
+
+int32_t pickCpu(const SpatialIndex& index, const std::vector<ShapeInstance>& shapes, glm::vec2 clip) {
+	std::vector<uint32_t> candidates;
+	index.queryPoint(clip, candidates);
+	/* Nearest depth wins; at equal depth the shape drawn later wins (GL_LEQUAL). */
+	int32_t best = -1;
+	for (uint32_t i : candidates) {
+		if (best >= 0) {
+			const float z = shapes[i].translate.z, bestZ = shapes[best].translate.z;
+			if (z > bestZ || (z == bestZ && static_cast<int32_t>(i) < best)) continue;
+		}
+		if (pointInShape(shapes[i], clip)) best = static_cast<int32_t>(i);
+	}
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////// GPU
+
+GpuPicker::~GpuPicker() {
+	destroy();
+}
+
+void GpuPicker::destroy() {
+	mgl::Engine::getInstance().getTargets().release(Target);
+	Target = nullptr;
+	for (Slot& slot : Ring) {
+		if (slot.fence) glDeleteSync(slot.fence);
+		if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+		slot = Slot();
+	}
+	Shaders.reset();
+	Requested = false;
+}
+
+void GpuPicker::create(int width, int height) {
+	Shaders = std::make_unique<mgl::ShaderProgram>();
+	Shaders->addShader(GL_VERTEX_SHADER, "pick-vs.glsl");
+	Shaders->addShader(GL_FRAGMENT_SHADER, "pick-fs.glsl");
+	Shaders->addAttribute(mgl::POSITION_ATTRIBUTE, 0);
+	Shaders->addUniform("Matrix");
+	Shaders->addUniform("ObjectId");
+	Shaders->create();
+
+	const GLint matrixId = Shaders->Uniforms["Matrix"].index;
+	ObjectId = Shaders->Uniforms["ObjectId"].index;
+	/* Color location -1 makes the renderers' color upload a no-op. */
+	Renderers[static_cast<int>(ShapeType::Triangle)] = std::make_unique<TriangleRenderer>(matrixId, -1);
+	Renderers[static_cast<int>(ShapeType::Square)] = std::make_unique<SquareRenderer>(matrixId, -1);
+	Renderers[static_cast<int>(ShapeType::Parallelogram)] = std::make_unique<ParellelogramRenderer>(matrixId, -1);
+
+	for (Slot& slot : Ring) {
+		glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, Region * Region * sizeof(GLuint), nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	resize(width, height);
+}
+
+/* The ID pass only draws and reads back, so the IDs go to a renderbuffer. */
+void GpuPicker::resize(int width, int height) {
+	if (width == Width && height == Height && Target) return;
+	mgl::RenderTargetPool& targets = mgl::Engine::getInstance().getTargets();
+	targets.release(Target);
+	Width = std::max(width, 1);
+	Height = std::max(height, 1);
+	mgl::RenderTargetDesc desc;
+	desc.Width = Width;
+	desc.Height = Height;
+	desc.Color = GL_R32UI;
+	desc.Depth = GL_DEPTH_COMPONENT24;
+	Target = targets.acquire(desc);
+}
+
+void GpuPicker::request(int x, int y) {
+	const int half = Region / 2;
+	const int x0 = std::clamp(x - half, 0, std::max(Width - Region, 0));
+	const int y0 = std::clamp(y - half, 0, std::max(Height - Region, 0));
+	RequestRegion = glm::ivec4(x0, y0, std::min(Region, Width), std::min(Region, Height));
+	RequestTime = glfwGetTime();
+	Requested = true;
+}
+
+void GpuPicker::render(GLuint vao, const std::vector<ShapeInstance>& shapes, const std::vector<uint32_t>& candidates) {
+	if (!Requested) return;
+	Slot* slot = nullptr;
+	for (Slot& s : Ring) {
+		if (!s.busy) {
+			slot = &s;
+			break;
+		}
+	}
+	if (!slot) return; // every readback is still in flight; retry next frame
+	Requested = false;
+
+	const glm::ivec4 r = RequestRegion;
+	/* The frame may be going to an offscreen canvas rather than the window. */
+	GLint target = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+	glBindFramebuffer(GL_FRAMEBUFFER, Target->Fbo);
+	glViewport(0, 0, Width, Height);
+	/* Only the pixels being read back need to be rasterized. */
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(r.x, r.y, r.z, r.w);
+	const GLuint background[] = { 0, 0, 0, 0 };
+	glClearBufferuiv(GL_COLOR, 0, background);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	glBindVertexArray(vao);
+	Shaders->bind();
+	for (uint32_t i : candidates) {
+		const ShapeInstance& shape = shapes[i];
+		glUniform1ui(ObjectId, i + 1);
+		Renderers[static_cast<int>(shape.type)]->draw(shape.scale, shape.rotation, shape.translate, shape.color);
+	}
+	Shaders->unbind();
+	glBindVertexArray(0);
+	glDisable(GL_SCISSOR_TEST);
+
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+	glReadPixels(r.x, r.y, r.z, r.w, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(target));
+
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->region = r;
+	slot->requested = RequestTime;
+	slot->frames = 0;
+	slot->busy = true;
+}
+
+bool GpuPicker::inFlight() const {
+	if (Requested) return true;
+	for (const Slot& slot : Ring) {
+		if (slot.busy) return true;
+	}
+	return false;
+}
+
+bool GpuPicker::poll(int32_t& picked, double& latencyMs, int& frames) {
+	Slot* ready = nullptr;
+	for (Slot& slot : Ring) {
+		if (!slot.busy) continue;
+		slot.frames++;
+		const GLenum status = glClientWaitSync(slot.fence, 0, 0);
+		if ((status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) &&
+			(!ready || slot.requested < ready->requested)) {
+			ready = &slot;
+		}
+	}
+	if (!ready) return false;
+
+	glDeleteSync(ready->fence);
+	ready->fence = nullptr;
+	ready->busy = false;
+
+	const int w = ready->region.z, h = ready->region.w;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, ready->pbo);
+	const GLuint* ids = static_cast<const GLuint*>(
+		glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, w * h * sizeof(GLuint), GL_MAP_READ_BIT));
+	/* Prefer the centre pixel, then the nearest covered pixel of the region. */
+	GLuint best = 0;
+	int bestDistance = INT_MAX;
+	if (ids) {
+		for (int y = 0; y < h; y++) {
+			for (int x = 0; x < w; x++) {
+				const int d = (x - w / 2) * (x - w / 2) + (y - h / 2) * (y - h / 2);
+				if (ids[y * w + x] && d < bestDistance) {
+					best = ids[y * w + x];
+					bestDistance = d;
+				}
+			}
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	picked = static_cast<int32_t>(best) - 1;
+	latencyMs = (glfwGetTime() - ready->requested) * 1000.0;
+	frames = ready->frames;
+	return true;
+}
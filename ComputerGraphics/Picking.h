@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Scene.h"
+#include "ShapeRenderer.h"
+#include "SpatialIndex.h"
+
+enum class PickMode {
+	Cpu,	// point-in-polygon on the candidates returned by the spatial index
+	Gpu		// ID buffer pass read back asynchronously through a PBO
+};
+
+/* True when the clip-space point lies inside the transformed outline of shape. */
+bool pointInShape(const ShapeInstance& shape, glm::vec2 clip);
+
+/* Topmost shape under the clip-space point, or -1. */
+int32_t pickCpu(const SpatialIndex& index, const std::vector<ShapeInstance>& shapes, glm::vec2 clip);
+
+class GpuPicker {
+public:
+	static constexpr int Region = 5;	// side of the square read back around the cursor
+	static constexpr int Slots = 3;		// picks that may be in flight at once
+
+	GpuPicker() = default;
+	~GpuPicker();
+
+	/* Sizes are in framebuffer pixels, which differ from window
+	   coordinates on HiDPI displays. */
+	void create(int width, int height);
+	void resize(int width, int height);
+	/* Releases the GL objects; call while the context is still current. */
+	void destroy();
+	int width() const { return Width; }
+	int height() const { return Height; }
+
+	/* Queues a pick at framebuffer pixel (x, y), origin bottom-left. */
+	void request(int x, int y);
+
+	/* Renders the ID pass for a queued request and starts its readback.
+	   candidates are the shapes whose bounds touch the requested region. */
+	void render(GLuint vao, const std::vector<ShapeInstance>& shapes, const std::vector<uint32_t>& candidates);
+
+	/* Completes the oldest finished readback without blocking. picked is -1 on background. */
+	bool poll(int32_t& picked, double& latencyMs, int& frames);
+
+	bool pending() const { return Requested; }
+	/* True while a request or readback still needs frames to complete. */
+	bool inFlight() const;
+	glm::ivec4 region() const { return RequestRegion; }
+
+private:
+	struct Slot {
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+		glm::ivec4 region;
+		double requested = 0.0;
+		int frames = 0;
+		bool busy = false;
+	};
+
+	std::unique_ptr<mgl::ShaderProgram> Shaders;
+	std::unique_ptr<ShapeRenderer> Renderers[static_cast<int>(ShapeType::Count)];
+	GLint ObjectId = -1;
+	mgl::RenderTarget* Target = nullptr;	// ID buffer, from the engine's pool
+	int Width = 0, Height = 0;
+	Slot Ring[Slots];
+
+	bool Requested = false;
+	glm::ivec4 RequestRegion;
+	double RequestTime = 0.0;
+};
@@ -0,0 +1,195 @@
+#include "PropertyTest.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+/* Samples per shard, and per generator call inside a shard. Both are fixed
+   so that sample k always gets the same inputs for a given seed. */
+static const uint64_t ShardSize = 1 << 16;
+static const uint64_t BlockSize = 1024;
+
+//////////////////////////////////////////////////////////////////// GENERATOR
+
+static uint64_t splitmix64(uint64_t& state) {
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static inline uint32_t rotl(uint32_t x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+Xoshiro128x8::Xoshiro128x8(uint64_t seed, uint64_t stream) {
+	uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ull);
+	for (int l = 0; l < Lanes; l++) {
+		const uint64_t a = splitmix64(state), b = splitmix64(state);
+		S0[l] = static_cast<uint32_t>(a);
+		S1[l] = static_cast<uint32_t>(a >> 32);
+		S2[l] = static_cast<uint32_t>(b);
+		S3[l] = static_cast<uint32_t>(b >> 32) | 1u;	// never the all-zero state
+	}
+}
+
+void Xoshiro128x8::next(uint32_t out[Lanes]) {
+	for (int l = 0; l < Lanes; l++) {
+		out[l] = S0[l] + S3[l];
+		const uint32_t t = S1[l] << 9;
+		S2[l] ^= S0[l];
+		S3[l] ^= S1[l];
+		S1[l] ^= S2[l];
+		S0[l] ^= S3[l];
+		S2[l] ^= t;
+		S3[l] = rotl(S3[l], 11);
+	}
+}
+
+void Xoshiro128x8::uniform(float* out, size_t n, float lo, float hi) {
+	const float scale = (hi - lo) * (1.0f / 16777216.0f);
+	uint32_t bits[Lanes];
+	for (size_t i = 0; i < n; i += Lanes) {
+		next(bits);
+		const size_t count = std::min<size_t>(Lanes, n - i);
+		for (size_t l = 0; l < count; l++) out[i + l] = lo + static_cast<float>(bits[l] >> 8) * scale;
+	}
+}
+
+////////////////////////////////////////////////////////////////////// ERRORS
+
+uint32_t ulp_distance(float a, float b) {
+	if (std::isnan(a) || std::isnan(b)) return UINT32_MAX;
+	int32_t ia, ib;
+	std::memcpy(&ia, &a, sizeof(a));
+	std::memcpy(&ib, &b, sizeof(b));
+	/* Map the sign-magnitude bit patterns onto one ordered integer line. */
+	const int64_t oa = ia >= 0 ? ia : static_cast<int64_t>(INT32_MIN) - ia;
+	const int64_t ob = ib >= 0 ? ib : static_cast<int64_t>(INT32_MIN) - ib;
+	return static_cast<uint32_t>(std::min<int64_t>(std::abs(oa - ob), UINT32_MAX));
+}
+
+Sample_error compare_components(const float* lhs, const float* rhs, int count, double scale) {
+	Sample_error error;
+	for (int c = 0; c < count; c++) {
+		const double diff = std::abs(static_cast<double>(lhs[c]) - static_cast<double>(rhs[c]));
+		const double relative = std::isnan(diff) ? INFINITY : diff / std::max(scale, 1.0e-30);
+		error.relative = std::max(error.relative, relative);
+		error.ulps = std::max(error.ulps, ulp_distance(lhs[c], rhs[c]));
+	}
+	return error;
+}
+
+void Property_report::add(const Sample_error& error, double tolerance, uint64_t sample) {
+	samples++;
+	const uint32_t u = error.ulps;
+	int ulpBin = 0;
+	while (ulpBin < UlpBins - 1 && (u >> ulpBin) != 0) ulpBin++;	// 1 + floor(log2(u))
+	ulp_histogram[ulpBin]++;
+	/* An inf or NaN relative error has no decade; it is counted on its own
+	   and ranks as infinitely wrong, so it stays comparable when merging. */
+	const double relative = std::isfinite(error.relative) ? error.relative : INFINITY;
+	if (std::isfinite(relative)) {
+		const int relativeBin = relative < 1.0e-9 ? 0 :
+			std::clamp(static_cast<int>(std::floor(std::log10(relative))) + 10, 0, RelativeBins - 1);
+		relative_histogram[relativeBin]++;
+	} else {
+		non_finite++;
+	}
+	if (relative > max_relative) {
+		max_relative = relative;
+		worst_sample = sample;
+	}
+	if (!(error.relative <= tolerance * error.allowed)) {
+		failures++;
+		first_failure = std::min(first_failure, sample);
+	}
+}
+
+void Property_report::merge(const Property_report& other) {
+	samples += other.samples;
+	failures += other.failures;
+	for (int b = 0; b < UlpBins; b++) ulp_histogram[b] += other.ulp_histogram[b];
+	for (int b = 0; b < RelativeBins; b++) relative_histogram[b] += other.relative_histogram[b];
+	non_finite += other.non_finite;
+	if (other.max_relative > max_relative) {
+		max_relative = other.max_relative;
+		worst_sample = other.worst_sample;
+	}
+	first_failure = std::min(first_failure, other.first_failure);
+}
+
+//////////////////////////////////////////////////////////////////////// RUNS
+
+Property_report run_property(const Property& property, uint64_t samples, uint64_t seed) {
+	const auto start = std::chrono::steady_clock::now();
+	const size_t shards = static_cast<size_t>((samples + ShardSize - 1) / ShardSize);
+	std::vector<Property_report> reports(shards);
+
+	parallelFor(0, shards, [&](size_t begin, size_t end) {
+		std::vector<float> input(BlockSize * property.inputs);
+		for (size_t shard = begin; shard < end; shard++) {
+			Xoshiro128x8 generator(seed, shard);
+			const uint64_t first = shard * ShardSize, last = std::min(samples, first + ShardSize);
+			for (uint64_t block = first; block < last; block += BlockSize) {
+				generator.uniform(input.data(), input.size(), property.lo, property.hi);
+				const uint64_t count = std::min(BlockSize, last - block);
+				for (uint64_t s = 0; s < count; s++) {
+					reports[shard].add(property.check(&input[s * property.inputs]), property.tolerance, block + s);
+				}
+			}
+		}
+	}, 1);
+
+	Property_report report;
+	for (const Property_report& r : reports) report.merge(r);
+	report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
+
+Sample_error replay_property(const Property& property, uint64_t seed, uint64_t sample, std::vector<float>& input) {
+	Xoshiro128x8 generator(seed, sample / ShardSize);
+	std::vector<float> block(BlockSize * property.inputs);
+	const uint64_t blocks = (sample % ShardSize) / BlockSize + 1;
+	for (uint64_t b = 0; b < blocks; b++) generator.uniform(block.data(), block.size(), property.lo, property.hi);
+	const float* first = &block[(sample % BlockSize) * property.inputs];
+	input.assign(first, first + property.inputs);
+	return property.check(input.data());
+}
+
+void print_property_report(const Property& property, const Property_report& report, uint64_t seed) {
+	std::cout << property.name << ": " << report.samples << " samples in " << report.milliseconds << " ms ("
+		<< report.samples / report.milliseconds / 1000.0 << " M/s), " << report.failures << " failures, max relative error "
+		<< report.max_relative << " at sample " << report.worst_sample << std::endl;
+
+	const double total = static_cast<double>(std::max<uint64_t>(report.samples, 1));
+	std::cout << "  ulps    ";
+	for (int b = 0; b < Property_report::UlpBins; b++) {
+		if (b == 0) std::cout << std::setw(7) << "0";
+		else if (b == Property_report::UlpBins - 1) std::cout << std::setw(7) << (">=" + std::to_string(1u << (b - 1)));
+		else std::cout << std::setw(7) << ((1u << (b - 1)) == 1 ? std::string("1") : "<" + std::to_string(1u << b));
+	}
+	std::cout << "\n  %       ";
+	for (int b = 0; b < Property_report::UlpBins; b++) {
+		std::cout << std::setw(7) << std::fixed << std::setprecision(2) << 100.0 * report.ulp_histogram[b] / total;
+	}
+	std::cout << "\n  rel <1e ";
+	for (int b = 0; b < Property_report::RelativeBins; b++) {
+		std::cout << std::setw(7) << (b == Property_report::RelativeBins - 1 ? std::string(">=-1") : std::to_string(b - 9));
+	}
+	std::cout << std::setw(9) << "inf/nan";
+	std::cout << "\n  %       ";
+	for (int b = 0; b < Property_report::RelativeBins; b++) {
+		std::cout << std::setw(7) << 100.0 * report.relative_histogram[b] / total;
+	}
+	std::cout << std::setw(9) << 100.0 * report.non_finite / total;
+	std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+	if (report.failures) {
+		std::cout << "  first failure: sample " << report.first_failure << ", replay with --replay \""
+			<< property.name << "\" " << seed << " " << report.first_failure << std::endl;
+	}
+}
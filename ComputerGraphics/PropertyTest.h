@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Property-based checks of numerical identities over millions of random
+   samples. A property draws its inputs from a seeded generator, evaluates
+   both sides of an identity and reports how far apart they are. Samples are
+   split into fixed shards, each with its own generator derived from the run
+   seed, so results (and failing sample numbers) do not depend on the number
+   of threads, and any failure can be replayed from (seed, sample). */
+
+/* xoshiro128+ over eight interleaved streams. The state is one array per
+   word, so a step is eight independent lanes the compiler can vectorize. */
+class Xoshiro128x8 {
+public:
+	static const int Lanes = 8;
+
+	explicit Xoshiro128x8(uint64_t seed, uint64_t stream = 0);
+	/* n uniform floats in [lo, hi), 24 random bits each. Draws whole steps of
+	   eight, so the stream only depends on the sequence of n requested. */
+	void uniform(float* out, size_t n, float lo, float hi);
+
+private:
+	void next(uint32_t out[Lanes]);
+
+	uint32_t S0[Lanes], S1[Lanes], S2[Lanes], S3[Lanes];
+};
+
+/* How far apart the two sides of one sample are. */
+struct Sample_error {
+	double relative = 0.0;	// |lhs - rhs| / scale, worst component
+	uint32_t ulps = 0;		// float ulp distance, worst component
+	double allowed = 1.0;	// multiplies the property tolerance, e.g. a condition number
+};
+
+/* Worst component of lhs vs rhs; scale is the magnitude errors are relative to. */
+Sample_error compare_components(const float* lhs, const float* rhs, int count, double scale);
+uint32_t ulp_distance(float a, float b);
+
+struct Property {
+	std::string name;
+	int inputs;				// floats drawn per sample
+	float lo, hi;			// input range
+	double tolerance;		// relative error allowed (times Sample_error::allowed)
+	Sample_error (*check)(const float* input);
+};
+
+struct Property_report {
+	static const int UlpBins = 12;		// 0, 1, 2-3, 4-7, ... 512-1023, >= 1024
+	static const int RelativeBins = 10;	// < 1e-9, [1e-9, 1e-8), ... [1e-2, 1e-1), >= 1e-1
+
+	uint64_t samples = 0, failures = 0;
+	uint64_t ulp_histogram[UlpBins] = {};
+	uint64_t relative_histogram[RelativeBins] = {};
+	uint64_t non_finite = 0;			// samples whose relative error is inf or NaN, kept out of the bins
+	double max_relative = 0.0;
+	uint64_t worst_sample = 0;
+	uint64_t first_failure = UINT64_MAX;
+	double milliseconds = 0.0;
+
+	void add(const Sample_error& error, double tolerance, uint64_t sample);
+	void merge(const Property_report& other);
+};
+
+/* Samples are drawn shard by shard; shards run across worker threads. */
+Property_report run_property(const Property& property, uint64_t samples, uint64_t seed);
+/* The inputs and result of one sample of a run, for reproducing a failure. */
+Sample_error replay_property(const Property& property, uint64_t seed, uint64_t sample, std::vector<float>& input);
+
+void print_property_report(const Property& property, const Property_report& report, uint64_t seed);
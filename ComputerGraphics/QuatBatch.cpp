@@ -0,0 +1,138 @@
+#include "QuatBatch.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+/* Kernels take raw stream pointers so the compiler sees plain unit-stride
+   float loops with no aliasing through std::vector and can vectorize them. */
+
+void axis_angle_to_quat_batch(const Vec3SoA& axis, const std::vector<float>& angles, QuatSoA& out) {
+	const size_t n = std::min(axis.size(), angles.size());
+	out.resize(n);
+	const float* ax = axis.x.data(); const float* ay = axis.y.data(); const float* az = axis.z.data();
+	const float* angle = angles.data();
+	float* w = out.w.data(); float* x = out.x.data(); float* y = out.y.data(); float* z = out.z.data();
+	parallelFor(0, n, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const float len2 = ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i];
+			const float half = 0.5f * angle[i];
+			const float s = len2 > 0.0f ? std::sin(half) / std::sqrt(len2) : 0.0f;
+			w[i] = std::cos(half);
+			x[i] = ax[i] * s;
+			y[i] = ay[i] * s;
+			z[i] = az[i] * s;
+		}
+	}, 16384);
+}
+
+void nlerp_batch(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out) {
+	const size_t n = std::min(a.size(), b.size());
+	out.resize(n);
+	const float* aw = a.w.data(); const float* ax = a.x.data(); const float* ay = a.y.data(); const float* az = a.z.data();
+	const float* bw = b.w.data(); const float* bx = b.x.data(); const float* by = b.y.data(); const float* bz = b.z.data();
+	float* w = out.w.data(); float* x = out.x.data(); float* y = out.y.data(); float* z = out.z.data();
+	parallelFor(0, n, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const float cosine = aw[i] * bw[i] + ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+			const float tb = cosine < 0.0f ? -t : t;	// q and -q are the same rotation
+			const float ta = 1.0f - t;
+			const float rw = aw[i] * ta + bw[i] * tb;
+			const float rx = ax[i] * ta + bx[i] * tb;
+			const float ry = ay[i] * ta + by[i] * tb;
+			const float rz = az[i] * ta + bz[i] * tb;
+			const float inv = 1.0f / std::sqrt(rw * rw + rx * rx + ry * ry + rz * rz);
+			w[i] = rw * inv;
+			x[i] = rx * inv;
+			y[i] = ry * inv;
+			z[i] = rz * inv;
+		}
+	}, 16384);
+}
+
+void slerp_batch(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out) {
+	const size_t n = std::min(a.size(), b.size());
+	out.resize(n);
+	const float* aw = a.w.data(); const float* ax = a.x.data(); const float* ay = a.y.data(); const float* az = a.z.data();
+	const float* bw = b.w.data(); const float* bx = b.x.data(); const float* by = b.y.data(); const float* bz = b.z.data();
+	float* w = out.w.data(); float* x = out.x.data(); float* y = out.y.data(); float* z = out.z.data();
+	parallelFor(0, n, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			float cosine = aw[i] * bw[i] + ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+			const float sign = cosine < 0.0f ? -1.0f : 1.0f;
+			cosine *= sign;
+			float ta = 1.0f - t, tb = t;
+			/* Below about 1.8 degrees sin(theta) loses precision; nlerp is exact enough there. */
+			if (cosine < 0.9995f) {
+				const float theta = std::acos(cosine);
+				const float inv = 1.0f / std::sin(theta);
+				ta = std::sin(ta * theta) * inv;
+				tb = std::sin(tb * theta) * inv;
+			}
+			tb *= sign;
+			const float rw = aw[i] * ta + bw[i] * tb;
+			const float rx = ax[i] * ta + bx[i] * tb;
+			const float ry = ay[i] * ta + by[i] * tb;
+			const float rz = az[i] * ta + bz[i] * tb;
+			const float inv = 1.0f / std::sqrt(rw * rw + rx * rx + ry * ry + rz * rz);
+			w[i] = rw * inv;
+			x[i] = rx * inv;
+			y[i] = ry * inv;
+			z[i] = rz * inv;
+		}
+	}, 8192);
+}
+
+void quat_to_mat3_batch(const QuatSoA& q, Mat3SoA& out) {
+	const size_t n = q.size();
+	out.resize(n);
+	const float* qw = q.w.data(); const float* qx = q.x.data(); const float* qy = q.y.data(); const float* qz = q.z.data();
+	float* m[9];
+	for (int e = 0; e < 9; e++) m[e] = out.m[e].data();
+	parallelFor(0, n, [=](size_t begin, size_t end) {
+		float* m00 = m[0]; float* m01 = m[1]; float* m02 = m[2];
+		float* m10 = m[3]; float* m11 = m[4]; float* m12 = m[5];
+		float* m20 = m[6]; float* m21 = m[7]; float* m22 = m[8];
+		for (size_t i = begin; i < end; i++) {
+			const float w = qw[i], x = qx[i], y = qy[i], z = qz[i];
+			const float xx = x * x, yy = y * y, zz = z * z;
+			const float xy = x * y, xz = x * z, yz = y * z;
+			const float wx = w * x, wy = w * y, wz = w * z;
+			m00[i] = 1.0f - 2.0f * (yy + zz); m01[i] = 2.0f * (xy + wz); m02[i] = 2.0f * (xz - wy);
+			m10[i] = 2.0f * (xy - wz); m11[i] = 1.0f - 2.0f * (xx + zz); m12[i] = 2.0f * (yz + wx);
+			m20[i] = 2.0f * (xz + wy); m21[i] = 2.0f * (yz - wx); m22[i] = 1.0f - 2.0f * (xx + yy);
+		}
+	}, 16384);
+}
+
+void quat_to_mat4_batch(const QuatSoA& q, const Vec3SoA* t, Mat4SoA& out) {
+	const size_t n = q.size();
+	out.resize(n);
+	const float* qw = q.w.data(); const float* qx = q.x.data(); const float* qy = q.y.data(); const float* qz = q.z.data();
+	const float* tx = t ? t->x.data() : nullptr;
+	const float* ty = t ? t->y.data() : nullptr;
+	const float* tz = t ? t->z.data() : nullptr;
+	float* m[16];
+	for (int e = 0; e < 16; e++) m[e] = out.m[e].data();
+	parallelFor(0, n, [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const float w = qw[i], x = qx[i], y = qy[i], z = qz[i];
+			const float xx = x * x, yy = y * y, zz = z * z;
+			const float xy = x * y, xz = x * z, yz = y * z;
+			const float wx = w * x, wy = w * y, wz = w * z;
+			m[0][i] = 1.0f - 2.0f * (yy + zz); m[1][i] = 2.0f * (xy + wz); m[2][i] = 2.0f * (xz - wy); m[3][i] = 0.0f;
+			m[4][i] = 2.0f * (xy - wz); m[5][i] = 1.0f - 2.0f * (xx + zz); m[6][i] = 2.0f * (yz + wx); m[7][i] = 0.0f;
+			m[8][i] = 2.0f * (xz + wy); m[9][i] = 2.0f * (yz - wx); m[10][i] = 1.0f - 2.0f * (xx + yy); m[11][i] = 0.0f;
+		}
+		if (tx) {
+			std::copy(tx + begin, tx + end, m[12] + begin);
+			std::copy(ty + begin, ty + end, m[13] + begin);
+			std::copy(tz + begin, tz + end, m[14] + begin);
+		} else {
+			std::fill(m[12] + begin, m[12] + end, 0.0f);
+			std::fill(m[13] + begin, m[13] + end, 0.0f);
+			std::fill(m[14] + begin, m[14] + end, 0.0f);
+		}
+		std::fill(m[15] + begin, m[15] + end, 1.0f);
+	}, 16384);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "SoA.h"
+
+/* Batched quaternion kernels over SoA streams. Inputs and outputs may be the
+   same container. Large batches are split across worker threads. */
+
+/* axis need not be normalized; angles in radians. */
+void axis_angle_to_quat_batch(const Vec3SoA& axis, const std::vector<float>& angles, QuatSoA& out);
+
+/* Normalized linear interpolation along the shorter arc. Cheap, and exact
+   at t = 0 and t = 1; angular speed varies slightly in between. */
+void nlerp_batch(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out);
+
+/* Spherical interpolation along the shorter arc; falls back to nlerp when
+   the quaternions are nearly parallel. */
+void slerp_batch(const QuatSoA& a, const QuatSoA& b, float t, QuatSoA& out);
+
+/* Rotation matrices of unit quaternions. */
+void quat_to_mat3_batch(const QuatSoA& q, Mat3SoA& out);
+/* Rigid transforms: rotation from q, translation from t (may be null). */
+void quat_to_mat4_batch(const QuatSoA& q, const Vec3SoA* t, Mat4SoA& out);
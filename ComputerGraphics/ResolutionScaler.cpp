@@ -0,0 +1,38 @@
+#include "ResolutionScaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool ResolutionScaler::update(double gpuMs) {
+	/* Exponential average over roughly the last eight frames. */
+	Average = Samples++ == 0 ? gpuMs : Average + 0.125 * (gpuMs - Average);
+	if (Wait > 0) {
+		Wait--;
+		return false;
+	}
+
+	/* GPU time goes with the pixel count, the square of the scale. */
+	if (Average > TargetMs) {
+		Under = 0;
+		return setScale(Scale * static_cast<float>(std::sqrt(Headroom * TargetMs / Average)));
+	}
+	if (Average < Headroom * TargetMs && Scale < MaxScale) {
+		if (++Under < GrowAfter) return false;
+		Under = 0;
+		/* At most a tenth wider per step: growing is the risky direction. */
+		const float grow = std::min(1.1f, static_cast<float>(std::sqrt(Headroom * TargetMs / Average)));
+		return setScale(std::max(Scale * grow, Scale + Step));
+	}
+	Under = 0;
+	return false;
+}
+
+bool ResolutionScaler::setScale(float scale) {
+	scale = std::clamp(std::round(scale / Step) * Step, MinScale, MaxScale);
+	if (scale == Scale) return false;
+	Scale = scale;
+	Wait = Cooldown;
+	/* Times measured at the old size say little about the new one. */
+	Samples = 0;
+	return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+/* Picks the render scale from measured GPU frame times. Times are smoothed,
+   and the scale only moves when the average leaves a dead band around the
+   target: down as soon as it runs over, up only once it has stayed well
+   under for a while. Every change is followed by a cooldown long enough for
+   timings of the new resolution to come back from the GPU, so the scale
+   settles instead of oscillating between two sizes. */
+class ResolutionScaler {
+public:
+	double TargetMs = 12.0;		// GPU time per frame to stay under
+	double Headroom = 0.8;		// grow only below this fraction of the target
+	float MinScale = 0.5f;
+	float MaxScale = 1.0f;
+	float Step = 1.0f / 32.0f;	// scales are multiples of this, to limit target reallocation
+	int GrowAfter = 30;			// samples under the band before growing
+	int Cooldown = 15;			// samples ignored after a change
+
+	/* Feeds one GPU frame time; true when the scale changed. */
+	bool update(double gpuMs);
+
+	float scale() const { return Scale; }
+	double average() const { return Average; }
+
+private:
+	float Scale = 1.0f;
+	double Average = 0.0;
+	int Samples = 0;
+	int Under = 0;
+	int Wait = 0;
+
+	bool setScale(float scale);
+};
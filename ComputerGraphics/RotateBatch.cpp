@@ -0,0 +1,118 @@
+#include "RotateBatch.h"
+#include "Parallel.h"
+#include "SimdLane.h"
+
+#include <algorithm>
+#include <cmath>
+
+/* Rotation streams are read once and written once, so the batches are
+   memory bound; big chunks keep thread start-up out of the picture. */
+static const size_t MinChunk = 65536;
+
+const char* rotate_batch_isa() {
+	return SIMD_ISA;
+}
+
+template <typename Trig>
+void rodrigues_terms_batch(const Vec3SoA& axes, const std::vector<float>& rads, Rodrigues_terms& terms) {
+	const size_t n = std::min(axes.size(), rads.size());
+	terms.resize(n);
+	Trig::sincos_batch(rads.data(), terms.sin.data(), terms.cos.data(), n);
+	parallelFor(0, n, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const float len2 = axes.x[i] * axes.x[i] + axes.y[i] * axes.y[i] + axes.z[i] * axes.z[i];
+			const float inv = len2 > 0.0f ? 1.0f / std::sqrt(len2) : 0.0f;
+			terms.k.x[i] = axes.x[i] * inv;
+			terms.k.y[i] = axes.y[i] * inv;
+			terms.k.z[i] = axes.z[i] * inv;
+			if (inv == 0.0f) {
+				terms.cos[i] = 1.0f;
+				terms.sin[i] = 0.0f;
+			}
+		}
+	}, 16384);
+}
+
+template void rodrigues_terms_batch<Exact_trig>(const Vec3SoA&, const std::vector<float>&, Rodrigues_terms&);
+template void rodrigues_terms_batch<Fast_trig>(const Vec3SoA&, const std::vector<float>&, Rodrigues_terms&);
+
+template <typename Trig>
+void rodrigues_rotate_batch(glm::vec3 axis, float rads, const Vec3SoA& in, Vec3SoA& out) {
+	const size_t n = in.size();
+	out.resize(n);
+	const float len2 = glm::dot(axis, axis);
+	const glm::vec3 k = len2 > 0.0f ? axis / std::sqrt(len2) : glm::vec3(0.0f);
+	float c = 1.0f, s = 0.0f;
+	if (len2 > 0.0f) Trig::sincos(rads, s, c);
+	const float t = 1.0f - c;
+	/* R = c I + s [k]x + (1 - c) k k^T, row major here: r[row][column]. */
+	const float r[3][3] = {
+		{ c + k.x * k.x * t, k.x * k.y * t - k.z * s, k.x * k.z * t + k.y * s },
+		{ k.y * k.x * t + k.z * s, c + k.y * k.y * t, k.y * k.z * t - k.x * s },
+		{ k.z * k.x * t - k.y * s, k.z * k.y * t + k.x * s, c + k.z * k.z * t }
+	};
+
+	const float* ix = in.x.data(); const float* iy = in.y.data(); const float* iz = in.z.data();
+	float* ox = out.x.data(); float* oy = out.y.data(); float* oz = out.z.data();
+	parallelFor(0, n, [&](size_t begin, size_t end) {
+		size_t i = begin;
+#if defined(SIMD_LANES)
+		using namespace simd;
+		const Lane r00 = splat(r[0][0]), r01 = splat(r[0][1]), r02 = splat(r[0][2]);
+		const Lane r10 = splat(r[1][0]), r11 = splat(r[1][1]), r12 = splat(r[1][2]);
+		const Lane r20 = splat(r[2][0]), r21 = splat(r[2][1]), r22 = splat(r[2][2]);
+		for (; i + Width <= end; i += Width) {
+			const Lane x = load(ix + i), y = load(iy + i), z = load(iz + i);
+			store(ox + i, add(add(mul(r00, x), mul(r01, y)), mul(r02, z)));
+			store(oy + i, add(add(mul(r10, x), mul(r11, y)), mul(r12, z)));
+			store(oz + i, add(add(mul(r20, x), mul(r21, y)), mul(r22, z)));
+		}
+#endif
+		for (; i < end; i++) {
+			const float x = ix[i], y = iy[i], z = iz[i];
+			ox[i] = r[0][0] * x + r[0][1] * y + r[0][2] * z;
+			oy[i] = r[1][0] * x + r[1][1] * y + r[1][2] * z;
+			oz[i] = r[2][0] * x + r[2][1] * y + r[2][2] * z;
+		}
+	}, MinChunk);
+}
+
+template void rodrigues_rotate_batch<Exact_trig>(glm::vec3, float, const Vec3SoA&, Vec3SoA&);
+template void rodrigues_rotate_batch<Fast_trig>(glm::vec3, float, const Vec3SoA&, Vec3SoA&);
+
+void rodrigues_rotate_batch(const Rodrigues_terms& terms, const Vec3SoA& in, Vec3SoA& out) {
+	const size_t n = std::min(terms.size(), in.size());
+	out.resize(n);
+	const float* kx = terms.k.x.data(); const float* ky = terms.k.y.data(); const float* kz = terms.k.z.data();
+	const float* kc = terms.cos.data(); const float* ks = terms.sin.data();
+	const float* ix = in.x.data(); const float* iy = in.y.data(); const float* iz = in.z.data();
+	float* ox = out.x.data(); float* oy = out.y.data(); float* oz = out.z.data();
+	parallelFor(0, n, [&](size_t begin, size_t end) {
+		/* v' = v cos + (k x v) sin + k (k . v)(1 - cos) */
+		size_t i = begin;
+#if defined(SIMD_LANES)
+		using namespace simd;
+		const Lane one = splat(1.0f);
+		for (; i + Width <= end; i += Width) {
+			const Lane x = load(ix + i), y = load(iy + i), z = load(iz + i);
+			const Lane ax = load(kx + i), ay = load(ky + i), az = load(kz + i);
+			const Lane c = load(kc + i), s = load(ks + i);
+			const Lane d = mul(add(add(mul(ax, x), mul(ay, y)), mul(az, z)), sub(one, c));
+			const Lane cx = sub(mul(ay, z), mul(az, y));
+			const Lane cy = sub(mul(az, x), mul(ax, z));
+			const Lane cz = sub(mul(ax, y), mul(ay, x));
+			store(ox + i, add(add(mul(x, c), mul(cx, s)), mul(ax, d)));
+			store(oy + i, add(add(mul(y, c), mul(cy, s)), mul(ay, d)));
+			store(oz + i, add(add(mul(z, c), mul(cz, s)), mul(az, d)));
+		}
+#endif
+		for (; i < end; i++) {
+			const float x = ix[i], y = iy[i], z = iz[i];
+			const float ax = kx[i], ay = ky[i], az = kz[i], c = kc[i], s = ks[i];
+			const float d = (ax * x + ay * y + az * z) * (1.0f - c);
+			ox[i] = x * c + (ay * z - az * y) * s + ax * d;
+			oy[i] = y * c + (az * x - ax * z) * s + ay * d;
+			oz[i] = z * c + (ax * y - ay * x) * s + az * d;
+		}
+	}, MinChunk);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "FastTrig.h"
+#include "SoA.h"
+
+/* Batched Rodrigues rotation of vec3 streams. in and out may be the same
+   container. The SIMD width is picked at compile time (AVX2, SSE2 or NEON,
+   else scalar) and large batches are split across worker threads. */
+
+/* Per-element rotations with the trig already evaluated: unit axis k and
+   cos/sin of the angle. Build once, rotate many streams with it. */
+struct Rodrigues_terms {
+	Vec3SoA k;
+	std::vector<float> cos, sin;
+
+	void resize(size_t n) { k.resize(n); cos.resize(n); sin.resize(n); }
+	size_t size() const { return cos.size(); }
+};
+
+/* axes need not be normalized; a zero axis gives the identity. Trig is the
+   sine/cosine policy (FastTrig.h); the batch evaluates it on whole lanes. */
+template <typename Trig = Transform_trig>
+void rodrigues_terms_batch(const Vec3SoA& axes, const std::vector<float>& rads, Rodrigues_terms& terms);
+
+/* Rotates every vector about one shared axis. The axis is normalized and the
+   trig evaluated once, so the kernel is a 3x3 matrix product per vector. */
+template <typename Trig = Transform_trig>
+void rodrigues_rotate_batch(glm::vec3 axis, float rads, const Vec3SoA& in, Vec3SoA& out);
+
+/* Rotates vector i by rotation i of terms. */
+void rodrigues_rotate_batch(const Rodrigues_terms& terms, const Vec3SoA& in, Vec3SoA& out);
+
+/* Name of the compiled SIMD path, for benchmark reports. */
+const char* rotate_batch_isa();
@@ -0,0 +1,70 @@
+#include "Scene.h"
+#include "Color.h"
+#include "StaticLayout.h"
+
+#include <algorithm>
+#include <random>
+
+/* Must match the Vertices/Indices uploaded in main.cpp. */
+static const glm::vec2 TrianglePoints[] = { {0.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f} };
+static const glm::vec2 SquarePoints[] = { {0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f} };
+static const glm::vec2 ParallelogramPoints[] = { {0.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}, {1.0f, 2.0f} };
+
+ShapeOutline shapeOutline(ShapeType type) {
+	switch (type) {
+	case ShapeType::Triangle:
+		return { TrianglePoints, 3 };
+	case ShapeType::Square:
+		return { SquarePoints, 4 };
+	case ShapeType::Parallelogram:
+		return { ParallelogramPoints, 4 };
+	default:
+		return { nullptr, 0 };
+	}
+}
+
+std::vector<ShapeInstance> defaultTangram() {
+	return layoutInstances(TangramLayout, TangramPieces);
+}
+
+std::vector<ShapeInstance> randomTangram(size_t count, float extent, unsigned seed) {
+	const std::vector<ShapeInstance> pieces = defaultTangram();
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> position(-extent, extent);
+	std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+
+	std::vector<ShapeInstance> shapes(count);
+	for (size_t i = 0; i < count; i++) {
+		shapes[i] = pieces[i % pieces.size()];
+		shapes[i].rotation = angle(rng);
+		shapes[i].translate = glm::vec3(position(rng), position(rng), 0.0f);
+		shapes[i].layer = static_cast<int>(i % MaxLayers);
+	}
+	return shapes;
+}
+
+size_t orderForSubmission(std::vector<ShapeInstance>& shapes, std::vector<uint32_t>* order) {
+	for (ShapeInstance& shape : shapes) shape.translate.z = layerDepth(shape.layer);
+
+	std::vector<uint32_t> slots(shapes.size());
+	for (uint32_t i = 0; i < slots.size(); i++) slots[i] = i;
+	auto firstBlended = std::stable_partition(slots.begin(), slots.end(),
+		[&](uint32_t i) { return !isBlended(shapes[i]); });
+	std::stable_sort(slots.begin(), firstBlended, [&](uint32_t a, uint32_t b) {
+		return shapes[a].translate.z < shapes[b].translate.z;
+	});
+	std::stable_sort(firstBlended, slots.end(), [&](uint32_t a, uint32_t b) {
+		return shapes[a].translate.z > shapes[b].translate.z;
+	});
+	const size_t blended = static_cast<size_t>(firstBlended - slots.begin());
+
+	permute(shapes, slots);
+	if (order) order->swap(slots);
+	return blended;
+}
+
+void permute(std::vector<ShapeInstance>& shapes, const std::vector<uint32_t>& order) {
+	std::vector<ShapeInstance> reordered(order.size());
+	for (size_t i = 0; i < order.size(); i++) reordered[i] = shapes[order[i]];
+	shapes.swap(reordered);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <mgl.hpp>
+
+enum class ShapeType : GLubyte {
+	Triangle,
+	Square,
+	Parallelogram,
+	Count
+};
+
+struct ShapeInstance {
+	ShapeType type;
+	glm::vec2 scale;
+	float rotation;
+	glm::vec3 translate;
+	glm::vec4 color;
+	int layer = 0;	// higher layers are drawn nearer the viewer
+};
+
+constexpr int MaxLayers = 1 << 20;
+
+/* Clip-space z of a layer, inside (-1, 1) so it survives the depth test.
+   constexpr so static layouts can bake it (StaticLayout.h). */
+constexpr float layerDepth(int layer) {
+	const int clamped = std::clamp(layer, 0, MaxLayers - 1);
+	return 1.0f - 2.0f * static_cast<float>(clamped + 1) / static_cast<float>(MaxLayers + 1);
+}
+
+inline bool isBlended(const ShapeInstance& shape) { return shape.color.a < 1.0f; }
+
+/* Writes every layer depth into translate.z and reorders the shapes for
+   submission: opaque front to back (early-Z rejects what is hidden), then
+   blended back to front. Returns the index of the first blended shape.
+   order, when given, receives the authored index of every reordered slot. */
+size_t orderForSubmission(std::vector<ShapeInstance>& shapes, std::vector<uint32_t>* order = nullptr);
+
+/* Reorders shapes so that slot i holds the authored shape order[i]. */
+void permute(std::vector<ShapeInstance>& shapes, const std::vector<uint32_t>& order);
+
+/* Outline of the unit shape in model space, in the same order the indices draw it. */
+struct ShapeOutline {
+	const glm::vec2* points;
+	int count;
+};
+
+ShapeOutline shapeOutline(ShapeType type);
+
+std::vector<ShapeInstance> defaultTangram();
+
+/* Copies of the default pieces scattered over [-extent, extent], for stress scenes. */
+std::vector<ShapeInstance> randomTangram(size_t count, float extent, unsigned seed);
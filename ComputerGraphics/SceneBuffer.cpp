@@ -0,0 +1,80 @@
+#include "SceneBuffer.h"
+#include "Affine2D.h"
+#include "AffineRenderer.h"
+#include "ShapeRenderer.h"
+
+#include <chrono>
+#include <vector>
+
+static const GLuint PIECE = 5;
+
+SceneBuffer::~SceneBuffer() {
+	if (Buffers[0]) glDeleteBuffers(Arrays, Buffers);
+	if (PieceBuffer) glDeleteBuffers(1, &PieceBuffer);
+	if (Vao) glDeleteVertexArrays(1, &Vao);
+}
+
+void SceneBuffer::create(const SceneView& view, GLuint vertexBuffer, GLuint indexBuffer) {
+	Shaders = std::make_unique<mgl::ShaderProgram>();
+	Shaders->addShader(GL_VERTEX_SHADER, "clip-scene-vs.glsl");
+	Shaders->addShader(GL_FRAGMENT_SHADER, "clip-fs.glsl");
+	Shaders->addAttribute(mgl::POSITION_ATTRIBUTE, 0);
+	Shaders->addAttribute("inPiece", PIECE);
+	Shaders->addUniform("Tilt");
+	Shaders->create();
+	Shaders->bind();
+	glUniform2f(Shaders->Uniforms["Tilt"].index, TiltCos, TiltSin);
+	Shaders->unbind();
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	Count = view.count;
+	/* The driver reads the mapped pages directly; nothing is staged. */
+	const void* arrays[Arrays] = { view.scales, view.rotations, view.translates, view.colors, view.layers };
+	const size_t sizes[Arrays] = { sizeof(glm::vec2), sizeof(float), sizeof(glm::vec3), sizeof(glm::vec4), sizeof(int32_t) };
+	glGenBuffers(Arrays, Buffers);
+	for (int a = 0; a < Arrays; a++) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, Buffers[a]);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(std::max<size_t>(Count, 1) * sizes[a]),
+			Count ? arrays[a] : nullptr, 0);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	/* Counting sort of the piece indices by type, file order kept. */
+	const int types = static_cast<int>(ShapeType::Count);
+	for (size_t i = 0; i < Count; i++) Pieces[static_cast<int>(view.types[i]) % types]++;
+	for (int t = 1; t < types; t++) First[t] = First[t - 1] + Pieces[t - 1];
+	std::vector<GLuint> pieces(Count);
+	size_t next[static_cast<int>(ShapeType::Count)];
+	for (int t = 0; t < types; t++) next[t] = First[t];
+	for (size_t i = 0; i < Count; i++) pieces[next[static_cast<int>(view.types[i]) % types]++] = static_cast<GLuint>(i);
+
+	glGenVertexArrays(1, &Vao);
+	glBindVertexArray(Vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<GLvoid*>(0));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glGenBuffers(1, &PieceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, PieceBuffer);
+	glBufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(std::max<size_t>(Count, 1) * sizeof(GLuint)),
+		Count ? pieces.data() : nullptr, 0);
+	glEnableVertexAttribArray(PIECE);
+	glVertexAttribIPointer(PIECE, 1, GL_UNSIGNED_INT, sizeof(GLuint), reinterpret_cast<GLvoid*>(0));
+	glVertexAttribDivisor(PIECE, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	UploadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void SceneBuffer::draw() const {
+	if (Count == 0) return;
+	for (int a = 0; a < Arrays; a++) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, a, Buffers[a]);
+	glBindVertexArray(Vao);
+	Shaders->bind();
+	for (int t = 0; t < static_cast<int>(ShapeType::Count); t++) {
+		if (Pieces[t]) drawShapeInstances(static_cast<ShapeType>(t), static_cast<GLsizei>(Pieces[t]), static_cast<GLuint>(First[t]));
+	}
+	Shaders->unbind();
+	glBindVertexArray(0);
+	for (int a = 0; a < Arrays; a++) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, a, 0);
+}
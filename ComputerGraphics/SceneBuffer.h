@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <mgl.hpp>
+
+#include "Scene.h"
+#include "SceneFile.h"
+
+/* A binary scene drawn straight from its mapped arrays. Each array goes
+   from the mapping into an immutable shader storage buffer in one
+   glBufferStorage, and no ShapeInstance is ever built. The vertex shader
+   reads the arrays by piece index. The only CPU pass is a scan of the type
+   array that splits piece indices by type, so each frame is one instanced
+   draw per shape type.
+
+   Pieces are drawn in file order with their layer depths. Nothing culls,
+   picks or animates them. */
+class SceneBuffer {
+public:
+	SceneBuffer() = default;
+	~SceneBuffer();
+
+	/* vertexBuffer and indexBuffer are the scene's own. The VAO binds
+	   them, so they must outlive the scene buffer. */
+	void create(const SceneView& view, GLuint vertexBuffer, GLuint indexBuffer);
+	void draw() const;
+
+	size_t size() const { return Count; }
+	double uploadMs() const { return UploadMs; }
+
+private:
+	static const int Arrays = 5;	// every SceneArray but Types
+
+	std::unique_ptr<mgl::ShaderProgram> Shaders;
+	GLuint Vao = 0;
+	GLuint Buffers[Arrays] = {};
+	GLuint PieceBuffer = 0;			// piece indices grouped by type
+	size_t First[static_cast<int>(ShapeType::Count)] = {};
+	size_t Pieces[static_cast<int>(ShapeType::Count)] = {};
+	size_t Count = 0;
+	double UploadMs = 0.0;
+};
@@ -0,0 +1,235 @@
+#include "SceneFile.h"
+#include "Parallel.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(glm::vec2) == 8 && sizeof(glm::vec3) == 12 && sizeof(glm::vec4) == 16,
+	"scene arrays are read in place and need tightly packed glm vectors");
+static_assert(sizeof(SceneFileHeader) == 64, "scene header layout changed");
+
+static const size_t ElementSize[ArrayCount] = {
+	sizeof(glm::vec2), sizeof(float), sizeof(glm::vec3), sizeof(glm::vec4), sizeof(int32_t), sizeof(ShapeType)
+};
+static const size_t ArrayAlignment = 64;
+
+static const char* const TypeNames[] = { "triangle", "square", "parallelogram" };
+
+static void fail(const std::string& filename, const std::string& reason) {
+	std::cerr << "[ERROR] " << reason << ": " << filename << std::endl;
+	throw std::runtime_error("Failed to load scene file.");
+}
+
+//////////////////////////////////////////////////////////////////// MAPPED FILE
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename) {
+	FileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (FileHandle == INVALID_HANDLE_VALUE) {
+		FileHandle = nullptr;
+		fail(filename, "Failed to open scene file");
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx(FileHandle, &size);
+	Size = static_cast<size_t>(size.QuadPart);
+	if (Size == 0) return;
+	MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (MappingHandle) {
+		Data = static_cast<const uint8_t*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!Data) {
+		release();
+		fail(filename, "Failed to map scene file");
+	}
+}
+
+void MappedFile::release() {
+	if (Data) UnmapViewOfFile(Data);
+	if (MappingHandle) CloseHandle(MappingHandle);
+	if (FileHandle) CloseHandle(FileHandle);
+	Data = nullptr;
+	MappingHandle = FileHandle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename) {
+	const int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) fail(filename, "Failed to open scene file");
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		fail(filename, "Failed to stat scene file");
+	}
+	Size = static_cast<size_t>(info.st_size);
+	if (Size > 0) {
+		void* data = mmap(nullptr, Size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED) {
+			close(fd);
+			fail(filename, "Failed to map scene file");
+		}
+		Data = static_cast<const uint8_t*>(data);
+	}
+	close(fd); // the mapping keeps its own reference
+}
+
+void MappedFile::release() {
+	if (Data) munmap(const_cast<uint8_t*>(Data), Size);
+	Data = nullptr;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+	release();
+}
+
+///////////////////////////////////////////////////////////////////// SCENE FILE
+
+SceneFile::SceneFile(const std::string& filename) : File(filename) {
+	if (File.size() < sizeof(SceneFileHeader)) fail(filename, "Scene file is truncated");
+	const SceneFileHeader* header = reinterpret_cast<const SceneFileHeader*>(File.data());
+	if (std::memcmp(header->magic, SceneFileMagic, sizeof(SceneFileMagic)) != 0) {
+		fail(filename, "Not a scene file");
+	}
+	if (header->version != SceneFileVersion) fail(filename, "Unsupported scene file version");
+
+	const uint64_t count = header->count;
+	for (int a = 0; a < ArrayCount; a++) {
+		const uint64_t offset = header->offsets[a];
+		if (offset % ArrayAlignment != 0 || offset > File.size() ||
+			count > (File.size() - offset) / ElementSize[a]) {
+			fail(filename, "Scene file array out of bounds");
+		}
+	}
+
+	const uint8_t* base = File.data();
+	View.count = static_cast<size_t>(count);
+	View.scales = reinterpret_cast<const glm::vec2*>(base + header->offsets[Scales]);
+	View.rotations = reinterpret_cast<const float*>(base + header->offsets[Rotations]);
+	View.translates = reinterpret_cast<const glm::vec3*>(base + header->offsets[Translates]);
+	View.colors = reinterpret_cast<const glm::vec4*>(base + header->offsets[Colors]);
+	View.layers = reinterpret_cast<const int32_t*>(base + header->offsets[Layers]);
+	View.types = reinterpret_cast<const ShapeType*>(base + header->offsets[Types]);
+}
+
+std::vector<ShapeInstance> SceneFile::instances() const {
+	std::vector<ShapeInstance> shapes(View.count);
+	parallelFor(0, View.count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const ShapeType type = View.types[i] < ShapeType::Count ? View.types[i] : ShapeType::Triangle;
+			shapes[i] = { type, View.scales[i], View.rotations[i], View.translates[i], View.colors[i], View.layers[i] };
+		}
+	});
+	return shapes;
+}
+
+void writeSceneBinary(const std::string& filename, const std::vector<ShapeInstance>& shapes) {
+	const size_t count = shapes.size();
+	SceneFileHeader header = {};
+	std::memcpy(header.magic, SceneFileMagic, sizeof(SceneFileMagic));
+	header.version = SceneFileVersion;
+	header.count = count;
+	uint64_t offset = sizeof(SceneFileHeader);
+	for (int a = 0; a < ArrayCount; a++) {
+		offset = (offset + ArrayAlignment - 1) / ArrayAlignment * ArrayAlignment;
+		header.offsets[a] = offset;
+		offset += count * ElementSize[a];
+	}
+
+	std::vector<uint8_t> data(static_cast<size_t>(offset), 0);
+	std::memcpy(data.data(), &header, sizeof(header));
+	parallelFor(0, count, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const ShapeInstance& shape = shapes[i];
+			const int32_t layer = shape.layer;
+			std::memcpy(&data[header.offsets[Scales] + i * ElementSize[Scales]], &shape.scale, ElementSize[Scales]);
+			std::memcpy(&data[header.offsets[Rotations] + i * ElementSize[Rotations]], &shape.rotation, ElementSize[Rotations]);
+			std::memcpy(&data[header.offsets[Translates] + i * ElementSize[Translates]], &shape.translate, ElementSize[Translates]);
+			std::memcpy(&data[header.offsets[Colors] + i * ElementSize[Colors]], &shape.color, ElementSize[Colors]);
+			std::memcpy(&data[header.offsets[Layers] + i * ElementSize[Layers]], &layer, ElementSize[Layers]);
+			std::memcpy(&data[header.offsets[Types] + i * ElementSize[Types]], &shape.type, ElementSize[Types]);
+		}
+	});
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) fail(filename, "Failed to create scene file");
+	file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	if (!file) fail(filename, "Failed to write scene file");
+}
+
+/////////////////////////////////////////////////////////////////////////// TEXT
+
+std::vector<ShapeInstance> readSceneText(const std::string& filename) {
+	std::ifstream file(filename);
+	if (!file.is_open()) fail(filename, "Failed to open scene file");
+
+	std::vector<ShapeInstance> shapes;
+	std::string line;
+	int number = 0;
+	while (std::getline(file, line)) {
+		number++;
+		const size_t comment = line.find('#');
+		if (comment != std::string::npos) line.erase(comment);
+		std::istringstream fields(line);
+		std::string name;
+		if (!(fields >> name)) continue;
+
+		ShapeInstance shape = {};
+		int type = 0;
+		while (type < static_cast<int>(ShapeType::Count) && name != TypeNames[type]) type++;
+		float degrees = 0.0f;
+		fields >> shape.scale.x >> shape.scale.y >> degrees
+			>> shape.translate.x >> shape.translate.y >> shape.translate.z
+			>> shape.color.r >> shape.color.g >> shape.color.b >> shape.color.a;
+		if (type == static_cast<int>(ShapeType::Count) || fields.fail()) {
+			fail(filename, "Malformed scene line " + std::to_string(number));
+		}
+		if (!(fields >> shape.layer)) shape.layer = 0;
+		shape.type = static_cast<ShapeType>(type);
+		shape.rotation = glm::radians(degrees);
+		shapes.push_back(shape);
+	}
+	return shapes;
+}
+
+void writeSceneText(const std::string& filename, const std::vector<ShapeInstance>& shapes) {
+	std::ofstream file(filename, std::ios::trunc);
+	if (!file.is_open()) fail(filename, "Failed to create scene file");
+	file << "# type sx sy degrees tx ty tz r g b a layer\n" << std::setprecision(9);
+	for (const ShapeInstance& shape : shapes) {
+		file << TypeNames[static_cast<int>(shape.type)] << ' '
+			<< shape.scale.x << ' ' << shape.scale.y << ' ' << glm::degrees(shape.rotation) << ' '
+			<< shape.translate.x << ' ' << shape.translate.y << ' ' << shape.translate.z << ' '
+			<< shape.color.r << ' ' << shape.color.g << ' ' << shape.color.b << ' ' << shape.color.a << ' '
+			<< shape.layer << '\n';
+	}
+}
+
+bool isBinaryScene(const std::string& filename) {
+	const std::string extension = ".tgsc";
+	return filename.size() >= extension.size() &&
+		filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+std::vector<ShapeInstance> loadScene(const std::string& filename) {
+	if (isBinaryScene(filename)) return SceneFile(filename).instances();
+	return readSceneText(filename);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+
+/* Binary scene layout (little endian). A 64 byte header followed by one
+   64-byte aligned array per field, so every array can be handed to
+   glBufferData straight out of the mapping:
+
+     char     magic[4]   "TGSC"
+     uint32   version    SceneFileVersion
+     uint64   count      number of instances
+     uint64   offsets[]  byte offset of each SceneArray from the file start */
+constexpr char SceneFileMagic[4] = { 'T', 'G', 'S', 'C' };
+constexpr uint32_t SceneFileVersion = 1;
+
+enum SceneArray { Scales, Rotations, Translates, Colors, Layers, Types, ArrayCount };
+
+struct SceneFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t count;
+	uint64_t offsets[ArrayCount];
+};
+
+/* Read-only view of a file mapped into memory. */
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const uint8_t* data() const { return Data; }
+	size_t size() const { return Size; }
+
+private:
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+
+	void release();
+#ifdef _WIN32
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#endif
+};
+
+/* Typed pointers into a mapped scene; nothing is copied or parsed. */
+struct SceneView {
+	size_t count = 0;
+	const glm::vec2* scales = nullptr;
+	const float* rotations = nullptr;
+	const glm::vec3* translates = nullptr;
+	const glm::vec4* colors = nullptr;
+	const int32_t* layers = nullptr;
+	const ShapeType* types = nullptr;
+};
+
+class SceneFile {
+public:
+	/* Maps the file and validates the header and array bounds. */
+	explicit SceneFile(const std::string& filename);
+
+	const SceneView& view() const { return View; }
+	std::vector<ShapeInstance> instances() const;
+
+private:
+	MappedFile File;
+	SceneView View;
+};
+
+void writeSceneBinary(const std::string& filename, const std::vector<ShapeInstance>& shapes);
+
+/* Text format for authoring, one instance per line, '#' starts a comment:
+     <triangle|square|parallelogram> sx sy degrees tx ty tz r g b a [layer] */
+std::vector<ShapeInstance> readSceneText(const std::string& filename);
+void writeSceneText(const std::string& filename, const std::vector<ShapeInstance>& shapes);
+
+/* True for the binary extension, .tgsc. */
+bool isBinaryScene(const std::string& filename);
+
+/* Picks the reader from the extension: .tgsc is binary, anything else text. */
+std::vector<ShapeInstance> loadScene(const std::string& filename);
@@ -1,23 +1,18 @@
 #include "ShapeRenderer.h"
+#include "Affine2D.h"
+#include "CommandList.h"
 
+template <typename Trig>
 glm::mat4 ShapeRenderer::applyTransform(
 	glm::vec2 scale,
 	float rotation, 
 	glm::vec3 translate
 ) {
-	glm::mat4 I(1.0f);
-
-	glm::mat4 S = glm::scale(I, glm::vec3(scale[0], scale[1], 1.0f));
-
-	glm::mat4 R = glm::rotate(I, rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-
-	glm::mat4 R2 = glm::rotate(I, glm::radians(15.0f), glm::vec3(0.0f,0.0f,1.0f)); //shape is slightly rotated
-
-	glm::mat4 T = glm::translate(I, translate);
-
-	return R2 * T * R * S;
+	return pieceAffine<Trig>(scale, rotation, glm::vec2(translate)).toMat4(translate.z);
 }
 
+template glm::mat4 ShapeRenderer::applyTransform<Exact_trig>(glm::vec2, float, glm::vec3);
+template glm::mat4 ShapeRenderer::applyTransform<Fast_trig>(glm::vec2, float, glm::vec3);
 
 void ShapeRenderer::draw_internal(
 	glm::vec2 scale,
@@ -27,8 +22,42 @@ void ShapeRenderer::draw_internal(
 	GLenum mode,
 	GLbyte offset
 ) {
-	glUniformMatrix4fv(MatrixID, 1, GL_FALSE, glm::value_ptr(applyTransform(scale, rotation,translate)));
+	draw_matrix_internal(glm::value_ptr(applyTransform(scale, rotation, translate)), color, mode, offset);
+}
+
+void ShapeRenderer::draw_matrix_internal(
+	const GLfloat* matrix,
+	glm::vec4 color,
+	GLenum mode,
+	GLbyte offset
+) {
+	const GLsizei count = mode == GL_TRIANGLE_STRIP ? 4 : 3;
+	if (Recorder) {
+		Recorder->record(MatrixID, ColorID, matrix, color, mode, count, offset);
+		return;
+	}
+	glUniformMatrix4fv(MatrixID, 1, GL_FALSE, matrix);
+	glUniform4fv(ColorID, 1, glm::value_ptr(color));
+	glDrawElements(mode, count, GL_UNSIGNED_BYTE,
+		reinterpret_cast<GLvoid*>(offset));
+}
+
+/* One int instead of sixteen floats: the matrix is already on the GPU. The
+   caller sets BakedPiece back to 0 when its baked draws are done. */
+void ShapeRenderer::draw_baked_internal(
+	GLint piece,
+	const GLfloat* matrix,
+	glm::vec4 color,
+	GLenum mode,
+	GLbyte offset
+) {
+	if (Recorder || BakedID < 0) {
+		draw_matrix_internal(matrix, color, mode, offset);
+		return;
+	}
+	const GLsizei count = mode == GL_TRIANGLE_STRIP ? 4 : 3;
+	glUniform1i(BakedID, piece + 1);
 	glUniform4fv(ColorID, 1, glm::value_ptr(color));
-	glDrawElements(mode, mode == GL_TRIANGLE_STRIP ? 4 : 3, GL_UNSIGNED_BYTE,
+	glDrawElements(mode, count, GL_UNSIGNED_BYTE,
 		reinterpret_cast<GLvoid*>(offset));
 }
\ No newline at end of file
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "FastTrig.h"
+
 #include <mgl.hpp>
 #include <GLFW/glfw3.h>
 #include <glm/fwd.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
+class CommandList;
+
 typedef struct {
 	GLfloat XYZW[4];
 	GLfloat RGBA[4];
@@ -21,12 +25,32 @@ public:
 		glm::vec4 color
 	) {};
 
+	/* Draws a piece of the baked layout, whose matrix is already in the
+	   BakedMatrices uniform block; matrix is its copy (column-major float[16])
+	   for recording and for programs without the block. */
+	virtual void drawBaked(GLint piece, const GLfloat* matrix, glm::vec4 color) {};
+
 	ShapeRenderer(GLint MatrixID, GLint ColorID) {
 		this->MatrixID = MatrixID;
 		this->ColorID = ColorID;
 	}
 
-	~ShapeRenderer() {};
+	virtual ~ShapeRenderer() {};
+
+	/* While set, draws are appended to the list instead of issued. */
+	void setRecorder(CommandList* list) { Recorder = list; }
+	/* Location of clip-vs.glsl's BakedPiece uniform; -1 draws baked pieces
+	   through the matrix uniform instead. */
+	void setBakedId(GLint bakedId) { BakedID = bakedId; }
+
+	/* R2 * T * R * S, where R2 is the fixed 15 degree tilt of the scene. Trig
+	   is the sine/cosine policy (FastTrig.h); instantiated for both. */
+	template <typename Trig = Transform_trig>
+	static glm::mat4 applyTransform(
+		glm::vec2 scale,
+		float rotation, 
+		glm::vec3 translate
+	);
 
 protected:
 	void draw_internal(
@@ -37,15 +61,24 @@ protected:
 		GLenum mode,
 		GLbyte offset
 	);
+	void draw_matrix_internal(
+		const GLfloat* matrix,
+		glm::vec4 color,
+		GLenum mode,
+		GLbyte offset
+	);
+	void draw_baked_internal(
+		GLint piece,
+		const GLfloat* matrix,
+		glm::vec4 color,
+		GLenum mode,
+		GLbyte offset
+	);
 
 private:	
 	GLint MatrixID;
 	GLint ColorID;
-
-	glm::mat4 applyTransform(
-		glm::vec2 scale,
-		float rotation, 
-		glm::vec3 translate
-	);
+	GLint BakedID = -1;
+	CommandList* Recorder = nullptr;
 };
 
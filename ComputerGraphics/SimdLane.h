@@ -0,0 +1,167 @@
+#pragma once
+
+/* A few float lane operations over the widest SIMD set the compiler targets
+   (AVX2, SSE2 or NEON). Batch kernels write one loop body against these and
+   finish the tail with scalar code; SIMD_LANES is undefined when no SIMD set
+   is available, and the scalar loop is then the whole kernel. */
+
+#include <cstddef>
+
+#if defined(__AVX2__)
+#define SIMD_LANES 8
+#define SIMD_ISA "AVX2"
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_LANES 4
+#define SIMD_ISA "SSE2"
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define SIMD_LANES 4
+#define SIMD_ISA "NEON"
+#include <arm_neon.h>
+#else
+#define SIMD_ISA "scalar"
+#endif
+
+#if defined(SIMD_LANES)
+namespace simd {
+
+#if defined(__AVX2__)
+typedef __m256 Lane;
+inline Lane load(const float* p) { return _mm256_loadu_ps(p); }
+inline void store(float* p, Lane v) { _mm256_storeu_ps(p, v); }
+inline Lane splat(float f) { return _mm256_set1_ps(f); }
+inline Lane add(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+inline Lane sub(Lane a, Lane b) { return _mm256_sub_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+inline Lane div(Lane a, Lane b) { return _mm256_div_ps(a, b); }
+inline Lane sqrt(Lane a) { return _mm256_sqrt_ps(a); }
+/* Masks are all-ones lanes where the comparison holds. */
+inline Lane less(Lane a, Lane b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Lane select(Lane mask, Lane a, Lane b) { return _mm256_blendv_ps(b, a, mask); }
+/* copysign(1, a) */
+inline Lane sign(Lane a) { return _mm256_or_ps(_mm256_and_ps(a, _mm256_set1_ps(-0.0f)), _mm256_set1_ps(1.0f)); }
+#elif defined(__ARM_NEON)
+typedef float32x4_t Lane;
+inline Lane load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, Lane v) { vst1q_f32(p, v); }
+inline Lane splat(float f) { return vdupq_n_f32(f); }
+inline Lane add(Lane a, Lane b) { return vaddq_f32(a, b); }
+inline Lane sub(Lane a, Lane b) { return vsubq_f32(a, b); }
+inline Lane mul(Lane a, Lane b) { return vmulq_f32(a, b); }
+inline Lane div(Lane a, Lane b) { return vdivq_f32(a, b); }
+inline Lane sqrt(Lane a) { return vsqrtq_f32(a); }
+inline Lane less(Lane a, Lane b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+inline Lane select(Lane mask, Lane a, Lane b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+inline Lane sign(Lane a) {
+	return vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(a), vdupq_n_u32(0x80000000u)),
+		vreinterpretq_u32_f32(vdupq_n_f32(1.0f))));
+}
+#else
+typedef __m128 Lane;
+inline Lane load(const float* p) { return _mm_loadu_ps(p); }
+inline void store(float* p, Lane v) { _mm_storeu_ps(p, v); }
+inline Lane splat(float f) { return _mm_set1_ps(f); }
+inline Lane add(Lane a, Lane b) { return _mm_add_ps(a, b); }
+inline Lane sub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+inline Lane mul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+inline Lane div(Lane a, Lane b) { return _mm_div_ps(a, b); }
+inline Lane sqrt(Lane a) { return _mm_sqrt_ps(a); }
+inline Lane less(Lane a, Lane b) { return _mm_cmplt_ps(a, b); }
+inline Lane select(Lane mask, Lane a, Lane b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline Lane sign(Lane a) { return _mm_or_ps(_mm_and_ps(a, _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f)); }
+#endif
+
+const size_t Width = SIMD_LANES;
+
+/* Double lanes, where the instruction set has them (not 32-bit NEON). */
+#if defined(__AVX2__)
+#define SIMD_DOUBLE_LANES 4
+typedef __m256d DoubleLane;
+inline DoubleLane load(const double* p) { return _mm256_loadu_pd(p); }
+inline void store(double* p, DoubleLane v) { _mm256_storeu_pd(p, v); }
+inline DoubleLane splat(double f) { return _mm256_set1_pd(f); }
+inline DoubleLane add(DoubleLane a, DoubleLane b) { return _mm256_add_pd(a, b); }
+inline DoubleLane sub(DoubleLane a, DoubleLane b) { return _mm256_sub_pd(a, b); }
+inline DoubleLane mul(DoubleLane a, DoubleLane b) { return _mm256_mul_pd(a, b); }
+inline DoubleLane div(DoubleLane a, DoubleLane b) { return _mm256_div_pd(a, b); }
+inline DoubleLane sqrt(DoubleLane a) { return _mm256_sqrt_pd(a); }
+inline DoubleLane less(DoubleLane a, DoubleLane b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+inline DoubleLane select(DoubleLane mask, DoubleLane a, DoubleLane b) { return _mm256_blendv_pd(b, a, mask); }
+inline unsigned bits(DoubleLane mask) { return static_cast<unsigned>(_mm256_movemask_pd(mask)); }
+inline unsigned bits(Lane mask) { return static_cast<unsigned>(_mm256_movemask_ps(mask)); }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define SIMD_DOUBLE_LANES 2
+typedef float64x2_t DoubleLane;
+inline DoubleLane load(const double* p) { return vld1q_f64(p); }
+inline void store(double* p, DoubleLane v) { vst1q_f64(p, v); }
+inline DoubleLane splat(double f) { return vdupq_n_f64(f); }
+inline DoubleLane add(DoubleLane a, DoubleLane b) { return vaddq_f64(a, b); }
+inline DoubleLane sub(DoubleLane a, DoubleLane b) { return vsubq_f64(a, b); }
+inline DoubleLane mul(DoubleLane a, DoubleLane b) { return vmulq_f64(a, b); }
+inline DoubleLane div(DoubleLane a, DoubleLane b) { return vdivq_f64(a, b); }
+inline DoubleLane sqrt(DoubleLane a) { return vsqrtq_f64(a); }
+inline DoubleLane less(DoubleLane a, DoubleLane b) { return vreinterpretq_f64_u64(vcltq_f64(a, b)); }
+inline DoubleLane select(DoubleLane mask, DoubleLane a, DoubleLane b) { return vbslq_f64(vreinterpretq_u64_f64(mask), a, b); }
+inline unsigned bits(DoubleLane mask) {
+	const uint64x2_t m = vshrq_n_u64(vreinterpretq_u64_f64(mask), 63);
+	return static_cast<unsigned>(vgetq_lane_u64(m, 0) | (vgetq_lane_u64(m, 1) << 1));
+}
+#elif !defined(__ARM_NEON)
+#define SIMD_DOUBLE_LANES 2
+typedef __m128d DoubleLane;
+inline DoubleLane load(const double* p) { return _mm_loadu_pd(p); }
+inline void store(double* p, DoubleLane v) { _mm_storeu_pd(p, v); }
+inline DoubleLane splat(double f) { return _mm_set1_pd(f); }
+inline DoubleLane add(DoubleLane a, DoubleLane b) { return _mm_add_pd(a, b); }
+inline DoubleLane sub(DoubleLane a, DoubleLane b) { return _mm_sub_pd(a, b); }
+inline DoubleLane mul(DoubleLane a, DoubleLane b) { return _mm_mul_pd(a, b); }
+inline DoubleLane div(DoubleLane a, DoubleLane b) { return _mm_div_pd(a, b); }
+inline DoubleLane sqrt(DoubleLane a) { return _mm_sqrt_pd(a); }
+inline DoubleLane less(DoubleLane a, DoubleLane b) { return _mm_cmplt_pd(a, b); }
+inline DoubleLane select(DoubleLane mask, DoubleLane a, DoubleLane b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+inline unsigned bits(DoubleLane mask) { return static_cast<unsigned>(_mm_movemask_pd(mask)); }
+inline unsigned bits(Lane mask) { return static_cast<unsigned>(_mm_movemask_ps(mask)); }
+#endif
+#if defined(__ARM_NEON)
+inline unsigned bits(Lane mask) {
+	const uint32x4_t lanes = { 1, 2, 4, 8 };
+	return vaddvq_u32(vandq_u32(vreinterpretq_u32_f32(mask), lanes));
+}
+#endif
+
+/* Lanes with arithmetic operators, so a kernel can be written once as a
+   template over its value type: Pack<T> for the SIMD body, plain T for the
+   tail. Comparisons give masks for select() and bits(). */
+/* LaneOf<T>::Exists tells templates whether Pack<T> is available. */
+template <typename T> struct LaneOf { static const bool Exists = false; };
+template <> struct LaneOf<float> { static const bool Exists = true; static const size_t Width = SIMD_LANES; typedef Lane Type; };
+#if defined(SIMD_DOUBLE_LANES)
+template <> struct LaneOf<double> { static const bool Exists = true; static const size_t Width = SIMD_DOUBLE_LANES; typedef DoubleLane Type; };
+#endif
+
+template <typename T>
+struct Pack {
+	typedef typename LaneOf<T>::Type L;
+	static const size_t Width = LaneOf<T>::Width;
+	L v;
+	Pack() {}
+	Pack(L l) : v(l) {}
+	Pack(T f) : v(splat(f)) {}
+	static Pack load(const T* p) { return simd::load(p); }
+	void store(T* p) const { simd::store(p, v); }
+
+	friend Pack operator+(Pack a, Pack b) { return add(a.v, b.v); }
+	friend Pack operator-(Pack a, Pack b) { return sub(a.v, b.v); }
+	friend Pack operator*(Pack a, Pack b) { return mul(a.v, b.v); }
+	friend Pack operator/(Pack a, Pack b) { return div(a.v, b.v); }
+	friend Pack operator-(Pack a) { return sub(splat(T(0)), a.v); }
+	friend Pack operator<(Pack a, Pack b) { return less(a.v, b.v); }
+	friend Pack sqrt(Pack a) { return simd::sqrt(a.v); }
+	friend Pack abs(Pack a) { return simd::select(less(a.v, splat(T(0))), sub(splat(T(0)), a.v), a.v); }
+	friend Pack select(Pack mask, Pack a, Pack b) { return simd::select(mask.v, a.v, b.v); }
+	friend unsigned bits(Pack mask) { return simd::bits(mask.v); }
+};
+
+} // namespace simd
+#endif
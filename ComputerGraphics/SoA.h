@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/* Structure-of-arrays containers for the batch math kernels: one contiguous
+   stream per component so a kernel loads the same component of several
+   elements into one register. */
+
+template <typename T>
+struct Vec3SoAT {
+	std::vector<T> x, y, z;
+
+	void resize(size_t n) { x.resize(n); y.resize(n); z.resize(n); }
+	size_t size() const { return x.size(); }
+	void set(size_t i, const glm::vec<3, T>& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+	glm::vec<3, T> get(size_t i) const { return glm::vec<3, T>(x[i], y[i], z[i]); }
+};
+typedef Vec3SoAT<float> Vec3SoA;
+
+struct QuatSoA {
+	std::vector<float> w, x, y, z;
+
+	void resize(size_t n) { w.resize(n); x.resize(n); y.resize(n); z.resize(n); }
+	size_t size() const { return w.size(); }
+	void set(size_t i, const glm::quat& q) { w[i] = q.w; x[i] = q.x; y[i] = q.y; z[i] = q.z; }
+	glm::quat get(size_t i) const { return glm::quat(w[i], x[i], y[i], z[i]); }
+};
+
+/* Column-major like glm: m[c * R + r] is the stream of element (row r, column c). */
+template <int C, int R, typename T>
+struct MatSoAT {
+	std::vector<T> m[C * R];
+
+	void resize(size_t n) { for (std::vector<T>& e : m) e.resize(n); }
+	size_t size() const { return m[0].size(); }
+	void set(size_t i, const glm::mat<C, R, T>& v) {
+		for (int c = 0; c < C; c++) for (int r = 0; r < R; r++) m[c * R + r][i] = v[c][r];
+	}
+	glm::mat<C, R, T> get(size_t i) const {
+		glm::mat<C, R, T> v;
+		for (int c = 0; c < C; c++) for (int r = 0; r < R; r++) v[c][r] = m[c * R + r][i];
+		return v;
+	}
+};
+typedef MatSoAT<3, 3, float> Mat3SoA;
+typedef MatSoAT<4, 4, float> Mat4SoA;
+typedef MatSoAT<3, 3, double> Mat3dSoA;
+typedef MatSoAT<4, 4, double> Mat4dSoA;
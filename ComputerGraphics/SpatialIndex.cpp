@@ -0,0 +1,475 @@
+#include "SpatialIndex.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <thread>
+
+Aabb2 Aabb2::empty() {
+	const float inf = std::numeric_limits<float>::max();
+	return { glm::vec2(inf), glm::vec2(-inf) };
+}
+
+Aabb2 Aabb2::of(const BoundsSoA& bounds, size_t i) {
+	return { glm::vec2(bounds.MinX[i], bounds.MinY[i]), glm::vec2(bounds.MaxX[i], bounds.MaxY[i]) };
+}
+
+static bool operator==(const Aabb2& a, const Aabb2& b) {
+	return a.min == b.min && a.max == b.max;
+}
+
+static void readItems(const BoundsSoA& bounds, std::vector<Aabb2>& items) {
+	items.resize(bounds.size());
+	for (size_t i = 0; i < items.size(); i++) items[i] = Aabb2::of(bounds, i);
+}
+
+static Aabb2 extentOf(const std::vector<Aabb2>& items) {
+	Aabb2 box = Aabb2::empty();
+	for (const Aabb2& item : items) box.grow(item);
+	if (items.empty()) box = { glm::vec2(-1.0f), glm::vec2(1.0f) };
+	return box;
+}
+
+/* Keeps the k closest candidates seen so far, worst on top. */
+class NearestSet {
+public:
+	explicit NearestSet(size_t k) : K(k) {}
+
+	bool full() const { return Heap.size() >= K; }
+	float worst() const { return full() ? Heap.top().first : std::numeric_limits<float>::max(); }
+
+	void offer(float d2, uint32_t item) {
+		if (K == 0) return;
+		if (!full()) {
+			Heap.push({ d2, item });
+		} else if (d2 < Heap.top().first) {
+			Heap.pop();
+			Heap.push({ d2, item });
+		}
+	}
+
+	void drain(std::vector<uint32_t>& out) {
+		out.resize(Heap.size());
+		for (size_t i = out.size(); i-- > 0;) {
+			out[i] = Heap.top().second;
+			Heap.pop();
+		}
+	}
+
+private:
+	size_t K;
+	std::priority_queue<std::pair<float, uint32_t>> Heap;
+};
+
+typedef std::pair<float, int32_t> NodeDistance;
+typedef std::priority_queue<NodeDistance, std::vector<NodeDistance>, std::greater<NodeDistance>> NodeQueue;
+
+////////////////////////////////////////////////////////////////// UNIFORM GRID
+
+void UniformGrid::cellRange(const Aabb2& box, int& x0, int& y0, int& x1, int& y1) const {
+	glm::vec2 lo = (box.min - Extent.min) / CellSize;
+	glm::vec2 hi = (box.max - Extent.min) / CellSize;
+	x0 = std::clamp(static_cast<int>(std::floor(lo.x)), 0, CellsX - 1);
+	y0 = std::clamp(static_cast<int>(std::floor(lo.y)), 0, CellsY - 1);
+	x1 = std::clamp(static_cast<int>(std::floor(hi.x)), 0, CellsX - 1);
+	y1 = std::clamp(static_cast<int>(std::floor(hi.y)), 0, CellsY - 1);
+}
+
+void UniformGrid::build(const BoundsSoA& bounds) {
+	readItems(bounds, Items);
+	Extent = extentOf(Items);
+
+	/* Cells roughly the size of an average item, capped so the table stays small. */
+	glm::vec2 average(0.0f);
+	for (const Aabb2& item : Items) average += item.max - item.min;
+	average /= std::max<size_t>(Items.size(), 1);
+	const glm::vec2 size = glm::max(Extent.max - Extent.min, glm::vec2(1e-6f));
+	const float fill = std::sqrt(size.x * size.y / std::max<size_t>(Items.size(), 1));
+	const float cell = std::max({ average.x, average.y, fill, 1e-6f });
+	CellsX = std::clamp(static_cast<int>(std::ceil(size.x / cell)), 1, 2048);
+	CellsY = std::clamp(static_cast<int>(std::ceil(size.y / cell)), 1, 2048);
+	CellSize = size / glm::vec2(CellsX, CellsY);
+
+	Cells.assign(static_cast<size_t>(CellsX) * CellsY, {});
+	for (uint32_t i = 0; i < Items.size(); i++) insert(i);
+	Stamp.assign(Items.size(), 0);
+	Query = 0;
+}
+
+void UniformGrid::insert(uint32_t item) {
+	int x0, y0, x1, y1;
+	cellRange(Items[item], x0, y0, x1, y1);
+	for (int y = y0; y <= y1; y++)
+		for (int x = x0; x <= x1; x++)
+			Cells[static_cast<size_t>(y) * CellsX + x].push_back(item);
+}
+
+void UniformGrid::remove(uint32_t item) {
+	int x0, y0, x1, y1;
+	cellRange(Items[item], x0, y0, x1, y1);
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			std::vector<uint32_t>& cell = Cells[static_cast<size_t>(y) * CellsX + x];
+			auto it = std::find(cell.begin(), cell.end(), item);
+			if (it != cell.end()) {
+				*it = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+}
+
+void UniformGrid::update(const BoundsSoA& bounds, const std::vector<uint32_t>& moved) {
+	for (uint32_t item : moved) {
+		remove(item);
+		Items[item] = Aabb2::of(bounds, item);
+		insert(item);
+	}
+}
+
+void UniformGrid::queryRange(const Aabb2& range, std::vector<uint32_t>& out) const {
+	out.clear();
+	if (Items.empty()) return;
+	const uint32_t query = ++Query;
+	int x0, y0, x1, y1;
+	cellRange(range, x0, y0, x1, y1);
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			for (uint32_t item : Cells[static_cast<size_t>(y) * CellsX + x]) {
+				if (Stamp[item] == query) continue;
+				Stamp[item] = query;
+				if (Items[item].overlaps(range)) out.push_back(item);
+			}
+		}
+	}
+}
+
+void UniformGrid::queryPoint(glm::vec2 point, std::vector<uint32_t>& out) const {
+	queryRange({ point, point }, out);
+}
+
+void UniformGrid::queryNearest(glm::vec2 point, size_t k, std::vector<uint32_t>& out) const {
+	out.clear();
+	if (Items.empty()) return;
+	const uint32_t query = ++Query;
+	NearestSet best(k);
+	int cx, cy, unused0, unused1;
+	cellRange({ point, point }, cx, cy, unused0, unused1);
+	const float step = std::min(CellSize.x, CellSize.y);
+	const int maxRing = std::max(CellsX, CellsY);
+
+	for (int ring = 0; ring <= maxRing; ring++) {
+		for (int y = cy - ring; y <= cy + ring; y++) {
+			if (y < 0 || y >= CellsY) continue;
+			const bool edgeRow = (y == cy - ring || y == cy + ring);
+			for (int x = cx - ring; x <= cx + ring; x += edgeRow ? 1 : 2 * std::max(ring, 1)) {
+				if (x < 0 || x >= CellsX) continue;
+				for (uint32_t item : Cells[static_cast<size_t>(y) * CellsX + x]) {
+					if (Stamp[item] == query) continue;
+					Stamp[item] = query;
+					best.offer(Items[item].distance2(point), item);
+				}
+			}
+		}
+		const float reach = ring * step;
+		if (best.full() && reach * reach >= best.worst()) break;
+	}
+	best.drain(out);
+}
+
+////////////////////////////////////////////////////////////////////// QUADTREE
+
+void Quadtree::build(const BoundsSoA& bounds) {
+	readItems(bounds, Items);
+	Aabb2 extent = extentOf(Items);
+	const glm::vec2 pad = (extent.max - extent.min) * 0.01f + glm::vec2(1e-6f);
+	Nodes.clear();
+	Nodes.push_back({ { extent.min - pad, extent.max + pad } });
+	ItemNode.assign(Items.size(), -1);
+	for (uint32_t i = 0; i < Items.size(); i++) insert(0, i);
+}
+
+void Quadtree::insert(int32_t node, uint32_t item) {
+	const Aabb2& box = Items[item];
+	while (Nodes[node].child >= 0) {
+		int32_t next = -1;
+		for (int32_t c = Nodes[node].child; c < Nodes[node].child + 4; c++) {
+			if (Nodes[c].box.contains(box)) {
+				next = c;
+				break;
+			}
+		}
+		if (next < 0) break;
+		node = next;
+	}
+	Nodes[node].items.push_back(item);
+	ItemNode[item] = node;
+	if (Nodes[node].child < 0 && Nodes[node].items.size() > SplitCount && Nodes[node].depth < MaxDepth) {
+		split(node);
+	}
+}
+
+void Quadtree::split(int32_t node) {
+	const Aabb2 box = Nodes[node].box;
+	const int depth = Nodes[node].depth + 1;
+	const glm::vec2 mid = (box.min + box.max) * 0.5f;
+	const int32_t first = static_cast<int32_t>(Nodes.size());
+	Nodes.push_back({ { box.min, mid }, -1, depth });
+	Nodes.push_back({ { glm::vec2(mid.x, box.min.y), glm::vec2(box.max.x, mid.y) }, -1, depth });
+	Nodes.push_back({ { glm::vec2(box.min.x, mid.y), glm::vec2(mid.x, box.max.y) }, -1, depth });
+	Nodes.push_back({ { mid, box.max }, -1, depth });
+	Nodes[node].child = first;
+
+	std::vector<uint32_t> items;
+	items.swap(Nodes[node].items);
+	for (uint32_t item : items) insert(node, item);
+}
+
+void Quadtree::remove(uint32_t item) {
+	std::vector<uint32_t>& items = Nodes[ItemNode[item]].items;
+	auto it = std::find(items.begin(), items.end(), item);
+	if (it != items.end()) {
+		*it = items.back();
+		items.pop_back();
+	}
+}
+
+void Quadtree::update(const BoundsSoA& bounds, const std::vector<uint32_t>& moved) {
+	for (uint32_t item : moved) {
+		Items[item] = Aabb2::of(bounds, item);
+		const int32_t node = ItemNode[item];
+		if (node > 0 && Nodes[node].box.contains(Items[item])) continue;
+		remove(item);
+		insert(0, item);
+	}
+}
+
+void Quadtree::queryRange(const Aabb2& range, std::vector<uint32_t>& out) const {
+	out.clear();
+	if (Nodes.empty()) return;
+	std::vector<int32_t> stack = { 0 };
+	while (!stack.empty()) {
+		const Node& node = Nodes[stack.back()];
+		stack.pop_back();
+		for (uint32_t item : node.items) {
+			if (Items[item].overlaps(range)) out.push_back(item);
+		}
+		if (node.child < 0) continue;
+		for (int32_t c = node.child; c < node.child + 4; c++) {
+			if (Nodes[c].box.overlaps(range)) stack.push_back(c);
+		}
+	}
+}
+
+void Quadtree::queryPoint(glm::vec2 point, std::vector<uint32_t>& out) const {
+	queryRange({ point, point }, out);
+}
+
+void Quadtree::queryNearest(glm::vec2 point, size_t k, std::vector<uint32_t>& out) const {
+	out.clear();
+	if (Nodes.empty()) return;
+	NearestSet best(k);
+	NodeQueue queue;
+	queue.push({ 0.0f, 0 }); // the root may hold items outside its box after updates
+	while (!queue.empty()) {
+		const NodeDistance top = queue.top();
+		queue.pop();
+		if (top.first > best.worst()) break;
+		const Node& node = Nodes[top.second];
+		for (uint32_t item : node.items) best.offer(Items[item].distance2(point), item);
+		if (node.child < 0) continue;
+		for (int32_t c = node.child; c < node.child + 4; c++) {
+			queue.push({ Nodes[c].box.distance2(point), c });
+		}
+	}
+	best.drain(out);
+}
+
+/////////////////////////////////////////////////////////////////////////// BVH
+
+void Bvh::build(const BoundsSoA& bounds) {
+	readItems(bounds, Items);
+	const uint32_t n = static_cast<uint32_t>(Items.size());
+	Centers.resize(n);
+	Indices.resize(n);
+	for (uint32_t i = 0; i < n; i++) {
+		Centers[i] = (Items[i].min + Items[i].max) * 0.5f;
+		Indices[i] = i;
+	}
+	Nodes.assign(std::max<uint32_t>(2 * n, 1), {});
+	Nodes[0].parent = -1;
+	NodeCount = 1;
+	buildNode(0, 0, n, 0);
+	Nodes.resize(NodeCount);
+
+	ItemLeaf.assign(n, 0);
+	for (uint32_t node = 0; node < Nodes.size(); node++) {
+		for (uint32_t i = 0; i < Nodes[node].count; i++) ItemLeaf[Indices[Nodes[node].first + i]] = node;
+	}
+}
+
+void Bvh::buildNode(uint32_t node, uint32_t begin, uint32_t end, int depth) {
+	Aabb2 box = Aabb2::empty();
+	Aabb2 centroids = Aabb2::empty();
+	for (uint32_t i = begin; i < end; i++) {
+		box.grow(Items[Indices[i]]);
+		centroids.grow({ Centers[Indices[i]], Centers[Indices[i]] });
+	}
+	Nodes[node].box = box;
+	Nodes[node].first = begin;
+	Nodes[node].count = end - begin;
+
+	const uint32_t count = end - begin;
+	if (count <= LeafSize) return;
+
+	const glm::vec2 spread = centroids.max - centroids.min;
+	const int axis = spread.x >= spread.y ? 0 : 1;
+	uint32_t mid = begin;
+
+	if (spread[axis] > 0.0f) {
+		/* Binned SAH: bucket the centroids and pick the cheapest bucket boundary. */
+		struct Bin { Aabb2 box = Aabb2::empty(); uint32_t count = 0; } bins[Bins];
+		const float scale = Bins / spread[axis];
+		auto binOf = [&](uint32_t item) {
+			return std::min(Bins - 1, static_cast<int>((Centers[item][axis] - centroids.min[axis]) * scale));
+		};
+		for (uint32_t i = begin; i < end; i++) {
+			Bin& bin = bins[binOf(Indices[i])];
+			bin.box.grow(Items[Indices[i]]);
+			bin.count++;
+		}
+		float rightArea[Bins];
+		uint32_t rightCount[Bins];
+		Aabb2 acc = Aabb2::empty();
+		uint32_t accCount = 0;
+		for (int b = Bins - 1; b > 0; b--) {
+			acc.grow(bins[b].box);
+			accCount += bins[b].count;
+			rightArea[b] = accCount ? acc.area() : 0.0f;
+			rightCount[b] = accCount;
+		}
+		float bestCost = std::numeric_limits<float>::max();
+		int bestSplit = -1;
+		acc = Aabb2::empty();
+		accCount = 0;
+		for (int b = 1; b < Bins; b++) {
+			acc.grow(bins[b - 1].box);
+			accCount += bins[b - 1].count;
+			if (accCount == 0 || rightCount[b] == 0) continue;
+			const float cost = acc.area() * accCount + rightArea[b] * rightCount[b];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestSplit = b;
+			}
+		}
+		if (bestSplit > 0) {
+			if (count <= 4 * LeafSize && bestCost >= box.area() * count) return;
+			mid = static_cast<uint32_t>(std::partition(Indices.begin() + begin, Indices.begin() + end,
+				[&](uint32_t item) { return binOf(item) < bestSplit; }) - Indices.begin());
+		}
+	}
+	if (mid == begin || mid == end) {
+		mid = begin + count / 2;
+		std::nth_element(Indices.begin() + begin, Indices.begin() + mid, Indices.begin() + end,
+			[&](uint32_t a, uint32_t b) { return Centers[a][axis] < Centers[b][axis]; });
+	}
+
+	const uint32_t left = NodeCount.fetch_add(2);
+	Nodes[node].first = left;
+	Nodes[node].count = 0;
+	Nodes[left].parent = static_cast<int32_t>(node);
+	Nodes[left + 1].parent = static_cast<int32_t>(node);
+
+	static const int parallelDepth = static_cast<int>(std::log2(workerCount())) + 1;
+	if (count >= ParallelThreshold && depth < parallelDepth) {
+		std::thread worker(&Bvh::buildNode, this, left, begin, mid, depth + 1);
+		buildNode(left + 1, mid, end, depth + 1);
+		worker.join();
+	} else {
+		buildNode(left, begin, mid, depth + 1);
+		buildNode(left + 1, mid, end, depth + 1);
+	}
+}
+
+void Bvh::update(const BoundsSoA& bounds, const std::vector<uint32_t>& moved) {
+	for (uint32_t item : moved) {
+		Items[item] = Aabb2::of(bounds, item);
+		Centers[item] = (Items[item].min + Items[item].max) * 0.5f;
+	}
+	if (moved.size() * 4 > Items.size()) {
+		/* Most pieces moved (animation): one bottom-up pass over all nodes is
+		   cheaper. Children are always allocated after their parent. */
+		for (size_t node = Nodes.size(); node-- > 0;) {
+			Aabb2 box = Aabb2::empty();
+			if (Nodes[node].count) {
+				for (uint32_t i = 0; i < Nodes[node].count; i++) box.grow(Items[Indices[Nodes[node].first + i]]);
+			} else {
+				box = Nodes[Nodes[node].first].box;
+				box.grow(Nodes[Nodes[node].first + 1].box);
+			}
+			Nodes[node].box = box;
+		}
+		return;
+	}
+	for (uint32_t item : moved) {
+		int32_t node = static_cast<int32_t>(ItemLeaf[item]);
+		Aabb2 box = Aabb2::empty();
+		for (uint32_t i = 0; i < Nodes[node].count; i++) box.grow(Items[Indices[Nodes[node].first + i]]);
+		Nodes[node].box = box;
+		for (node = Nodes[node].parent; node >= 0; node = Nodes[node].parent) {
+			box = Nodes[Nodes[node].first].box;
+			box.grow(Nodes[Nodes[node].first + 1].box);
+			if (box == Nodes[node].box) break;
+			Nodes[node].box = box;
+		}
+	}
+}
+
+void Bvh::queryRange(const Aabb2& range, std::vector<uint32_t>& out) const {
+	out.clear();
+	if (Items.empty()) return;
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty()) {
+		const Node& node = Nodes[stack.back()];
+		stack.pop_back();
+		if (!node.box.overlaps(range)) continue;
+		if (node.count) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				if (Items[Indices[i]].overlaps(range)) out.push_back(Indices[i]);
+			}
+		} else {
+			stack.push_back(node.first);
+			stack.push_back(node.first + 1);
+		}
+	}
+}
+
+void Bvh::queryPoint(glm::vec2 point, std::vector<uint32_t>& out) const {
+	queryRange({ point, point }, out);
+}
+
+void Bvh::queryNearest(glm::vec2 point, size_t k, std::vector<uint32_t>& out) const {
+	out.clear();
+	if (Items.empty()) return;
+	NearestSet best(k);
+	NodeQueue queue;
+	queue.push({ Nodes[0].box.distance2(point), 0 });
+	while (!queue.empty()) {
+		const NodeDistance top = queue.top();
+		queue.pop();
+		if (top.first > best.worst()) break;
+		const Node& node = Nodes[top.second];
+		if (node.count) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				best.offer(Items[Indices[i]].distance2(point), Indices[i]);
+			}
+		} else {
+			for (uint32_t c = node.first; c < node.first + 2; c++) {
+				queue.push({ Nodes[c].box.distance2(point), static_cast<int32_t>(c) });
+			}
+		}
+	}
+	best.drain(out);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "Culling.h"
+
+struct Aabb2 {
+	glm::vec2 min;
+	glm::vec2 max;
+
+	bool overlaps(const Aabb2& o) const {
+		return max.x >= o.min.x && min.x <= o.max.x && max.y >= o.min.y && min.y <= o.max.y;
+	}
+	bool contains(glm::vec2 p) const {
+		return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y;
+	}
+	bool contains(const Aabb2& o) const {
+		return o.min.x >= min.x && o.max.x <= max.x && o.min.y >= min.y && o.max.y <= max.y;
+	}
+	void grow(const Aabb2& o) {
+		min = glm::min(min, o.min);
+		max = glm::max(max, o.max);
+	}
+	float area() const {
+		glm::vec2 d = glm::max(max - min, glm::vec2(0.0f));
+		return d.x * d.y;
+	}
+	float distance2(glm::vec2 p) const {
+		glm::vec2 d = glm::max(glm::max(min - p, p - max), glm::vec2(0.0f));
+		return glm::dot(d, d);
+	}
+
+	static Aabb2 empty();
+	static Aabb2 of(const BoundsSoA& bounds, size_t i);
+};
+
+/* Common interface of the acceleration structures over shape instance bounds.
+   Results are instance indices into the BoundsSoA the index was built from. */
+class SpatialIndex {
+public:
+	virtual ~SpatialIndex() {};
+
+	virtual const char* name() const = 0;
+	virtual void build(const BoundsSoA& bounds) = 0;
+	/* Re-reads the bounds of the moved instances without a full rebuild. */
+	virtual void update(const BoundsSoA& bounds, const std::vector<uint32_t>& moved) = 0;
+
+	virtual void queryRange(const Aabb2& range, std::vector<uint32_t>& out) const = 0;
+	virtual void queryPoint(glm::vec2 point, std::vector<uint32_t>& out) const = 0;
+	/* The k instances whose bounds are closest to point, nearest first. */
+	virtual void queryNearest(glm::vec2 point, size_t k, std::vector<uint32_t>& out) const = 0;
+};
+
+////////////////////////////////////////////////////////////////// UNIFORM GRID
+
+class UniformGrid : public SpatialIndex {
+public:
+	const char* name() const override { return "grid"; }
+	void build(const BoundsSoA& bounds) override;
+	void update(const BoundsSoA& bounds, const std::vector<uint32_t>& moved) override;
+	void queryRange(const Aabb2& range, std::vector<uint32_t>& out) const override;
+	void queryPoint(glm::vec2 point, std::vector<uint32_t>& out) const override;
+	void queryNearest(glm::vec2 point, size_t k, std::vector<uint32_t>& out) const override;
+
+private:
+	Aabb2 Extent;
+	glm::vec2 CellSize;
+	int CellsX = 0, CellsY = 0;
+	std::vector<std::vector<uint32_t>> Cells;
+	std::vector<Aabb2> Items;
+	mutable std::vector<uint32_t> Stamp;
+	mutable uint32_t Query = 0;
+
+	void cellRange(const Aabb2& box, int& x0, int& y0, int& x1, int& y1) const;
+	void insert(uint32_t item);
+	void remove(uint32_t item);
+};
+
+////////////////////////////////////////////////////////////////////// QUADTREE
+
+class Quadtree : public SpatialIndex {
+public:
+	const char* name() const override { return "quadtree"; }
+	void build(const BoundsSoA& bounds) override;
+	void update(const BoundsSoA& bounds, const std::vector<uint32_t>& moved) override;
+	void queryRange(const Aabb2& range, std::vector<uint32_t>& out) const override;
+	void queryPoint(glm::vec2 point, std::vector<uint32_t>& out) const override;
+	void queryNearest(glm::vec2 point, size_t k, std::vector<uint32_t>& out) const override;
+
+private:
+	static constexpr int MaxDepth = 12;
+	static constexpr size_t SplitCount = 16;
+
+	struct Node {
+		Aabb2 box;
+		int32_t child = -1; // first of four consecutive children, -1 for a leaf
+		int depth = 0;
+		std::vector<uint32_t> items;
+	};
+	std::vector<Node> Nodes;
+	std::vector<Aabb2> Items;
+	std::vector<int32_t> ItemNode;
+
+	void insert(int32_t node, uint32_t item);
+	void split(int32_t node);
+	void remove(uint32_t item);
+};
+
+/////////////////////////////////////////////////////////////////////////// BVH
+
+class Bvh : public SpatialIndex {
+public:
+	const char* name() const override { return "bvh"; }
+	/* Full rebuild with binned SAH; large subtrees are built in parallel. */
+	void build(const BoundsSoA& bounds) override;
+	/* Refits the leaves of the moved instances and their ancestors. */
+	void update(const BoundsSoA& bounds, const std::vector<uint32_t>& moved) override;
+	void queryRange(const Aabb2& range, std::vector<uint32_t>& out) const override;
+	void queryPoint(glm::vec2 point, std::vector<uint32_t>& out) const override;
+	void queryNearest(glm::vec2 point, size_t k, std::vector<uint32_t>& out) const override;
+
+private:
+	static constexpr int Bins = 16;
+	static constexpr uint32_t LeafSize = 4;
+	static constexpr uint32_t ParallelThreshold = 16384;
+
+	struct Node {
+		Aabb2 box;
+		uint32_t first;  // first child for an inner node, first index for a leaf
+		uint32_t count;  // 0 for an inner node
+		int32_t parent;
+	};
+	std::vector<Node> Nodes;
+	std::atomic<uint32_t> NodeCount{ 0 };
+	std::vector<uint32_t> Indices;
+	std::vector<Aabb2> Items;
+	std::vector<glm::vec2> Centers;
+	std::vector<uint32_t> ItemLeaf;
+
+	void buildNode(uint32_t node, uint32_t begin, uint32_t end, int depth);
+};
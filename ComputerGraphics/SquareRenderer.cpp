@@ -9,3 +9,7 @@ void SquareRenderer::draw(
 ) {
 	this->draw_internal(scale, rotation, translate, color, GL_TRIANGLE_STRIP, 3);
 }
+
+void SquareRenderer::drawBaked(GLint piece, const GLfloat* matrix, glm::vec4 color) {
+	this->draw_baked_internal(piece, matrix, color, GL_TRIANGLE_STRIP, 3);
+}
@@ -11,6 +11,8 @@ public:
 		glm::vec4 color
 	) override;
 
+	void drawBaked(GLint piece, const GLfloat* matrix, glm::vec4 color) override;
+
 	SquareRenderer(GLint MatrixID, GLint ColorID) : ShapeRenderer(MatrixID, ColorID) {}
 
 	~SquareRenderer() {};
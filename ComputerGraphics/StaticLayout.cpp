@@ -0,0 +1,31 @@
+#include "StaticLayout.h"
+
+#include <cmath>
+
+/* The baker must agree with libm, and the layout with what it bakes. */
+static_assert(bakeSin(BakePi / 6.0) > 0.5 - 1.0e-15 && bakeSin(BakePi / 6.0) < 0.5 + 1.0e-15, "constexpr sin");
+static_assert(bakeCos(BakePi) == -1.0 && bakeSin(BakePi / 2.0) == 1.0, "constexpr quadrants");
+static_assert(BakedTangram[0].m[0] > 0.2414f && BakedTangram[0].m[0] < 0.2415f, "tangram square: 0.25 cos 15");
+
+std::vector<ShapeInstance> layoutInstances(const StaticPiece* pieces, size_t count) {
+	std::vector<ShapeInstance> shapes(count);
+	for (size_t i = 0; i < count; i++) {
+		const StaticPiece& piece = pieces[i];
+		shapes[i] = { piece.type, piece.scale, glm::radians(piece.degrees), glm::vec3(piece.translate, 0.0f), piece.color, piece.layer };
+	}
+	return shapes;
+}
+
+bool matchesLayout(const std::vector<ShapeInstance>& shapes, const StaticPiece* pieces, size_t count) {
+	if (shapes.size() != count) return false;
+	const float tolerance = 1.0e-6f;
+	for (size_t i = 0; i < count; i++) {
+		const ShapeInstance& shape = shapes[i];
+		const StaticPiece& piece = pieces[i];
+		if (shape.type != piece.type || shape.layer != piece.layer) return false;
+		if (std::abs(shape.rotation - glm::radians(piece.degrees)) > tolerance) return false;
+		if (glm::any(glm::greaterThan(glm::abs(shape.scale - piece.scale), glm::vec2(tolerance)))) return false;
+		if (glm::any(glm::greaterThan(glm::abs(glm::vec2(shape.translate) - piece.translate), glm::vec2(tolerance)))) return false;
+	}
+	return true;
+}
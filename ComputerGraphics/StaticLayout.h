@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "Color.h"
+#include "Scene.h"
+
+/* Compile-time transforms for layouts that never move. A layout is a
+   constexpr array of pieces; bakeLayout turns it into the same
+   R2 * T * R * S matrices ShapeRenderer::applyTransform builds at run time,
+   evaluated by the compiler in double and rounded once to float. The result
+   is a plain array of column-major float[16] in read-only data, which is
+   also the std140 layout of a mat4 array: it uploads to the BakedMatrices
+   uniform block of clip-vs.glsl with one glBufferData. */
+
+/* Taylor series after reduction to [-pi/4, pi/4]; within 1 ulp of double
+   sin/cos for the angles layouts use (|x| of a few turns). */
+constexpr double BakePi = 3.14159265358979323846;
+
+constexpr double bakeSeries(double r, double term, int first) {
+	double sum = term;
+	const double r2 = r * r;
+	for (int n = first; n < first + 30 && term != 0.0; n += 2) {
+		term *= -r2 / ((n + 1.0) * (n + 2.0));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr void bakeSinCos(double x, double& s, double& c) {
+	const double quarters = x / (BakePi / 2.0);
+	long long k = static_cast<long long>(quarters < 0.0 ? quarters - 0.5 : quarters + 0.5);
+	const double r = x - static_cast<double>(k) * (BakePi / 2.0);
+	const double sr = bakeSeries(r, r, 1), cr = bakeSeries(r, 1.0, 0);
+	switch (((k % 4) + 4) % 4) {
+	case 0: s = sr; c = cr; break;
+	case 1: s = cr; c = -sr; break;
+	case 2: s = -sr; c = -cr; break;
+	default: s = -cr; c = sr; break;
+	}
+}
+
+constexpr double bakeSin(double x) { double s = 0.0, c = 0.0; bakeSinCos(x, s, c); return s; }
+constexpr double bakeCos(double x) { double s = 0.0, c = 0.0; bakeSinCos(x, s, c); return c; }
+
+/* Column-major 4x4 in double while baking. */
+struct BakeMatrix {
+	double m[16] = {};
+
+	static constexpr BakeMatrix identity() {
+		BakeMatrix r;
+		for (int i = 0; i < 4; i++) r.m[i * 5] = 1.0;
+		return r;
+	}
+	static constexpr BakeMatrix translate(double x, double y, double z) {
+		BakeMatrix r = identity();
+		r.m[12] = x; r.m[13] = y; r.m[14] = z;
+		return r;
+	}
+	static constexpr BakeMatrix rotateZ(double rads) {
+		BakeMatrix r = identity();
+		double s = 0.0, c = 0.0;
+		bakeSinCos(rads, s, c);
+		r.m[0] = c; r.m[1] = s;
+		r.m[4] = -s; r.m[5] = c;
+		return r;
+	}
+	static constexpr BakeMatrix scale(double x, double y, double z) {
+		BakeMatrix r = identity();
+		r.m[0] = x; r.m[5] = y; r.m[10] = z;
+		return r;
+	}
+
+	constexpr BakeMatrix operator*(const BakeMatrix& b) const {
+		BakeMatrix r;
+		for (int c = 0; c < 4; c++) {
+			for (int row = 0; row < 4; row++) {
+				double sum = 0.0;
+				for (int k = 0; k < 4; k++) sum += m[k * 4 + row] * b.m[c * 4 + k];
+				r.m[c * 4 + row] = sum;
+			}
+		}
+		return r;
+	}
+};
+
+/* What the GPU gets: float[16], column-major like glm::value_ptr. */
+struct BakedMatrix {
+	float m[16] = {};
+};
+
+struct StaticPiece {
+	ShapeType type;
+	glm::vec2 scale;
+	float degrees;
+	glm::vec2 translate;
+	glm::vec4 color;
+	int layer = 0;
+};
+
+/* R2 * T * R * S with R2 the scene's 15 degree tilt and z from the layer,
+   as orderForSubmission and applyTransform would set them. */
+constexpr BakedMatrix bakeTransform(const StaticPiece& piece, const BakeMatrix& view = BakeMatrix::identity()) {
+	const double toRadians = BakePi / 180.0;
+	const BakeMatrix model = BakeMatrix::rotateZ(15.0 * toRadians)
+		* BakeMatrix::translate(piece.translate.x, piece.translate.y, layerDepth(piece.layer))
+		* BakeMatrix::rotateZ(piece.degrees * toRadians)
+		* BakeMatrix::scale(piece.scale.x, piece.scale.y, 1.0);
+	const BakeMatrix full = view * model;
+	BakedMatrix baked;
+	for (int i = 0; i < 16; i++) baked.m[i] = static_cast<float>(full.m[i]);
+	return baked;
+}
+
+template <size_t N>
+constexpr std::array<BakedMatrix, N> bakeLayout(const StaticPiece (&pieces)[N], const BakeMatrix& view = BakeMatrix::identity()) {
+	std::array<BakedMatrix, N> baked = {};
+	for (size_t i = 0; i < N; i++) baked[i] = bakeTransform(pieces[i], view);
+	return baked;
+}
+
+/* The default tangram figure (tangram.txt holds the same pieces), one layer
+   per piece so depth orders them and early-Z has something to reject. */
+constexpr StaticPiece TangramLayout[] = {
+	{ ShapeType::Square,		{ 0.25f, 0.25f }, 0.0f,   { 0.0f, 0.0f },   Color::Green, 0 },
+	{ ShapeType::Parallelogram,	{ 0.25f, 0.25f }, 0.0f,   { 0.25f, 0.0f },  Color::Yellow, 1 },
+	{ ShapeType::Triangle,		{ 0.25f, 0.25f }, 90.0f,  { 0.75f, 0.4f },  Color::Purple, 2 },
+	{ ShapeType::Triangle,		{ 0.5f, 0.5f },   270.0f, { -0.5f, 0.25f }, Color::Magenta, 3 },
+	{ ShapeType::Triangle,		{ 0.25f, 0.25f }, 180.0f, { 0.0f, 0.5f },   Color::Cyan, 4 },
+	{ ShapeType::Triangle,		{ 0.5f, 0.5f },   315.0f, { -0.957106781f, 0.0f }, Color::Blue, 5 },	// -sqrt(1/2) - 1/4
+	{ ShapeType::Triangle,		{ 0.25f, 0.25f }, 135.0f, { -0.25f, 0.0f }, Color::Orange, 6 },
+};
+constexpr size_t TangramPieces = sizeof(TangramLayout) / sizeof(TangramLayout[0]);
+
+inline constexpr std::array<BakedMatrix, TangramPieces> BakedTangram = bakeLayout(TangramLayout);
+/* clip-vs.glsl declares BakedMatrices as mat4 Baked[BakedSlots]. */
+constexpr size_t BakedSlots = 7;
+static_assert(TangramPieces <= BakedSlots, "the baked tangram does not fit the BakedMatrices block of clip-vs.glsl");
+
+/* Shape instances of a layout, for the code paths that work on instances. */
+std::vector<ShapeInstance> layoutInstances(const StaticPiece* pieces, size_t count);
+
+/* True when shapes, in authored order, are exactly the pieces of the layout,
+   so the layout's baked matrices can stand in for applyTransform. */
+bool matchesLayout(const std::vector<ShapeInstance>& shapes, const StaticPiece* pieces, size_t count);
@@ -8,3 +8,7 @@ void TriangleRenderer::draw(
 ) {
 	this->draw_internal(scale, rotation, translate, color, GL_TRIANGLES, 0);
 }
+
+void TriangleRenderer::drawBaked(GLint piece, const GLfloat* matrix, glm::vec4 color) {
+	this->draw_baked_internal(piece, matrix, color, GL_TRIANGLES, 0);
+}
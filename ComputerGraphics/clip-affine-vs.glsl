@@ -0,0 +1,14 @@
+#version 330 core
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 2) in vec4 inLinear;		// x and y columns of the piece's Affine2D
+layout(location = 3) in vec3 inOffset;		// translation, then depth
+layout(location = 4) in vec4 inInstanceColor;
+
+out vec4 exColor;
+
+void main(void) {
+    vec2 p = mat2(inLinear.xy, inLinear.zw) * inPosition.xy + inOffset.xy;
+    gl_Position = vec4(p, inOffset.z, 1.0);
+    exColor = inInstanceColor;
+}
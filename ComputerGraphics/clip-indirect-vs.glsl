@@ -0,0 +1,22 @@
+#version 460 core
+
+layout(location = 0) in vec4 inPosition;
+
+struct Draw {
+    mat4 Matrix;
+    vec4 Color;
+};
+
+// One entry per recorded draw (CommandList::DrawData).
+layout(std430, binding = 0) readonly buffer Draws {
+    Draw draws[];
+};
+
+uniform int DrawBase;
+out vec4 exColor;
+
+void main(void) {
+    Draw draw = draws[DrawBase + gl_DrawID];
+    gl_Position = draw.Matrix * inPosition;
+    exColor = draw.Color;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 5) in vec3 inScaleRotation;	// scale x, scale y, rotation in radians
+layout(location = 6) in vec3 inTranslate;		// translation, then depth
+layout(location = 7) in vec4 inInstanceColor;
+
+uniform vec2 Tilt;	// cos and sin of the figure's tilt (R2)
+
+out vec4 exColor;
+
+vec2 rotate(vec2 p, float c, float s) {
+    return vec2(c * p.x - s * p.y, s * p.x + c * p.y);
+}
+
+// R2 * T * R * S, built per vertex from the raw parameters.
+void main(void) {
+    vec2 p = rotate(inPosition.xy * inScaleRotation.xy, cos(inScaleRotation.z), sin(inScaleRotation.z));
+    p = rotate(p + inTranslate.xy, Tilt.x, Tilt.y);
+    gl_Position = vec4(p, inTranslate.z, 1.0);
+    exColor = inInstanceColor;
+}
@@ -0,0 +1,32 @@
+#version 430 core
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 5) in uint inPiece;	// index into the scene arrays
+
+// The arrays of a binary scene file, as uploaded from the mapping.
+layout(std430, binding = 0) readonly buffer Scales { vec2 scales[]; };
+layout(std430, binding = 1) readonly buffer Rotations { float rotations[]; };
+layout(std430, binding = 2) readonly buffer Translates { float translates[]; };	// packed vec3
+layout(std430, binding = 3) readonly buffer Colors { vec4 colors[]; };
+layout(std430, binding = 4) readonly buffer Layers { int layers[]; };
+
+uniform vec2 Tilt;	// cos and sin of the figure's tilt (R2)
+
+out vec4 exColor;
+
+const int MaxLayers = 1048576;	// Scene.h
+
+vec2 rotate(vec2 p, float c, float s) {
+    return vec2(c * p.x - s * p.y, s * p.x + c * p.y);
+}
+
+// R2 * T * R * S as in clip-params-vs.glsl, depth from the layer as layerDepth.
+void main(void) {
+    uint i = inPiece;
+    float r = rotations[i];
+    vec2 p = rotate(inPosition.xy * scales[i], cos(r), sin(r));
+    p = rotate(p + vec2(translates[3 * i], translates[3 * i + 1]), Tilt.x, Tilt.y);
+    float depth = 1.0 - 2.0 * float(clamp(layers[i], 0, MaxLayers - 1) + 1) / float(MaxLayers + 1);
+    gl_Position = vec4(p, depth, 1.0);
+    exColor = colors[i];
+}
@@ -10,7 +10,15 @@ out vec4 exColor;
 uniform mat4 Matrix;
 uniform vec4 dynamicColor;
 
+// The layout baked at compile time (StaticLayout.h), uploaded once.
+// BakedPiece is 1 + the piece to draw from it, or 0 to use Matrix.
+layout(std140) uniform BakedMatrices {
+    mat4 Baked[7];
+};
+uniform int BakedPiece;
+
 void main(void) {
-    gl_Position = Matrix * inPosition;
+    mat4 model = BakedPiece > 0 ? Baked[BakedPiece - 1] : Matrix;
+    gl_Position = model * inPosition;
     exColor = dynamicColor;
 }
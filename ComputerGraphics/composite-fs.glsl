@@ -0,0 +1,8 @@
+#version 330 core
+
+uniform sampler2D Layers;
+out vec4 outColor;
+
+void main(void) {
+    outColor = texelFetch(Layers, ivec2(gl_FragCoord.xy), 0);
+}
@@ -23,38 +23,153 @@
 #include "../mgl/mgl.hpp"
 
 #include "ShapeRenderer.h"
+#include "AffineRenderer.h"
+#include "ParameterRenderer.h"
+#include "MultiViewRenderer.h"
+#include "FrameCapture.h"
+#include "GpuTimer.h"
 
 /* Base Shapes Include and Color */
 #include "Color.h"
 #include "SquareRenderer.h"
 #include "TriangleRenderer.h"
 #include "ParellelogramRenderer.h"
+#include "Scene.h"
+#include "StaticLayout.h"
+#include "Culling.h"
+#include "SpatialIndex.h"
+#include "Picking.h"
+#include "Overdraw.h"
+#include "LayerCache.h"
+#include "CommandList.h"
+#include "ResolutionScaler.h"
+#include "SceneFile.h"
+#include "SceneBuffer.h"
+#include "Animation.h"
+#include "Benchmarks.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <string>
 
 
 ////////////////////////////////////////////////////////////////////////// MYAPP
 
+struct Options {
+	size_t Pieces = 0;							// random stress scene instead of a file
+	std::string Scene;							// empty: tangram.txt, or the built-in figure without it
+	std::string Morph;							// figure the A key morphs to; empty: tangram-exploded.txt
+	mgl::RenderMode Render = mgl::RenderMode::OnDemand;	// continuous to compare idle cost
+	bool Damage = true;									// redraw only what changed
+	bool Layers = true;									// cache static layers in a texture
+	ReplayMode Replay = ReplayMode::Indirect;			// of the matrix path at rest
+	int FramesInFlight = 2;
+	bool LowLatency = false;							// wait for the GPU before sampling input
+	double TargetMs = 12.0;								// GPU time per frame before resolution drops; 0 keeps full resolution
+	int Views = 1;										// viewports the scene is drawn into in one pass
+	std::string Capture;								// .y4m, .ppm or .png to record from the first frame
+	int CaptureFps = 60;								// frame rate in the Y4M header
+};
+
 class MyApp : public mgl::App {
 public:
-	MyApp() = default;
+	explicit MyApp(const Options& options) : Settings(options) {}
 	~MyApp() override = default;
 
 	void initCallback(GLFWwindow* win) override;
 	void displayCallback(GLFWwindow* win, double elapsed) override;
 	void windowCloseCallback(GLFWwindow* win) override;
 	void windowSizeCallback(GLFWwindow* win, int width, int height) override;
+	void cursorCallback(GLFWwindow* win, double xpos, double ypos) override;
+	void keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods) override;
+	void mouseButtonCallback(GLFWwindow* win, int button, int action, int mods) override;
 
 private:
 	const GLuint POSITION = 0, COLOR = 1;
+	const GLuint BAKED_BINDING = 0;
 	GLuint VaoId, VboId[2];
+	GLuint BakedUbo = 0;
 	std::unique_ptr<mgl::ShaderProgram> Shaders = nullptr;
 	GLint MatrixId;
 	GLint UniformColorId;
+	GLint BakedPieceId;
+
+	std::unique_ptr<ShapeRenderer> Renderers[static_cast<int>(ShapeType::Count)];
+	std::vector<ShapeInstance> Shapes;
+	size_t FirstBlended = 0;
+	const BakedMatrix* Baked = nullptr;		// compile-time matrices when the scene is a static layout
+	std::vector<uint32_t> Authored;			// authored index of every submission slot, for Baked
+	TransformPath Path = TransformPath::Matrix;
+	AffineRenderer Affine;
+	ParameterRenderer Parameters;
+	GpuTimer DrawTimer;
+	double DrawCpu = 0.0, DrawGpu = 0.0;	// ms of the scene pass since the last report
+	int CpuFrames = 0, GpuFrames = 0;
+	BoundsSoA Bounds;
+	BoundsSoA LastBounds;					// before the last animation step, for damage
+	bool BoundsDirty = true;
+	std::vector<uint32_t> Visible;
+	CullStats LastCull;
+	double StatsTimer = 0.0;
+	Options Settings;
+
+	GLFWwindow* Window = nullptr;
+	int Width = 0, Height = 0;				// window coordinates, like the cursor
+	glm::dvec2 Cursor;
+	Bvh SceneIndex;
+	PickMode Picking = PickMode::Cpu;
+	GpuPicker Picker;
+	int32_t Selected = -1;
+
+	PoseAnimation Morph;
+	std::vector<uint32_t> AllPieces;
+	bool Animating = false;
+	float AnimationTime = 0.0f;
+
+	LayerCache Layers;
+	int LowestLayer = 0;					// of the whole scene
+	int LowestMoving = MaxLayers;			// of the pieces the morph moves
+	std::vector<uint32_t> Static, Live;		// visible shapes below and above the cut
+
+	ResolutionScaler Scaler;
+
+	SceneBuffer Mapped;						// a binary scene drawn from its file, when one is loaded
+	MultiViewRenderer MultiView;			// with more than one view, every frame draws through it
+
+	FrameCapture Capture;
+
+	CommandList Commands;					// the matrix path's draws, while nothing moves
+	ReplayMode Replay = ReplayMode::Immediate;
+
+	OverdrawCounter Overdraw;
+	OverdrawStats LastOverdraw;
+	bool MeasureOverdraw = true;
+	bool OverdrawLive = false;		// last measurement left the cached layers out
 
 	void createShaderProgram();
 	void createBufferObjects(/*Vertex* vertices, GLubyte* indices*/);
 	void destroyBufferObjects();
+	void createScene();
+	void createMorph(const std::vector<uint32_t>& order);
+	void animate(double elapsed);
+	void refreshBounds();
+	void cullScene(const ClipRect& rect = ClipRect());
+	void damageShape(uint32_t i, const BoundsSoA& bounds);
+	void damageMoved();
+	void select(int32_t picked);
+	void drawShapes(std::vector<uint32_t>::const_iterator first, std::vector<uint32_t>::const_iterator last);
+	void drawSorted(const std::vector<uint32_t>& list);
+	bool cachedLayers() const;
+	void updateLayers();
+	const std::vector<uint32_t>& liveShapes();
+	void recordCommands();
 	void drawScene();
+	void reportStats(double elapsed);
+	void renderViewport() const;
+	glm::vec2 windowToClip(glm::dvec2 window) const;
+	void pick();
+	void pickPass();
 };
 
 
@@ -69,11 +184,14 @@ void MyApp::createShaderProgram() {
 	Shaders->addAttribute(mgl::COLOR_ATTRIBUTE, COLOR);
 	Shaders->addUniform("Matrix");
 	Shaders->addUniform("dynamicColor");
+	Shaders->addUniform("BakedPiece");
+	Shaders->addUniformBlock("BakedMatrices", BAKED_BINDING);
 
 	Shaders->create();
 
 	MatrixId = Shaders->Uniforms["Matrix"].index;
 	UniformColorId = Shaders->Uniforms["dynamicColor"].index;
+	BakedPieceId = Shaders->Uniforms["BakedPiece"].index;
 }
 
 //////////////////////////////////////////////////////////////////// VAOs & VBOs
@@ -119,7 +237,15 @@ void MyApp::createBufferObjects() {
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	glDeleteBuffers(2, VboId);
+	/* Kept until destroyBufferObjects: the command list, the multi-view
+	   renderer and binary scenes bind these same buffers in their own VAOs. */
+
+	/* The baked layout never changes: one upload for the life of the app. */
+	glGenBuffers(1, &BakedUbo);
+	glBindBuffer(GL_UNIFORM_BUFFER, BakedUbo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(BakedTangram), BakedTangram.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, BAKED_BINDING, BakedUbo);
 }
 
 void MyApp::destroyBufferObjects() {
@@ -128,39 +254,455 @@ void MyApp::destroyBufferObjects() {
 	glDisableVertexAttribArray(COLOR);
 	glDeleteVertexArrays(1, &VaoId);
 	glBindVertexArray(0);
+	glDeleteBuffers(2, VboId);
+	glBindBufferBase(GL_UNIFORM_BUFFER, BAKED_BINDING, 0);
+	glDeleteBuffers(1, &BakedUbo);
+	BakedUbo = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////// SCENE
 
-const glm::mat4 I(1.0f);
-const glm::mat4 M =
-glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, -1.0f, 0.0f));
+void MyApp::createScene() {
+	Renderers[static_cast<int>(ShapeType::Triangle)] = std::make_unique<TriangleRenderer>(MatrixId, UniformColorId);
+	Renderers[static_cast<int>(ShapeType::Square)] = std::make_unique<SquareRenderer>(MatrixId, UniformColorId);
+	Renderers[static_cast<int>(ShapeType::Parallelogram)] = std::make_unique<ParellelogramRenderer>(MatrixId, UniformColorId);
+	for (auto& renderer : Renderers) renderer->setBakedId(BakedPieceId);
+
+	if (Settings.Pieces) {
+		Shapes = randomTangram(Settings.Pieces, 2.0f, 2526u);
+	} else if (isBinaryScene(Settings.Scene)) {
+		/* Drawn from the mapped arrays; the CPU keeps no copy of the pieces. */
+		const SceneFile file(Settings.Scene);
+		Mapped.create(file.view(), VboId[0], VboId[1]);
+		std::cout << "[scene] " << Mapped.size() << " pieces uploaded from the mapping in "
+			<< Mapped.uploadMs() << " ms" << std::endl;
+		Shapes.clear();
+	} else if (!Settings.Scene.empty()) {
+		/* A scene asked for by name must load; loadScene throws otherwise. */
+		Shapes = loadScene(Settings.Scene);
+	} else if (std::ifstream("tangram.txt").good()) {
+		Shapes = loadScene("tangram.txt");
+	} else {
+		std::cout << "[scene] tangram.txt not found, using the built-in figure" << std::endl;
+		Shapes = defaultTangram();
+	}
+	/* The built-in figure never changes until it is animated: draw it with the
+	   matrices baked at compile time instead of building them every frame. */
+	const bool isStatic = !Settings.Pieces && matchesLayout(Shapes, TangramLayout, TangramPieces);
+	std::vector<uint32_t> order;
+	FirstBlended = orderForSubmission(Shapes, &order);
+	Baked = isStatic ? BakedTangram.data() : nullptr;
+	Authored = order;
+	BoundsDirty = true;
+	Commands.invalidate();
+	LowestLayer = MaxLayers;
+	for (const ShapeInstance& shape : Shapes) LowestLayer = std::min(LowestLayer, shape.layer);
+	createMorph(order);
+}
+
+void MyApp::createMorph(const std::vector<uint32_t>& order) {
+	std::vector<ShapeInstance> target;
+	if (Settings.Pieces) {
+		target = randomTangram(Settings.Pieces, 2.0f, 2527u);
+	} else if (!Settings.Morph.empty()) {
+		target = loadScene(Settings.Morph);
+	} else if (std::ifstream("tangram-exploded.txt").good()) {
+		target = loadScene("tangram-exploded.txt");
+	}
+	if (target.size() != Shapes.size()) return;
+
+	/* Tracks follow the submission order of the scene, piece for piece. */
+	permute(target, order);
+	Morph.clear();
+	Morph.addPose(0.0f, Shapes);
+	Morph.addPose(2.0f, target, Easing::EaseInOut);
+	Morph.addPose(4.0f, Shapes, Easing::EaseInOut);
+
+	AllPieces.resize(Shapes.size());
+	for (uint32_t i = 0; i < AllPieces.size(); i++) AllPieces[i] = i;
+
+	LowestMoving = MaxLayers;
+	for (size_t i = 0; i < Shapes.size(); i++) {
+		if (Morph.moves(i)) LowestMoving = std::min(LowestMoving, Shapes[i].layer);
+	}
+}
+
+void MyApp::animate(double elapsed) {
+	if (!Animating || Morph.keys() == 0) return;
+	AnimationTime += static_cast<float>(elapsed);
+	Morph.evaluate(AnimationTime, Shapes);
+	Commands.invalidate();
+	/* Every piece moved: refit the index instead of rebuilding it. */
+	std::swap(Bounds, LastBounds);
+	computeBounds(Shapes, Bounds);
+	damageMoved();
+	SceneIndex.update(Bounds, AllPieces);
+}
+
+/* Bounds and index of the shapes as they are now, rebuilt if they changed. */
+void MyApp::refreshBounds() {
+	if (!BoundsDirty) return;
+	computeBounds(Shapes, Bounds);
+	SceneIndex.build(Bounds);
+	BoundsDirty = false;
+}
+
+void MyApp::cullScene(const ClipRect& rect) {
+	refreshBounds();
+	LastCull = cullBounds(Bounds, rect, Visible);
+}
+
+/////////////////////////////////////////////////////////////////////// DAMAGE
+
+void MyApp::damageShape(uint32_t i, const BoundsSoA& bounds) {
+	mgl::Engine::getInstance().getDamage().addClip(
+		glm::vec2(bounds.MinX[i], bounds.MinY[i]), glm::vec2(bounds.MaxX[i], bounds.MaxY[i]));
+}
+
+/* Old and new bounds of every piece the last animation step moved. */
+void MyApp::damageMoved() {
+	if (LastBounds.size() != Bounds.size()) {
+		mgl::Engine::getInstance().getDamage().addAll();
+		return;
+	}
+	for (uint32_t i = 0; i < Bounds.size(); i++) {
+		if (LastBounds.MinX[i] == Bounds.MinX[i] && LastBounds.MinY[i] == Bounds.MinY[i] &&
+			LastBounds.MaxX[i] == Bounds.MaxX[i] && LastBounds.MaxY[i] == Bounds.MaxY[i]) continue;
+		damageShape(i, LastBounds);
+		damageShape(i, Bounds);
+	}
+}
+
+void MyApp::select(int32_t picked) {
+	if (picked == Selected) return;
+	/* Damage where the pieces are now, not where the last cull saw them. */
+	refreshBounds();
+	for (int32_t i : { Selected, picked }) {
+		if (i < 0) continue;
+		damageShape(static_cast<uint32_t>(i), Bounds);
+		if (Shapes[i].layer < Layers.cut()) Layers.invalidate();
+	}
+	Commands.invalidate();
+	Selected = picked;
+	mgl::Engine::getInstance().requestRedraw();
+}
+
+void MyApp::drawShapes(std::vector<uint32_t>::const_iterator first, std::vector<uint32_t>::const_iterator last) {
+	if (MultiView.views() > 1) {
+		int width, height;
+		mgl::Engine::getInstance().getRenderSize(width, height);
+		MultiView.draw(Shapes, first, last, Selected, width, height);
+		return;
+	}
+	if (Path == TransformPath::Affine) {
+		Affine.draw(Shapes, first, last, Selected);
+		return;
+	}
+	if (Path == TransformPath::Parameters) {
+		Parameters.draw(Shapes, first, last, Selected);
+		return;
+	}
+	for (auto it = first; it != last; ++it) {
+		const ShapeInstance& shape = Shapes[*it];
+		const glm::vec4 color = static_cast<int32_t>(*it) == Selected ? Color::White : shape.color;
+		if (Baked) Renderers[static_cast<int>(shape.type)]->drawBaked(Authored[*it], Baked[Authored[*it]].m, color);
+		else Renderers[static_cast<int>(shape.type)]->draw(shape.scale, shape.rotation, shape.translate, color);
+	}
+	if (Baked) glUniform1i(BakedPieceId, 0);
+}
+
+void MyApp::drawSorted(const std::vector<uint32_t>& list) {
+	/* Shapes are stored in submission order, so the list is too. */
+	const auto firstBlended = std::lower_bound(list.cbegin(), list.cend(), static_cast<uint32_t>(FirstBlended));
+	drawShapes(list.cbegin(), firstBlended);
+	if (firstBlended != list.cend()) {
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+		drawShapes(firstBlended, list.cend());
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////// LAYERS
+
+bool MyApp::cachedLayers() const {
+	return Layers.enabled() && Layers.cut() > LowestLayer;
+}
+
+/* At rest every layer is static; while the morph plays, the layers from the
+   lowest one it moves upwards are drawn live. */
+void MyApp::updateLayers() {
+	int width, height;
+	mgl::Engine::getInstance().getRenderSize(width, height);
+	Layers.resize(width, height);
+	const int cut = Animating ? LowestMoving : MaxLayers;
+	if (cut != Layers.cut()) Commands.invalidate();
+	Layers.setCut(cut);
+	if (!cachedLayers() || Layers.valid()) return;
+
+	cullScene();
+	Static.clear();
+	for (uint32_t i : Visible) {
+		if (Shapes[i].layer < Layers.cut()) Static.push_back(i);
+	}
+	Layers.begin();
+	drawSorted(Static);
+	Layers.end();
+	renderViewport();
+	/* What the cache composites may differ anywhere. */
+	mgl::Engine::getInstance().getDamage().addAll();
+}
+
+/* The visible shapes that are not in the layer cache. */
+const std::vector<uint32_t>& MyApp::liveShapes() {
+	if (!cachedLayers()) return Visible;
+	Live.clear();
+	for (uint32_t i : Visible) {
+		if (Shapes[i].layer >= Layers.cut()) Live.push_back(i);
+	}
+	return Live;
+}
+
+//////////////////////////////////////////////////////////////////// COMMANDS
+
+/* Records the whole screen's live shapes once; damaged rectangles replay all
+   of it and the scissor discards the rest. */
+void MyApp::recordCommands() {
+	cullScene();
+	const std::vector<uint32_t>& list = liveShapes();
+	const auto firstBlended = std::lower_bound(list.cbegin(), list.cend(), static_cast<uint32_t>(FirstBlended));
+	for (auto& renderer : Renderers) renderer->setRecorder(&Commands);
+	Commands.begin();
+	drawShapes(list.cbegin(), firstBlended);
+	Commands.beginBlended();
+	drawShapes(firstBlended, list.cend());
+	Commands.end();
+	for (auto& renderer : Renderers) renderer->setRecorder(nullptr);
+}
 
 void MyApp::drawScene() {
-	ShapeRenderer* triangleRenderer = new TriangleRenderer(MatrixId, UniformColorId);
-	ShapeRenderer* squareRenderer = new SquareRenderer(MatrixId, UniformColorId);
-	ShapeRenderer* parallelogramRenderer = new ParellelogramRenderer(MatrixId, UniformColorId);
+	mgl::Engine& engine = mgl::Engine::getInstance();
+	mgl::DamageRegion& damage = engine.getDamage();
 
 	glBindVertexArray(VaoId);
 	Shaders->bind();
 
+	const auto start = std::chrono::high_resolution_clock::now();
+	DrawTimer.begin();
+	updateLayers();
+	/* A mapped scene has no ShapeInstances: it bypasses everything below. */
+	const bool mapped = Mapped.size() > 0;
+	/* Damage, the layer cache and recorded commands all assume one view. */
+	const bool views = !mapped && MultiView.views() > 1;
+	if (views) damage.addAll();
+	damage.merge();
+	const bool cached = !mapped && !views && cachedLayers();
+	/* Nothing moves and the matrix path goes through the renderers: replay. */
+	const bool retained = !mapped && !views && Replay != ReplayMode::Immediate && Path == TransformPath::Matrix && !Animating;
+	if (retained && !Commands.valid()) recordCommands();
+	/* Overdraw is only meaningful over the whole screen. */
+	const bool measure = !mapped && !views && MeasureOverdraw && Overdraw.idle() && damage.full();
+	bool counting = false;
+	/* Each damaged rectangle is cleared and redrawn on its own, with only the
+	   shapes that touch it. Without partial redraw the engine has cleared the
+	   frame and the only rectangle is the whole screen. */
+	CullStats cull;
+	glEnable(GL_SCISSOR_TEST);
+	for (const glm::ivec4& r : damage.rects()) {
+		glScissor(r.x, r.y, r.z, r.w);
+		if (engine.getPartialRedraw()) glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		if (cached) {
+			/* Static layers come from the cache; only the dynamic ones are drawn. */
+			Layers.composite();
+			glBindVertexArray(VaoId);
+			Shaders->bind();
+		}
+		/* The composite shades every pixel and is not overdraw of the pieces
+		   the counting redraws see, so the query starts after it. */
+		if (measure && !counting) {
+			Overdraw.begin(OverdrawCounter::Shaded);
+			counting = true;
+		}
+		if (mapped) {
+			Mapped.draw();
+			glBindVertexArray(VaoId);
+			Shaders->bind();
+			continue;
+		}
+		if (retained) {
+			Commands.replay(Replay);
+			glBindVertexArray(VaoId);
+			Shaders->bind();
+			continue;
+		}
+		ClipRect rect;
+		if (views) {
+			rect = MultiView.sceneBounds();
+		} else {
+			glm::vec2 min, max;
+			damage.clipBounds(r, min, max);
+			rect.MinX = min.x; rect.MinY = min.y;
+			rect.MaxX = max.x; rect.MaxY = max.y;
+		}
+		cullScene(rect);
+		cull.Visible += LastCull.Visible;
+		cull.Culled += LastCull.Culled;
+		cull.Milliseconds += LastCull.Milliseconds;
+		drawSorted(liveShapes());
+	}
+	glDisable(GL_SCISSOR_TEST);
+	if (views) renderViewport();
+	if (!damage.empty() && !retained) LastCull = cull;
+	DrawTimer.end();
+	DrawCpu += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	CpuFrames++;
+	if (counting) {
+		Overdraw.end();
+		const std::vector<uint32_t>& drawn = cached ? Live : Visible;
+		const auto firstBlended = std::lower_bound(drawn.cbegin(), drawn.cend(), static_cast<uint32_t>(FirstBlended));
+		for (OverdrawCounter::Query query : { OverdrawCounter::Covered, OverdrawCounter::Rasterized }) {
+			Overdraw.beginCounting(query);
+			if (retained) Commands.replay(Replay, false);
+			else drawShapes(drawn.cbegin(), firstBlended);
+			Overdraw.endCounting();
+		}
+		glBindVertexArray(VaoId);
+		Shaders->bind();
+		MeasureOverdraw = false;
+		OverdrawLive = cached;
+	}
 
-	squareRenderer->draw(glm::vec2(0.25f, 0.25f), glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 0.0f), Color::Green);
-	
-	parallelogramRenderer->draw(glm::vec2(0.25f, 0.25f), glm::radians(0.0f), glm::vec3(0.25f, 0.f, 0.0f), Color::Yellow);
+	Shaders->unbind();
+	glBindVertexArray(0);
 
-	triangleRenderer->draw(glm::vec2(0.25f, 0.25f), glm::radians(90.0f), glm::vec3(0.75f, 0.4f, 0.0f), Color::Purple);
+	Overdraw.poll(LastOverdraw);
+	double gpu;
+	while (DrawTimer.poll(gpu)) {
+		DrawGpu += gpu;
+		GpuFrames++;
+		if (Settings.TargetMs > 0.0 && Scaler.update(gpu)) {
+			mgl::Engine::getInstance().setRenderScale(Scaler.scale());
+		}
+	}
+	pickPass();
+}
 
-	triangleRenderer->draw(glm::vec2(0.5f, 0.5f), glm::radians(270.0f), glm::vec3(-0.5f, 0.25f, 0.0f), Color::Magenta);
+/* The frame's render target, which may be smaller than the window. */
+void MyApp::renderViewport() const {
+	int width, height;
+	mgl::Engine::getInstance().getRenderSize(width, height);
+	glViewport(0, 0, width, height);
+}
 
-	triangleRenderer->draw(glm::vec2(0.25f, 0.25f), glm::radians(180.0f), glm::vec3(0.0f, 0.5f, 0.0f), Color::Cyan);
+void MyApp::reportStats(double elapsed) {
+	StatsTimer += elapsed;
+	if (StatsTimer < 1.0) return;
+	StatsTimer = 0.0;
+	std::cout << "[cull] visible " << LastCull.Visible
+		<< " culled " << LastCull.Culled
+		<< " time " << LastCull.Milliseconds << " ms" << std::endl;
+	/* With a layer cache only the live shapes are drawn and counted; the
+	   composite of the cached layers is kept out of the Shaded query. */
+	if (OverdrawLive && !LastOverdraw.Covered) {
+		std::cout << "[overdraw] nothing live: every shape is in the layer cache" << std::endl;
+	} else {
+		std::cout << "[overdraw] shaded " << LastOverdraw.Shaded
+			<< " covered " << LastOverdraw.Covered
+			<< " overdraw " << LastOverdraw.overdraw() << "x"
+			<< " (unsorted " << LastOverdraw.unsorted() << "x)";
+		if (OverdrawLive) std::cout << " over the live shapes only";
+		std::cout << std::endl;
+	}
+	/* CPU is submission including instance building; GPU is the pass itself. */
+	std::cout << "[transform] path " << transformPathName(Path)
+		<< " cpu " << (CpuFrames ? DrawCpu / CpuFrames : 0.0) << " ms"
+		<< " gpu " << (GpuFrames ? DrawGpu / GpuFrames : 0.0) << " ms per frame" << std::endl;
+	const mgl::DamageStats damage = mgl::Engine::getInstance().getDamage().collect();
+	if (damage.Frames) {
+		std::cout << "[damage] rects " << static_cast<double>(damage.Rects) / damage.Frames
+			<< " redrawn " << 100.0 * damage.redrawn() << "% of the screen, fill saved "
+			<< 100.0 * (1.0 - damage.redrawn()) << "% per frame" << std::endl;
+	}
+	std::cout << "[layers] ";
+	if (!cachedLayers()) std::cout << "none cached";
+	else if (Layers.cut() == MaxLayers) std::cout << "all cached";
+	else std::cout << "cached below layer " << Layers.cut() << ", " << Live.size() << " live shapes";
+	std::cout << ", " << Layers.rebuilds() << " rebuilds" << std::endl;
+	if (Settings.TargetMs > 0.0) {
+		int width, height;
+		mgl::Engine::getInstance().getRenderSize(width, height);
+		std::cout << "[resolution] scale " << Scaler.scale() << " (" << width << "x" << height << ")"
+			<< " gpu " << Scaler.average() << " ms against " << Settings.TargetMs << " ms" << std::endl;
+	}
+	std::cout << "[commands] replay " << replayModeName(Replay) << ", " << Commands.size()
+		<< " draws recorded, " << Commands.recordings() << " recordings" << std::endl;
+	if (Capture.active()) {
+		const CaptureStats capture = Capture.stats();
+		const double frames = capture.Captured ? static_cast<double>(capture.Captured) : 1.0;
+		const double scene = CpuFrames ? DrawCpu / CpuFrames : 0.0;
+		std::cout << "[capture] " << captureFormatName(Capture.format()) << " " << capture.Written << " written"
+			<< ", render thread " << capture.RenderMs / frames << " ms per frame";
+		if (scene > 0.0) std::cout << " (" << 100.0 * capture.RenderMs / frames / scene << "% of the scene pass)";
+		std::cout << ", stalled " << capture.StallMs << " ms"
+			<< ", writers " << capture.WriteMs / frames << " ms per frame" << std::endl;
+	}
+	const mgl::RenderTargetPool& targets = mgl::Engine::getInstance().getTargets();
+	std::cout << "[targets] " << targets.getCount() << " held, "
+		<< targets.getBytes() / 1024 << " KB (" << targets.getUsedBytes() / 1024 << " KB in use)" << std::endl;
+	DrawCpu = DrawGpu = 0.0;
+	CpuFrames = GpuFrames = 0;
+	MeasureOverdraw = true;
+}
 
-	triangleRenderer->draw(glm::vec2(0.5f, 0.5f), glm::radians(315.0f), glm::vec3((-sqrt(0.5f) - 0.25f), 0.0f, 0.0f), Color::Blue);
+//////////////////////////////////////////////////////////////////////// PICKING
 
-	triangleRenderer->draw(glm::vec2(0.25f, 0.25f), glm::radians(135.0f), glm::vec3(-0.25, 0.0f, 0.0f), Color::Orange);
+glm::vec2 MyApp::windowToClip(glm::dvec2 window) const {
+	return glm::vec2(2.0 * window.x / Width - 1.0, 1.0 - 2.0 * window.y / Height);
+}
 
-	Shaders->unbind();
-	glBindVertexArray(0);
+void MyApp::pick() {
+	if (Picking == PickMode::Gpu) {
+		/* Sized here rather than on every resize event. */
+		int width, height;
+		glfwGetFramebufferSize(Window, &width, &height);
+		Picker.resize(width, height);
+		/* The cursor is in window coordinates, the ID buffer in pixels. */
+		const double sx = static_cast<double>(width) / Width, sy = static_cast<double>(height) / Height;
+		Picker.request(static_cast<int>(Cursor.x * sx), height - 1 - static_cast<int>(Cursor.y * sy));
+		return;
+	}
+	cullScene();
+	const auto start = std::chrono::high_resolution_clock::now();
+	select(pickCpu(SceneIndex, Shapes, windowToClip(Cursor)));
+	const double ms = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+	std::cout << "[pick] cpu " << Selected << " latency " << ms << " ms" << std::endl;
+}
+
+void MyApp::pickPass() {
+	if (Picker.pending()) {
+		/* Only shapes touching the read back pixels can land in the ID buffer. */
+		const glm::ivec4 r = Picker.region();
+		const Aabb2 region = {
+			glm::vec2(2.0f * r.x / Picker.width() - 1.0f, 2.0f * r.y / Picker.height() - 1.0f),
+			glm::vec2(2.0f * (r.x + r.z) / Picker.width() - 1.0f, 2.0f * (r.y + r.w) / Picker.height() - 1.0f) };
+		std::vector<uint32_t> candidates;
+		SceneIndex.queryRange(region, candidates);
+		std::sort(candidates.begin(), candidates.end());
+		Picker.render(VaoId, Shapes, candidates);
+		renderViewport();
+	}
+
+	int32_t picked;
+	double ms;
+	int frames;
+	if (Picker.poll(picked, ms, frames)) {
+		select(picked);
+		std::cout << "[pick] gpu " << Selected << " latency " << ms << " ms ("
+			<< frames << " frames)" << std::endl;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////// CALLBACKS
@@ -168,23 +710,139 @@ void MyApp::drawScene() {
 void MyApp::initCallback(GLFWwindow* win) {
 	createBufferObjects();
 	createShaderProgram();
+	Affine.create(VaoId);
+	Parameters.create(VaoId);
+	DrawTimer.create();
+	createScene();
+	Window = win;
+	Width = mgl::Engine::getInstance().WindowWidth;
+	Height = mgl::Engine::getInstance().WindowHeight;
+	int width, height;
+	glfwGetFramebufferSize(win, &width, &height);
+	Picker.create(width, height);
+	Layers.create(width, height);
+	Scaler.TargetMs = Settings.TargetMs;
+	Layers.setEnabled(Settings.Layers);
+	Commands.create(VboId[0], Indices, sizeof(Indices));
+	Replay = Settings.Replay;
+	Overdraw.create();
+	MultiView.create(VboId[0], VboId[1]);
+	MultiView.setViews(Settings.Views);
+	if (!Settings.Capture.empty()) Capture.start(Settings.Capture, Settings.CaptureFps);
 }
 
-void MyApp::windowCloseCallback(GLFWwindow* win) { destroyBufferObjects(); }
+void MyApp::windowCloseCallback(GLFWwindow* win) {
+	Capture.stop();
+	Picker.destroy();
+	destroyBufferObjects();
+}
 
 void MyApp::windowSizeCallback(GLFWwindow* win, int winx, int winy) {
+	/* The final output only: frames render at Engine::getRenderSize. */
 	glViewport(0, 0, winx, winy);
+	Width = winx;
+	Height = winy;
 }
 
-void MyApp::displayCallback(GLFWwindow* win, double elapsed) { drawScene(); }
+/* Only read when a click picks, so moving the mouse redraws nothing. */
+void MyApp::cursorCallback(GLFWwindow* win, double xpos, double ypos) {
+	Cursor = glm::dvec2(xpos, ypos);
+}
+
+void MyApp::mouseButtonCallback(GLFWwindow* win, int button, int action, int mods) {
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) pick();
+}
+
+void MyApp::keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods) {
+	if (action != GLFW_PRESS) return;
+	if (key == GLFW_KEY_P) {
+		Picking = Picking == PickMode::Cpu ? PickMode::Gpu : PickMode::Cpu;
+		std::cout << "[pick] mode " << (Picking == PickMode::Cpu ? "cpu" : "gpu") << std::endl;
+	}
+	if (key == GLFW_KEY_T) {
+		Path = static_cast<TransformPath>((static_cast<int>(Path) + 1) % static_cast<int>(TransformPath::Count));
+		std::cout << "[transform] path " << transformPathName(Path) << std::endl;
+	}
+	if (key == GLFW_KEY_L) {
+		mgl::Engine& engine = mgl::Engine::getInstance();
+		engine.setLowLatency(!engine.getLowLatency());
+		std::cout << "[engine] low latency " << (engine.getLowLatency() ? "on" : "off") << std::endl;
+	}
+	if (key == GLFW_KEY_V) {
+		/* 1, 2, 4, 9, 16 views. */
+		static const int Steps[] = { 1, 2, 4, 9, 16 };
+		const int* next = std::upper_bound(std::begin(Steps), std::end(Steps), MultiView.views());
+		MultiView.setViews(next == std::end(Steps) ? 1 : *next);
+		std::cout << "[views] " << MultiView.views() << (MultiView.singlePass() ? " in one pass" : " one pass each") << std::endl;
+		mgl::Engine::getInstance().requestRedraw();
+	}
+	if (key == GLFW_KEY_C) {
+		if (Capture.active()) Capture.stop();
+		else Capture.start(Settings.Capture.empty() ? "capture.y4m" : Settings.Capture, Settings.CaptureFps);
+	}
+	if (key == GLFW_KEY_R) {
+		Replay = static_cast<ReplayMode>((static_cast<int>(Replay) + 1) % static_cast<int>(ReplayMode::Count));
+		std::cout << "[commands] replay " << replayModeName(Replay) << std::endl;
+	}
+	if (key == GLFW_KEY_A && Morph.keys()) {
+		Animating = !Animating;
+		Baked = nullptr;	// the pieces leave the static layout
+		/* Refits degrade the tree; rebuild it once the pieces come to rest. */
+		if (!Animating) BoundsDirty = true;
+	}
+}
+
+void MyApp::displayCallback(GLFWwindow* win, double elapsed) {
+	animate(elapsed);
+	drawScene();
+	if (Capture.active()) {
+		/* The frame as rendered, before any upscale to the window. */
+		int width, height;
+		mgl::Engine::getInstance().getRenderSize(width, height);
+		Capture.capture(width, height);
+	}
+	reportStats(elapsed);
+	/* Input already wakes the engine; keep frames coming while the scene moves
+	   or a GPU pick waits on its readback. */
+	if (Animating || Picker.inFlight()) mgl::Engine::getInstance().requestRedraw();
+}
 
 /////////////////////////////////////////////////////////////////////////// MAIN
 
 int main(int argc, char* argv[]) {
+	if (argc > 2 && std::string(argv[1]) == "--bench") {
+		return runBenchmark(argv[2], argc, argv);
+	}
+
+	Options options;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const std::string option = argv[i];
+		if (option == "--pieces") options.Pieces = static_cast<size_t>(std::strtoull(argv[i + 1], nullptr, 10));
+		else if (option == "--scene") options.Scene = argv[i + 1];
+		else if (option == "--morph") options.Morph = argv[i + 1];
+		else if (option == "--target-ms") options.TargetMs = std::atof(argv[i + 1]);
+		else if (option == "--capture") options.Capture = argv[i + 1];
+		else if (option == "--capture-fps") options.CaptureFps = std::atoi(argv[i + 1]);
+		else if (option == "--views") options.Views = std::atoi(argv[i + 1]);
+		else if (option == "--frames") options.FramesInFlight = std::atoi(argv[i + 1]);
+		else if (option == "--low-latency") options.LowLatency = std::string(argv[i + 1]) != "off";
+		else if (option == "--replay") {
+			const std::string mode = argv[i + 1];
+			options.Replay = mode == "immediate" ? ReplayMode::Immediate : mode == "loop" ? ReplayMode::Loop : ReplayMode::Indirect;
+		}
+		else if (option == "--layers") options.Layers = std::string(argv[i + 1]) != "off";
+		else if (option == "--damage") options.Damage = std::string(argv[i + 1]) != "off";
+		else if (option == "--render") options.Render = std::string(argv[i + 1]) == "continuous" ? mgl::RenderMode::Continuous : mgl::RenderMode::OnDemand;
+	}
+
 	mgl::Engine& engine = mgl::Engine::getInstance();
-	engine.setApp(new MyApp());
+	engine.setApp(new MyApp(options));
 	engine.setOpenGL(4, 6);
 	engine.setWindow(600, 600, "Hello Modern 2D World", 0, 1);
+	engine.setRenderMode(options.Render);
+	engine.setPartialRedraw(options.Damage);
+	engine.setFramesInFlight(options.FramesInFlight);
+	engine.setLowLatency(options.LowLatency);
 	engine.init();
 	engine.run();
 	exit(EXIT_SUCCESS);
@@ -0,0 +1,32 @@
+#version 410 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 5) in vec3 inScaleRotation;	// scale x, scale y, rotation in radians
+layout(location = 6) in vec3 inTranslate;		// translation, then depth
+layout(location = 7) in vec4 inInstanceColor;
+
+uniform vec2 Tilt;		// cos and sin of the figure's tilt (R2)
+uniform int Views;		// instances per piece, one per view
+uniform int FirstView;	// view of instance 0 when views are drawn one at a time
+uniform vec4 View[16];	// per view: clip-space scale, then offset
+
+out vec4 exColor;
+
+vec2 rotate(vec2 p, float c, float s) {
+    return vec2(c * p.x - s * p.y, s * p.x + c * p.y);
+}
+
+// R2 * T * R * S as in clip-params-vs.glsl, then the view's zoom and pan.
+// Each piece is instanced once per view and the instance picks the viewport.
+void main(void) {
+    int view = FirstView + gl_InstanceID % Views;
+    vec2 p = rotate(inPosition.xy * inScaleRotation.xy, cos(inScaleRotation.z), sin(inScaleRotation.z));
+    p = rotate(p + inTranslate.xy, Tilt.x, Tilt.y);
+    p = p * View[view].xy + View[view].zw;
+    gl_Position = vec4(p, inTranslate.z, 1.0);
+    exColor = inInstanceColor;
+#ifdef GL_ARB_shader_viewport_layer_array
+    gl_ViewportIndex = view;
+#endif
+}
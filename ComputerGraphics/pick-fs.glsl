@@ -0,0 +1,8 @@
+#version 330 core
+
+uniform uint ObjectId;
+out uint outId;
+
+void main(void) {
+    outId = ObjectId;
+}
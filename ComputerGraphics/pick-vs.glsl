@@ -0,0 +1,9 @@
+#version 330 core
+
+layout(location = 0) in vec4 inPosition;
+
+uniform mat4 Matrix;
+
+void main(void) {
+    gl_Position = Matrix * inPosition;
+}
@@ -14,7 +14,10 @@
 
 #include "./mglApp.hpp"         // IWYU pragma: keep
 #include "./mglConventions.hpp" // IWYU pragma: keep
+#include "./mglDamage.hpp"      // IWYU pragma: keep
 #include "./mglError.hpp"       // IWYU pragma: keep
+#include "./mglRenderTarget.hpp" // IWYU pragma: keep
 #include "./mglShader.hpp"      // IWYU pragma: keep
+#include "./mglStreamBuffer.hpp" // IWYU pragma: keep
 
 #endif /* MGL_HPP */
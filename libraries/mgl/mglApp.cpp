@@ -9,23 +9,39 @@
 #include "./mglApp.hpp"
 
 #include <GLFW/glfw3.h>
+#include <ctime>
 #include <iostream>
 #include <stdexcept>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
 #include "./mglError.hpp" // IWYU pragma: keep -- required in debug mode
 
 namespace mgl {
 
 /////////////////////////////////////////////////////////////// STATIC CALLBACKS
 
+// Anything reaching the App may change what is on screen, except cursor
+// motion: it arrives for every pixel the mouse crosses, so an App whose image
+// follows the cursor calls requestRedraw() from its cursorCallback.
+
 static void window_close_callback(GLFWwindow *window) {
   Engine::getInstance().getApp()->windowCloseCallback(window);
 }
 
 static void window_size_callback(GLFWwindow *window, int width, int height) {
+  Engine::getInstance().requestRedraw();
   Engine::getInstance().getApp()->windowSizeCallback(window, width, height);
 }
 
+static void window_refresh_callback(GLFWwindow *window) {
+  Engine::getInstance().requestRedraw();
+}
+
 static void glfw_error_callback(int error, const char *description) {
   std::cerr << "GLFW Error: " << description << std::endl;
 }
@@ -36,22 +52,26 @@ static void cursor_pos_callback(GLFWwindow *window, double xpos, double ypos) {
 
 static void key_callback(GLFWwindow *window, int key, int scancode, int action,
                          int mods) {
+  Engine::getInstance().requestRedraw();
   Engine::getInstance().getApp()->keyCallback(window, key, scancode, action,
                                               mods);
 }
 
 static void mouse_button_callback(GLFWwindow *window, int button, int action,
                                   int mods) {
+  Engine::getInstance().requestRedraw();
   Engine::getInstance().getApp()->mouseButtonCallback(window, button, action,
                                                       mods);
 }
 
 static void scroll_callback(GLFWwindow *window, double xoffset,
                             double yoffset) {
+  Engine::getInstance().requestRedraw();
   Engine::getInstance().getApp()->scrollCallback(window, xoffset, yoffset);
 }
 
 static void joystick_callback(int jid, int event) {
+  Engine::getInstance().requestRedraw();
   Engine::getInstance().getApp()->joystickCallback(jid, event);
 }
 
@@ -60,7 +80,12 @@ static void joystick_callback(int jid, int event) {
 Engine::Engine(void)
     : WindowWidth(640), WindowHeight(480), GlApp(nullptr), Window(nullptr),
       WindowTitle("OpenGL App GLFW Window 2025(c) Carlos Martinho"), GlMajor(3),
-      GlMinor(3), Fullscreen(0), Vsync(0) {}
+      GlMinor(3), Fullscreen(0), Vsync(0), Mode(RenderMode::Continuous),
+      IdleTimeout(0.0), Dirty(true), PartialRedraw(false), Canvas(nullptr),
+      RenderScale(1.0f), RenderWidth(0), RenderHeight(0), OutputWidth(0),
+      OutputHeight(0), SettledWidth(0), SettledHeight(0), SeenWidth(0),
+      SeenHeight(0), ResizeTime(0.0), ResizeDelay(0.15), FramesInFlight(2),
+      LowLatency(false), FrameNumber(0), Fences() {}
 
 Engine::~Engine(void) {}
 
@@ -87,6 +112,74 @@ void Engine::setWindow(int width, int height, const char *title, int fullscreen,
   Vsync = vsync;
 }
 
+void Engine::setRenderMode(RenderMode mode) {
+  Mode = mode;
+  requestRedraw();
+}
+
+RenderMode Engine::getRenderMode() const { return Mode; }
+
+void Engine::setIdleTimeout(double seconds) { IdleTimeout = seconds; }
+
+void Engine::requestRedraw() {
+  if (!Dirty.exchange(true) && Window) {
+    glfwPostEmptyEvent();
+  }
+}
+
+const RunStats &Engine::getRunStats() const { return Stats; }
+
+void Engine::setPartialRedraw(bool enabled) {
+  PartialRedraw = enabled;
+  Damage.addAll();
+  requestRedraw();
+}
+
+bool Engine::getPartialRedraw() const { return PartialRedraw; }
+
+DamageRegion &Engine::getDamage() { return Damage; }
+
+void Engine::setRenderScale(float scale) {
+  RenderScale = scale < MinRenderScale ? MinRenderScale
+                : scale > 1.0f         ? 1.0f
+                                       : scale;
+  requestRedraw();
+}
+
+float Engine::getRenderScale() const { return RenderScale; }
+
+void Engine::getRenderSize(int &width, int &height) const {
+  width = RenderWidth;
+  height = RenderHeight;
+}
+
+void Engine::setFramesInFlight(int frames) {
+  // Slots are about to be renumbered: let every queued frame finish first.
+  for (int slot = 0; slot < MaxFramesInFlight; slot++)
+    waitForFrame(slot);
+  FramesInFlight = frames < 1 ? 1
+                   : frames > MaxFramesInFlight ? MaxFramesInFlight
+                                                : frames;
+}
+
+int Engine::getFramesInFlight() const { return FramesInFlight; }
+
+int Engine::getFrameIndex() const {
+  return static_cast<int>(FrameNumber % FramesInFlight);
+}
+
+unsigned long long Engine::getFrameNumber() const { return FrameNumber; }
+
+void Engine::setLowLatency(bool enabled) { LowLatency = enabled; }
+
+bool Engine::getLowLatency() const { return LowLatency; }
+
+RenderTargetPool &Engine::getTargets() { return Targets; }
+
+void Engine::setResizeDelay(double seconds) { ResizeDelay = seconds; }
+
+double Engine::getResizeDelay() const { return ResizeDelay; }
+
 /////////////////////////////////////////////////////////////////////////// INIT
 
 void Engine::setupWindow() {
@@ -108,6 +201,7 @@ void Engine::setupCallbacks() {
   glfwSetJoystickCallback(joystick_callback);
   glfwSetWindowCloseCallback(Window, window_close_callback);
   glfwSetWindowSizeCallback(Window, window_size_callback);
+  glfwSetWindowRefreshCallback(Window, window_refresh_callback);
 }
 
 void Engine::setupGLFW() {
@@ -172,25 +266,184 @@ void Engine::init() {
 #endif
 }
 
+///////////////////////////////////////////////////////////////////////// CANVAS
+
+// EGL can be asked to preserve the back buffer across swaps, but GLFW exposes
+// no such hint, so the preserved copy of the frame lives in a pooled FBO.
+// Presenting it costs one blit, with no shading, depth or blending. The same
+// blit upscales the frame when it is rendered below the window resolution.
+
+// A window being resized reports a new size every frame. The render size
+// waits until it has held still for ResizeDelay; meanwhile the canvas blit
+// stretches the last settled size over the window.
+void Engine::settleSize() {
+  const double now = glfwGetTime();
+  if (OutputWidth != SeenWidth || OutputHeight != SeenHeight) {
+    SeenWidth = OutputWidth;
+    SeenHeight = OutputHeight;
+    ResizeTime = now;
+  }
+  if (SeenWidth == SettledWidth && SeenHeight == SettledHeight)
+    return;
+  if (SettledWidth == 0 || now - ResizeTime >= ResizeDelay) {
+    SettledWidth = SeenWidth;
+    SettledHeight = SeenHeight;
+  } else {
+    requestRedraw(); // no event may come to end the wait
+  }
+}
+
+void Engine::beginFrame() {
+  waitForFrame(getFrameIndex());
+  glfwGetFramebufferSize(Window, &OutputWidth, &OutputHeight);
+  settleSize();
+  RenderWidth = static_cast<int>(SettledWidth * RenderScale + 0.5f);
+  RenderHeight = static_cast<int>(SettledHeight * RenderScale + 0.5f);
+  RenderWidth = RenderWidth < 1 ? 1 : RenderWidth;
+  RenderHeight = RenderHeight < 1 ? 1 : RenderHeight;
+  Damage.resize(RenderWidth, RenderHeight);
+
+  const bool canvas = PartialRedraw || RenderWidth != OutputWidth ||
+                      RenderHeight != OutputHeight;
+  if (!canvas) {
+    Targets.release(Canvas);
+    Canvas = nullptr;
+  } else if (!Canvas || RenderWidth != Canvas->Desc.Width ||
+             RenderHeight != Canvas->Desc.Height) {
+    Targets.release(Canvas);
+    RenderTargetDesc desc;
+    desc.Width = RenderWidth;
+    desc.Height = RenderHeight;
+    Canvas = Targets.acquire(desc);
+    Damage.addAll();
+  }
+  if (Canvas)
+    glBindFramebuffer(GL_FRAMEBUFFER, Canvas->Fbo);
+  glViewport(0, 0, RenderWidth, RenderHeight);
+  if (!PartialRedraw) {
+    Damage.addAll();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+            GL_STENCIL_BUFFER_BIT);
+  }
+}
+
+void Engine::presentFrame() {
+  if (Canvas) {
+    const int width = Canvas->Desc.Width, height = Canvas->Desc.Height;
+    const bool scaled = width != OutputWidth || height != OutputHeight;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, Canvas->Fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, OutputWidth,
+                      OutputHeight, GL_COLOR_BUFFER_BIT,
+                      scaled ? GL_LINEAR : GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+  glViewport(0, 0, OutputWidth, OutputHeight);
+  Damage.present();
+}
+
+///////////////////////////////////////////////////////////////////////// FENCES
+
+void Engine::fenceFrame() {
+  Fences[getFrameIndex()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  FrameNumber++;
+}
+
+void Engine::waitForFrame(int slot) {
+  GLsync &fence = Fences[slot];
+  if (!fence)
+    return;
+  const double start = glfwGetTime();
+  // Flush once, or a fence still in the command queue would never signal.
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  GLenum status;
+  while ((status = glClientWaitSync(fence, flags, 100000000)) ==
+         GL_TIMEOUT_EXPIRED)
+    flags = 0;
+  if (status == GL_WAIT_FAILED)
+    std::cerr << "[engine] frame fence wait failed" << std::endl;
+  glDeleteSync(fence);
+  fence = nullptr;
+  Stats.FenceSeconds += glfwGetTime() - start;
+}
+
 //////////////////////////////////////////////////////////////////////////// RUN
 
+// CPU time of the whole process, as std::clock is wall time under MSVC.
+static double process_cpu_seconds() {
+#ifdef _WIN32
+  FILETIME creation, exited, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel, &user))
+    return 0.0;
+  auto ticks = [](const FILETIME &t) {
+    return (static_cast<unsigned long long>(t.dwHighDateTime) << 32) |
+           t.dwLowDateTime;
+  };
+  return (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+static const char *render_mode_name(RenderMode mode) {
+  return mode == RenderMode::OnDemand ? "on-demand" : "continuous";
+}
+
 void Engine::run() {
-  double last_time = glfwGetTime();
+  Stats = RunStats();
+  const double start_time = glfwGetTime();
+  const double start_cpu = process_cpu_seconds();
+  double last_time = start_time;
   while (!glfwWindowShouldClose(Window)) {
     try {
+      if (Mode == RenderMode::OnDemand && !Dirty.load()) {
+        if (IdleTimeout > 0.0) {
+          glfwWaitEventsTimeout(IdleTimeout);
+        } else {
+          glfwWaitEvents();
+        }
+        Stats.Wakeups++;
+        if (!Dirty.load())
+          continue;
+        // Nothing moved while idle: the first frame after it advances by 0.
+        last_time = glfwGetTime();
+      }
+      Dirty.store(false);
       double time = glfwGetTime();
       double elapsed_time = time - last_time;
       last_time = time;
-      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
-              GL_STENCIL_BUFFER_BIT);
+      beginFrame();
       GlApp->displayCallback(Window, elapsed_time);
+      presentFrame();
       glfwSwapBuffers(Window);
+      const int slot = getFrameIndex();
+      fenceFrame();
+      Targets.endFrame(FrameNumber);
+      Stats.Frames++;
+      if (LowLatency)
+        waitForFrame(slot);
       glfwPollEvents();
     } catch (const std::exception &e) {
       std::cerr << "FRAME EXCEPTION: " << e.what() << std::endl;
       glfwSetWindowShouldClose(Window, GLFW_TRUE);
     }
   }
+  Stats.WallSeconds = glfwGetTime() - start_time;
+  Stats.CpuSeconds = process_cpu_seconds() - start_cpu;
+  std::cout << "[engine] " << render_mode_name(Mode) << ": " << Stats.Frames
+            << " frames, " << Stats.Wakeups << " wakeups in "
+            << Stats.WallSeconds << " s, cpu " << 100.0 * Stats.cpuLoad()
+            << "% of one core, " << 1000.0 * Stats.FenceSeconds
+            << " ms waiting on " << FramesInFlight << " frames in flight"
+            << (LowLatency ? " (low latency)" : "") << std::endl;
+  const RenderTargetStats &targets = Targets.getStats();
+  std::cout << "[engine] render targets: " << targets.Created << " created, "
+            << targets.Reused << " reused, " << targets.Trimmed
+            << " trimmed" << std::endl;
+  for (int slot = 0; slot < MaxFramesInFlight; slot++)
+    waitForFrame(slot);
+  Canvas = nullptr;
+  Targets.clear();
   glfwDestroyWindow(Window);
   Window = nullptr;
   glfwTerminate();
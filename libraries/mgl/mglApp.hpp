@@ -12,8 +12,12 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/ext.hpp>
+#include <atomic>
 #include <glm/glm.hpp>
 
+#include "./mglDamage.hpp"
+#include "./mglRenderTarget.hpp"
+
 namespace mgl {
 
 class App;
@@ -42,8 +46,26 @@ protected:
 
 ///////////////////////////////////////////////////////////////////////// Engine
 
+// Continuous renders a frame every iteration of the loop. OnDemand renders
+// only after input other than cursor motion, a resize or expose, or a
+// requestRedraw(), and otherwise blocks in glfwWaitEvents, so a static scene
+// costs no CPU between frames, even under a moving mouse.
+enum class RenderMode { Continuous, OnDemand };
+
+struct RunStats {
+  unsigned long long Frames = 0;  // frames rendered
+  unsigned long long Wakeups = 0; // returns from waiting for events
+  double WallSeconds = 0.0;
+  double CpuSeconds = 0.0; // process CPU time, all threads
+  double FenceSeconds = 0.0; // waiting for the GPU to finish older frames
+  double cpuLoad() const { return WallSeconds > 0.0 ? CpuSeconds / WallSeconds : 0.0; }
+};
+
 class Engine {
 public:
+  static const int MaxFramesInFlight = 4;
+  static constexpr float MinRenderScale = 0.25f;
+
   int WindowWidth, WindowHeight;
 
   static Engine &getInstance();
@@ -53,6 +75,51 @@ public:
   void setOpenGL(int major, int minor);
   void setWindow(int width, int height, const char *title, int fullscreen,
                  int vsync);
+  void setRenderMode(RenderMode mode);
+  RenderMode getRenderMode() const;
+  // In OnDemand mode, wake up at least this often even without events
+  // (0 waits indefinitely). A guard against missed wakeups, not a frame rate:
+  // a timeout alone does not render a frame.
+  void setIdleTimeout(double seconds);
+  // Renders one more frame in OnDemand mode. Callable from any thread.
+  void requestRedraw();
+  const RunStats &getRunStats() const;
+  // Keeps the frame in an offscreen canvas that persists between frames, so
+  // the App only clears and redraws the damaged rectangles; the canvas is
+  // copied to the back buffer before every swap. Off, every frame is fully
+  // damaged and cleared by the engine.
+  void setPartialRedraw(bool enabled);
+  bool getPartialRedraw() const;
+  DamageRegion &getDamage();
+  // Renders into the canvas at this fraction (MinRenderScale to 1) of the
+  // window's framebuffer and upscales it with a linear blit when presenting.
+  // Each frame starts with the viewport on the render target; the window
+  // size only describes the final output.
+  void setRenderScale(float scale);
+  float getRenderScale() const;
+  // Render target of the current frame, in pixels.
+  void getRenderSize(int &width, int &height) const;
+  // At most this many frames (1 to MaxFramesInFlight) are queued on the GPU.
+  // A fence follows every swap; before a frame starts, the engine waits on
+  // the fence of the frame that last used its slot.
+  void setFramesInFlight(int frames);
+  int getFramesInFlight() const;
+  // Slot of the frame being recorded, in [0, getFramesInFlight()). The GPU
+  // is done with everything earlier frames of this slot used, so streaming
+  // buffers can keep one region per slot and write without synchronizing.
+  int getFrameIndex() const;
+  unsigned long long getFrameNumber() const;
+  // Waits for the GPU to finish each frame right after its swap, before
+  // input is sampled, so the next frame reacts to the newest input.
+  void setLowLatency(bool enabled);
+  bool getLowLatency() const;
+  // Offscreen targets for the engine and the App; see RenderTargetPool.
+  RenderTargetPool &getTargets();
+  // The render size follows the window only once it has stopped changing
+  // for this long; until then frames keep their targets and are scaled to
+  // the window, so dragging a border does not reallocate every frame.
+  void setResizeDelay(double seconds);
+  double getResizeDelay() const;
   void init();
   void run();
 
@@ -67,12 +134,36 @@ private:
   int GlMajor, GlMinor;
   int Fullscreen;
   int Vsync;
+  RenderMode Mode;
+  double IdleTimeout;
+  std::atomic<bool> Dirty;
+  RunStats Stats;
+  bool PartialRedraw;
+  DamageRegion Damage;
+  RenderTargetPool Targets;
+  RenderTarget *Canvas;
+  float RenderScale;
+  int RenderWidth, RenderHeight;
+  int OutputWidth, OutputHeight;
+  int SettledWidth, SettledHeight; // output size the render size follows
+  int SeenWidth, SeenHeight;       // output size of the last frame
+  double ResizeTime;               // when SeenWidth/Height last changed
+  double ResizeDelay;
+  int FramesInFlight;
+  bool LowLatency;
+  unsigned long long FrameNumber;
+  GLsync Fences[MaxFramesInFlight];
 
   void setupWindow();
   void setupGLFW();
   void setupGLEW();
   void setupOpenGL();
   void setupCallbacks();
+  void beginFrame();
+  void presentFrame();
+  void fenceFrame();
+  void waitForFrame(int slot);
+  void settleSize();
 
 public:
   Engine(Engine const &) = delete;
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Damage Region Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglDamage.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mgl {
+
+/////////////////////////////////////////////////////////////////////// HELPERS
+
+static long long area(const glm::ivec4 &r) {
+  return static_cast<long long>(r.z) * r.w;
+}
+
+static glm::ivec4 unite(const glm::ivec4 &a, const glm::ivec4 &b) {
+  const int x0 = std::min(a.x, b.x), y0 = std::min(a.y, b.y);
+  const int x1 = std::max(a.x + a.z, b.x + b.z);
+  const int y1 = std::max(a.y + a.w, b.y + b.w);
+  return glm::ivec4(x0, y0, x1 - x0, y1 - y0);
+}
+
+static long long overlap(const glm::ivec4 &a, const glm::ivec4 &b) {
+  const long long w = std::min(a.x + a.z, b.x + b.z) - std::max(a.x, b.x);
+  const long long h = std::min(a.y + a.w, b.y + b.w) - std::max(a.y, b.y);
+  return w > 0 && h > 0 ? w * h : 0;
+}
+
+// Pixels redrawn for nothing if a and b are replaced by their union.
+static long long waste(const glm::ivec4 &a, const glm::ivec4 &b) {
+  return area(unite(a, b)) - (area(a) + area(b) - overlap(a, b));
+}
+
+///////////////////////////////////////////////////////////////////////// DAMAGE
+
+void DamageRegion::resize(int width, int height) {
+  if (width == Width && height == Height)
+    return;
+  Width = width;
+  Height = height;
+  addAll();
+}
+
+void DamageRegion::add(const glm::ivec4 &rect) {
+  if (Full)
+    return;
+  const int x0 = std::max(rect.x, 0), y0 = std::max(rect.y, 0);
+  const int x1 = std::min(rect.x + rect.z, Width);
+  const int y1 = std::min(rect.y + rect.w, Height);
+  if (x1 <= x0 || y1 <= y0)
+    return;
+  const glm::ivec4 clipped(x0, y0, x1 - x0, y1 - y0);
+  if (Collapsed) {
+    Rects[0] = unite(Rects[0], clipped);
+    return;
+  }
+  Rects.push_back(clipped);
+  if (Rects.size() == static_cast<size_t>(CollapseAt)) {
+    for (size_t i = 1; i < Rects.size(); i++)
+      Rects[0] = unite(Rects[0], Rects[i]);
+    Rects.resize(1);
+    Collapsed = true;
+  }
+}
+
+void DamageRegion::addClip(const glm::vec2 &min, const glm::vec2 &max) {
+  const float sx = 0.5f * Width, sy = 0.5f * Height;
+  const int x0 = static_cast<int>(std::floor((min.x + 1.0f) * sx)) - 1;
+  const int y0 = static_cast<int>(std::floor((min.y + 1.0f) * sy)) - 1;
+  const int x1 = static_cast<int>(std::ceil((max.x + 1.0f) * sx)) + 1;
+  const int y1 = static_cast<int>(std::ceil((max.y + 1.0f) * sy)) + 1;
+  add(glm::ivec4(x0, y0, x1 - x0, y1 - y0));
+}
+
+void DamageRegion::addAll() {
+  Rects.assign(1, glm::ivec4(0, 0, Width, Height));
+  Full = true;
+}
+
+void DamageRegion::merge() {
+  if (Full)
+    return;
+  for (bool merged = true; merged;) {
+    merged = false;
+    for (size_t i = 0; i < Rects.size() && !merged; i++) {
+      for (size_t j = i + 1; j < Rects.size(); j++) {
+        if (waste(Rects[i], Rects[j]) <= overlap(Rects[i], Rects[j])) {
+          Rects[i] = unite(Rects[i], Rects[j]);
+          Rects.erase(Rects.begin() + j);
+          merged = true;
+          break;
+        }
+      }
+    }
+  }
+  while (Rects.size() > static_cast<size_t>(MaxRects)) {
+    size_t best_i = 0, best_j = 1;
+    long long best = waste(Rects[0], Rects[1]);
+    for (size_t i = 0; i < Rects.size(); i++) {
+      for (size_t j = i + 1; j < Rects.size(); j++) {
+        const long long w = waste(Rects[i], Rects[j]);
+        if (w < best) {
+          best = w;
+          best_i = i;
+          best_j = j;
+        }
+      }
+    }
+    Rects[best_i] = unite(Rects[best_i], Rects[best_j]);
+    Rects.erase(Rects.begin() + best_j);
+  }
+  if (Rects.size() == 1 && area(Rects[0]) == static_cast<long long>(Width) * Height)
+    Full = true;
+}
+
+void DamageRegion::clipBounds(const glm::ivec4 &rect, glm::vec2 &min,
+                              glm::vec2 &max) const {
+  const glm::vec2 scale(2.0f / Width, 2.0f / Height);
+  min = glm::vec2(rect.x, rect.y) * scale - 1.0f;
+  max = glm::vec2(rect.x + rect.z, rect.y + rect.w) * scale - 1.0f;
+}
+
+void DamageRegion::present() {
+  Stats.Frames++;
+  Stats.Rects += Rects.size();
+  for (const glm::ivec4 &r : Rects)
+    Stats.Pixels += area(r);
+  Stats.ScreenPixels += static_cast<unsigned long long>(Width) * Height;
+  Rects.clear();
+  Full = false;
+  Collapsed = false;
+}
+
+DamageStats DamageRegion::collect() {
+  const DamageStats stats = Stats;
+  Stats = DamageStats();
+  return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Damage Region Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_DAMAGE_HPP
+#define MGL_DAMAGE_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace mgl {
+
+class DamageRegion;
+
+/////////////////////////////////////////////////////////////////// DamageStats
+
+struct DamageStats {
+  unsigned long long Frames = 0;
+  unsigned long long Rects = 0;        // merged rectangles redrawn
+  unsigned long long Pixels = 0;       // pixels inside them
+  unsigned long long ScreenPixels = 0; // pixels a full redraw would have filled
+  double redrawn() const {
+    return ScreenPixels ? static_cast<double>(Pixels) / ScreenPixels : 0.0;
+  }
+};
+
+////////////////////////////////////////////////////////////////// DamageRegion
+
+// Pixels that changed since the last presented frame, as a short list of
+// rectangles (x, y, width, height; origin bottom-left). Changes add the old
+// and new screen bounds of whatever moved; merge() coalesces them before
+// the frame clears and redraws inside each rectangle with the scissor test.
+// Merged rectangles may still overlap, so clear and redraw one rectangle at
+// a time: clearing them all first would blend the overlap twice.
+
+class DamageRegion final {
+public:
+  static const int MaxRects = 8;     // rectangles left after merge()
+  // The CollapseAt-th rectangle of a frame collapses them all into one
+  // bounding box, which every later add of the frame grows.
+  static const int CollapseAt = 256;
+
+  void resize(int width, int height);
+  int width() const { return Width; }
+  int height() const { return Height; }
+
+  void add(const glm::ivec4 &rect);
+  // Clip-space box, widened to whole pixels plus one for rasterization rules.
+  void addClip(const glm::vec2 &min, const glm::vec2 &max);
+  void addAll();
+
+  // Joins rectangles whose union wastes no more pixels than it saves in
+  // overlap, then the cheapest pairs until at most MaxRects remain.
+  void merge();
+
+  bool empty() const { return Rects.empty(); }
+  bool full() const { return Full; }
+  const std::vector<glm::ivec4> &rects() const { return Rects; }
+  // The rectangle in clip space, for culling against it.
+  void clipBounds(const glm::ivec4 &rect, glm::vec2 &min,
+                  glm::vec2 &max) const;
+
+  // Adds the current rectangles to the statistics and forgets them.
+  void present();
+  // Statistics since the last call.
+  DamageStats collect();
+
+private:
+  int Width = 0, Height = 0;
+  bool Full = false;
+  bool Collapsed = false; // Rects is one box until present()
+  std::vector<glm::ivec4> Rects;
+  DamageStats Stats;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_DAMAGE_HPP */
@@ -0,0 +1,230 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Render Target Pool Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglRenderTarget.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////// RenderTargetDesc
+
+bool RenderTargetDesc::operator==(const RenderTargetDesc &other) const {
+  return Width == other.Width && Height == other.Height &&
+         Color == other.Color && Depth == other.Depth &&
+         Samples == other.Samples && Sampled == other.Sampled;
+}
+
+// What the driver is likely to allocate per sample; formats it pads (24-bit
+// depth, RGB8) count at their padded size.
+static std::size_t format_bytes(GLenum format) {
+  switch (format) {
+  case GL_NONE:
+    return 0;
+  case GL_R8:
+    return 1;
+  case GL_RG8:
+  case GL_R16F:
+    return 2;
+  case GL_RGBA16F:
+  case GL_RG32F:
+  case GL_DEPTH32F_STENCIL8:
+    return 8;
+  case GL_RGBA32F:
+    return 16;
+  default:
+    return 4;
+  }
+}
+
+////////////////////////////////////////////////////////////// RenderTargetPool
+
+RenderTargetPool::RenderTargetPool() : Frame(0), TrimFrames(120) {}
+
+RenderTargetPool::~RenderTargetPool() {}
+
+void RenderTargetPool::createTarget(RenderTarget &target) {
+  const RenderTargetDesc &desc = target.Desc;
+  const int w = std::max(desc.Width, 1), h = std::max(desc.Height, 1);
+  if (desc.Color != GL_NONE) {
+    if (desc.Sampled) {
+      const GLenum kind =
+          desc.Samples ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+      glGenTextures(1, &target.Color);
+      glBindTexture(kind, target.Color);
+      if (desc.Samples) {
+        glTexStorage2DMultisample(kind, desc.Samples, desc.Color, w, h,
+                                  GL_TRUE);
+      } else {
+        glTexStorage2D(kind, 1, desc.Color, w, h);
+        glTexParameteri(kind, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(kind, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(kind, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(kind, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      }
+      glBindTexture(kind, 0);
+    } else {
+      glGenRenderbuffers(1, &target.Color);
+      glBindRenderbuffer(GL_RENDERBUFFER, target.Color);
+      glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc.Samples,
+                                       desc.Color, w, h);
+    }
+  }
+  if (desc.Depth != GL_NONE) {
+    glGenRenderbuffers(1, &target.Depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, target.Depth);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc.Samples, desc.Depth,
+                                     w, h);
+  }
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  GLint previous = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+  glGenFramebuffers(1, &target.Fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, target.Fbo);
+  if (desc.Color == GL_NONE) {
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+  } else if (desc.Sampled) {
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target.Color,
+                         0);
+  } else {
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, target.Color);
+  }
+  if (desc.Depth != GL_NONE) {
+    const bool stencil = desc.Depth == GL_DEPTH24_STENCIL8 ||
+                         desc.Depth == GL_DEPTH32F_STENCIL8;
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER,
+        stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+        GL_RENDERBUFFER, target.Depth);
+  }
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    destroyTarget(target);
+    throw std::runtime_error("Render target framebuffer is incomplete.");
+  }
+
+  const std::size_t samples = desc.Samples ? desc.Samples : 1;
+  target.Bytes = static_cast<std::size_t>(w) * h * samples *
+                 (format_bytes(desc.Color) + format_bytes(desc.Depth));
+  Stats.Created++;
+}
+
+void RenderTargetPool::destroyTarget(RenderTarget &target) {
+  if (target.Fbo)
+    glDeleteFramebuffers(1, &target.Fbo);
+  if (target.Color) {
+    if (target.Desc.Sampled)
+      glDeleteTextures(1, &target.Color);
+    else
+      glDeleteRenderbuffers(1, &target.Color);
+  }
+  if (target.Depth)
+    glDeleteRenderbuffers(1, &target.Depth);
+  target.Fbo = target.Color = target.Depth = 0;
+  target.Bytes = 0;
+}
+
+RenderTarget *RenderTargetPool::find(const RenderTargetDesc &desc) {
+  for (const std::unique_ptr<RenderTarget> &target : Targets) {
+    if (!target->InUse && target->Desc == desc) {
+      Stats.Reused++;
+      return target.get();
+    }
+  }
+  Targets.push_back(std::make_unique<RenderTarget>());
+  RenderTarget *target = Targets.back().get();
+  target->Desc = desc;
+  try {
+    createTarget(*target);
+  } catch (...) {
+    Targets.pop_back();
+    throw;
+  }
+  return target;
+}
+
+RenderTarget *RenderTargetPool::acquire(const RenderTargetDesc &desc) {
+  RenderTarget *target = find(desc);
+  target->InUse = true;
+  target->Transient = false;
+  target->LastUsed = Frame;
+  return target;
+}
+
+RenderTarget *RenderTargetPool::acquireFrame(const RenderTargetDesc &desc) {
+  RenderTarget *target = acquire(desc);
+  target->Transient = true;
+  return target;
+}
+
+void RenderTargetPool::release(RenderTarget *target) {
+  for (const std::unique_ptr<RenderTarget> &held : Targets) {
+    if (held.get() == target) {
+      target->InUse = false;
+      target->LastUsed = Frame;
+      return;
+    }
+  }
+}
+
+void RenderTargetPool::endFrame(unsigned long long frame) {
+  Frame = frame;
+  for (std::unique_ptr<RenderTarget> &target : Targets) {
+    if (target->InUse) {
+      target->LastUsed = frame;
+      if (target->Transient)
+        target->InUse = false;
+    } else if (frame - target->LastUsed >=
+               static_cast<unsigned long long>(TrimFrames)) {
+      destroyTarget(*target);
+      target.reset();
+      Stats.Trimmed++;
+    }
+  }
+  Targets.erase(std::remove(Targets.begin(), Targets.end(), nullptr),
+                Targets.end());
+}
+
+void RenderTargetPool::setTrimFrames(int frames) {
+  TrimFrames = frames < 1 ? 1 : frames;
+}
+
+int RenderTargetPool::getTrimFrames() const { return TrimFrames; }
+
+void RenderTargetPool::clear() {
+  for (std::unique_ptr<RenderTarget> &target : Targets)
+    destroyTarget(*target);
+  Targets.clear();
+}
+
+std::size_t RenderTargetPool::getBytes() const {
+  std::size_t bytes = 0;
+  for (const std::unique_ptr<RenderTarget> &target : Targets)
+    bytes += target->Bytes;
+  return bytes;
+}
+
+std::size_t RenderTargetPool::getUsedBytes() const {
+  std::size_t bytes = 0;
+  for (const std::unique_ptr<RenderTarget> &target : Targets)
+    if (target->InUse)
+      bytes += target->Bytes;
+  return bytes;
+}
+
+std::size_t RenderTargetPool::getCount() const { return Targets.size(); }
+
+const RenderTargetStats &RenderTargetPool::getStats() const { return Stats; }
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
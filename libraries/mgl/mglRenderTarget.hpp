@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Render Target Pool Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_RENDER_TARGET_HPP
+#define MGL_RENDER_TARGET_HPP
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace mgl {
+
+struct RenderTargetDesc;
+struct RenderTarget;
+struct RenderTargetStats;
+class RenderTargetPool;
+
+////////////////////////////////////////////////////////////// RenderTargetDesc
+
+struct RenderTargetDesc {
+  int Width = 0, Height = 0;
+  GLenum Color = GL_RGBA8;             // GL_NONE for depth only
+  GLenum Depth = GL_DEPTH24_STENCIL8;  // GL_NONE for color only
+  int Samples = 0;                     // 0 is single sampled
+  bool Sampled = false; // color is a texture shaders can read, else a
+                        // renderbuffer for drawing, blitting and readback
+  bool operator==(const RenderTargetDesc &other) const;
+};
+
+////////////////////////////////////////////////////////////////// RenderTarget
+
+struct RenderTarget {
+  RenderTargetDesc Desc;
+  GLuint Fbo = 0;
+  GLuint Color = 0; // texture when Desc.Sampled, renderbuffer otherwise
+  GLuint Depth = 0; // renderbuffer
+  std::size_t Bytes = 0;
+  unsigned long long LastUsed = 0;
+  bool InUse = false;
+  bool Transient = false;
+};
+
+///////////////////////////////////////////////////////////// RenderTargetStats
+
+struct RenderTargetStats {
+  unsigned long long Created = 0;
+  unsigned long long Reused = 0;
+  unsigned long long Trimmed = 0;
+};
+
+////////////////////////////////////////////////////////////// RenderTargetPool
+
+// Framebuffers keyed by size, formats and samples. acquire() hands out a
+// free target with the same description or creates one; release() returns
+// it to the pool instead of deleting it, so passes that come and go (a
+// canvas toggled on and off, a cache resized back and forth) reuse their
+// memory. acquireFrame() targets go back by themselves at endFrame(). Free
+// targets unused for getTrimFrames() frames are deleted.
+
+class RenderTargetPool final {
+public:
+  RenderTargetPool();
+  ~RenderTargetPool();
+
+  RenderTargetPool(const RenderTargetPool &) = delete;
+  RenderTargetPool &operator=(const RenderTargetPool &) = delete;
+
+  // Pointers stay valid until release(), endFrame() for frame targets, or
+  // clear(). Leaves the current framebuffer binding alone.
+  RenderTarget *acquire(const RenderTargetDesc &desc);
+  RenderTarget *acquireFrame(const RenderTargetDesc &desc);
+  // Ignores targets the pool no longer holds (after clear()) and nullptr.
+  void release(RenderTarget *target);
+
+  // Called by the engine after every frame.
+  void endFrame(unsigned long long frame);
+  void setTrimFrames(int frames);
+  int getTrimFrames() const;
+  // Deletes every target, in use or not. Needs the context still current.
+  void clear();
+
+  std::size_t getBytes() const;     // GPU memory of every target held
+  std::size_t getUsedBytes() const; // of the targets handed out
+  std::size_t getCount() const;
+  const RenderTargetStats &getStats() const;
+
+private:
+  std::vector<std::unique_ptr<RenderTarget>> Targets;
+  unsigned long long Frame;
+  int TrimFrames;
+  RenderTargetStats Stats;
+
+  RenderTarget *find(const RenderTargetDesc &desc);
+  void createTarget(RenderTarget &target);
+  void destroyTarget(RenderTarget &target);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_RENDER_TARGET_HPP */
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Stream Buffer Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "./mglStreamBuffer.hpp"
+
+#include <stdexcept>
+
+#include "./mglApp.hpp"
+
+namespace mgl {
+
+////////////////////////////////////////////////////////////////// StreamBuffer
+
+static const GLsizeiptr ALIGNMENT = 256;
+
+StreamBuffer::StreamBuffer()
+    : Buffer(0), Region(0), Cursor(0), Frame(~0ull), Mapped(nullptr) {}
+
+StreamBuffer::~StreamBuffer() {
+  if (Buffer)
+    glDeleteBuffers(1, &Buffer);
+}
+
+void StreamBuffer::createStorage(GLsizeiptr region_bytes) {
+  if (Buffer)
+    glDeleteBuffers(1, &Buffer);
+  Region = (region_bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  const GLbitfield flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  const GLsizeiptr size = Region * Engine::MaxFramesInFlight;
+  glGenBuffers(1, &Buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, Buffer);
+  glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+  Mapped = static_cast<char *>(
+      glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  if (!Mapped) {
+    throw std::runtime_error("Failed to map stream buffer.");
+  }
+}
+
+void StreamBuffer::create(GLsizeiptr region_bytes) {
+  createStorage(region_bytes);
+}
+
+void *StreamBuffer::allocate(GLsizeiptr bytes, GLintptr &offset) {
+  const Engine &engine = Engine::getInstance();
+  if (engine.getFrameNumber() != Frame) {
+    Frame = engine.getFrameNumber();
+    Cursor = 0;
+  }
+  const GLsizeiptr aligned = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  if (Cursor + aligned > Region) {
+    GLsizeiptr region = Region ? Region : ALIGNMENT;
+    while (region < Cursor + aligned)
+      region *= 2;
+    createStorage(region);
+    Cursor = 0;
+  }
+  offset = engine.getFrameIndex() * Region + Cursor;
+  Cursor += aligned;
+  return Mapped + offset;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
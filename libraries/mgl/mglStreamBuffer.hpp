@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Stream Buffer Class
+//
+// Copyright (c)2022-25 by Carlos Martinho
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef MGL_STREAM_BUFFER_HPP
+#define MGL_STREAM_BUFFER_HPP
+
+#include <GL/glew.h>
+
+namespace mgl {
+
+class StreamBuffer;
+
+////////////////////////////////////////////////////////////////// StreamBuffer
+
+// Persistently mapped buffer for data written by the CPU every frame, with
+// one region per frame in flight. The engine fences every frame and waits on
+// a slot's fence before the next frame of that slot starts, so the region of
+// Engine::getFrameIndex() is never read by the GPU while it is written:
+// no orphaning, no glBufferSubData copies, no implicit synchronization.
+
+class StreamBuffer final {
+public:
+  StreamBuffer();
+  ~StreamBuffer();
+
+  StreamBuffer(const StreamBuffer &) = delete;
+  StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+  void create(GLsizeiptr region_bytes);
+  // Room for bytes in the current frame's region; offset receives where it
+  // starts in getBuffer(). A full region moves the stream to a new, larger
+  // buffer (GL keeps the old one alive until its draws are done), so bind
+  // getBuffer() after every allocate.
+  void *allocate(GLsizeiptr bytes, GLintptr &offset);
+  GLuint getBuffer() const { return Buffer; }
+
+private:
+  GLuint Buffer;
+  GLsizeiptr Region;
+  GLintptr Cursor;
+  unsigned long long Frame;
+  char *Mapped;
+
+  void createStorage(GLsizeiptr region_bytes);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+} // namespace mgl
+
+#endif /* MGL_STREAM_BUFFER_HPP */